@@ -0,0 +1,198 @@
+// Fused ops: pairs of adjacent instructions merged by the fusion pass
+// (rvi_fusion.hpp). Each op has the architectural effect of both
+// instructions and advances pc by 8. They have no encoding of their own, so
+// kOpcode is 0, which no decode group uses.
+//
+// Field use: rd is the destination of the first instruction, rs3 the
+// destination of the second one, imm is the combined immediate.
+#pragma once
+
+#include <cstdint>
+
+#include "rvi_decode_info.hpp"
+#include "rvi_instruction_interface.hpp"
+#include "rvi_instruction_registry.hpp"
+
+namespace rvi {
+namespace fused {
+
+constexpr uint32_t kFusedOpcode = 0u;
+
+// Upper part of a %hi/%lo split offset: hi is a multiple of 4096 and
+// offset - hi fits a 12-bit signed immediate.
+constexpr uint32_t HiPart(int32_t offset) {
+    return (static_cast<uint32_t>(offset) + 0x800u) & ~0xFFFu;
+}
+
+// lui rd, %hi(c); addi rd, rd, %lo(c)
+// imm = c
+class LuiAddi final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kFusedOpcode;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        state->regs.Set(info.rd, static_cast<uint32_t>(info.imm));
+
+        state->pc += 8u;
+    }
+
+    const char* GetName()   const override { return "lui+addi"; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+// auipc rd, %hi(off); jalr rs3, %lo(off)(rd)
+// imm = off
+class AuipcJalr final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kFusedOpcode;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        state->regs.Set(info.rd, state->pc + HiPart(info.imm));
+
+        uint32_t addr = (state->pc + static_cast<uint32_t>(info.imm)) & ~1u;
+        state->regs.Set(info.rs3, state->pc + 8u);
+
+        state->pc = addr;
+    }
+
+    const char* GetName()   const override { return "auipc+jalr"; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+// auipc rd, %hi(off); lw rs3, %lo(off)(rd)
+// imm = off
+class AuipcLw final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kFusedOpcode;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        const uint32_t pc = state->pc;
+        state->regs.Set(info.rd, pc + HiPart(info.imm));
+
+        // A fault in the load is the lw's.
+        state->pc = pc + 4u;
+        auto value = state->memory.Get<uint32_t>(pc + static_cast<uint32_t>(info.imm));
+        state->regs.Set(info.rs3, value);
+
+        state->pc += 4u;
+    }
+
+    const char* GetName()   const override { return "auipc+lw"; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+// slli rd, rs1, imm; add rs3, rd, rs2 (either operand order)
+class SlliAdd final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kFusedOpcode;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        uint32_t shifted = state->regs.Get(info.rs1) << (static_cast<uint32_t>(info.imm) & 0x1Fu);
+        state->regs.Set(info.rd, shifted);
+
+        // rs2 may be rd itself, so it is read after the first write
+        state->regs.Set(info.rs3, shifted + state->regs.Get(info.rs2));
+
+        state->pc += 8u;
+    }
+
+    const char* GetName()   const override { return "slli+add"; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+// slt[u] rd, rs1, rs2; bnez/beqz rd, target
+// imm = target - pc of the slt
+template <class Oper>
+class SetBranch final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kFusedOpcode;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        auto lhs = static_cast<typename Oper::type>(state->regs.Get(info.rs1));
+        auto rhs = static_cast<typename Oper::type>(state->regs.Get(info.rs2));
+
+        const bool is_set = lhs < rhs;
+        state->regs.Set(info.rd, is_set ? 1u : 0u);
+
+        if (is_set == Oper::branch_if_set) {
+            state->pc += static_cast<uint32_t>(info.imm);
+        }
+        else {
+            state->pc += 8u;
+        }
+    }
+
+    const char* GetName()   const override { return Oper::name; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+namespace {
+
+struct SltBnezOper {
+    using type = int32_t;
+    static constexpr bool branch_if_set = true;
+    static constexpr const char* const name = "slt+bnez";
+};
+
+struct SltBeqzOper {
+    using type = int32_t;
+    static constexpr bool branch_if_set = false;
+    static constexpr const char* const name = "slt+beqz";
+};
+
+struct SltuBnezOper {
+    using type = uint32_t;
+    static constexpr bool branch_if_set = true;
+    static constexpr const char* const name = "sltu+bnez";
+};
+
+struct SltuBeqzOper {
+    using type = uint32_t;
+    static constexpr bool branch_if_set = false;
+    static constexpr const char* const name = "sltu+beqz";
+};
+
+} // namespace
+
+using SltBnez  = SetBranch<SltBnezOper>;
+using SltBeqz  = SetBranch<SltBeqzOper>;
+using SltuBnez = SetBranch<SltuBnezOper>;
+using SltuBeqz = SetBranch<SltuBeqzOper>;
+
+} // namespace fused
+} // namespace rvi
@@ -0,0 +1,205 @@
+// R-type atomic memory operations on words (extension A)
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "rvi_decode_info.hpp"
+#include "rvi_instruction_interface.hpp"
+#include "rvi_instruction_registry.hpp"
+
+namespace rvi {
+namespace rv32a {
+
+constexpr uint32_t kOpcodeAmo = 0x2Fu;
+constexpr uint32_t kFunct3Word = 0b010u;
+
+// The aq and rl bits below funct5 are ignored: every atomic access is
+// sequentially consistent.
+constexpr uint8_t Funct7(uint32_t funct5) {
+    return static_cast<uint8_t>(funct5 << 2);
+}
+
+class LrW final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kOpcodeAmo;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        const uint32_t address = state->regs.Get(info.rs1);
+        const uint32_t value = state->memory.AtomicLoad(address);
+        state->reservation = {true, address, value};
+        state->regs.Set(info.rd, value);
+        state->pc += 4u;
+    }
+
+    const char* GetName()   const override { return "lr.w"; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = kFunct3Word,
+        .funct7 = Funct7(0b00010u),
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+class ScW final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kOpcodeAmo;
+
+    // rd is 0 on success, 1 on failure; either way the reservation is gone.
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        const uint32_t address = state->regs.Get(info.rs1);
+        const Reservation reservation = state->reservation;
+        state->reservation.valid = false;
+
+        const bool stored = reservation.valid && reservation.address == address &&
+                            state->memory.CompareExchange(address, reservation.value,
+                                                          state->regs.Get(info.rs2));
+        state->regs.Set(info.rd, stored ? 0u : 1u);
+        state->pc += 4u;
+    }
+
+    const char* GetName()   const override { return "sc.w"; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = kFunct3Word,
+        .funct7 = Funct7(0b00011u),
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+template <class Oper>
+class InstructionAmo final : public IInstruction {
+public:
+    static constexpr uint32_t kOpcode = kOpcodeAmo;
+
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        const uint32_t operand = state->regs.Get(info.rs2);
+        const uint32_t old = state->memory.AtomicUpdate(
+            state->regs.Get(info.rs1), [operand](uint32_t value) { return Oper::exec(value, operand); });
+        state->regs.Set(info.rd, old);
+        state->pc += 4u;
+    }
+
+    const char* GetName()   const override { return Oper::name; }
+    uint32_t    GetOpcode() const override { return kOpcode; }
+
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = kFunct3Word,
+        .funct7 = Funct7(Oper::funct5),
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
+};
+
+struct AmoswapOp {
+    constexpr static const char* const name = "amoswap.w";
+    static uint32_t exec(uint32_t /*old*/, uint32_t value) {
+        return value;
+    }
+    static constexpr uint32_t funct5 = 0b00001u;
+};
+
+struct AmoaddOp {
+    constexpr static const char* const name = "amoadd.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return old + value;
+    }
+    static constexpr uint32_t funct5 = 0b00000u;
+};
+
+struct AmoxorOp {
+    constexpr static const char* const name = "amoxor.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return old ^ value;
+    }
+    static constexpr uint32_t funct5 = 0b00100u;
+};
+
+struct AmoandOp {
+    constexpr static const char* const name = "amoand.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return old & value;
+    }
+    static constexpr uint32_t funct5 = 0b01100u;
+};
+
+struct AmoorOp {
+    constexpr static const char* const name = "amoor.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return old | value;
+    }
+    static constexpr uint32_t funct5 = 0b01000u;
+};
+
+struct AmominOp {
+    constexpr static const char* const name = "amomin.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return static_cast<uint32_t>(std::min(static_cast<int32_t>(old), static_cast<int32_t>(value)));
+    }
+    static constexpr uint32_t funct5 = 0b10000u;
+};
+
+struct AmomaxOp {
+    constexpr static const char* const name = "amomax.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return static_cast<uint32_t>(std::max(static_cast<int32_t>(old), static_cast<int32_t>(value)));
+    }
+    static constexpr uint32_t funct5 = 0b10100u;
+};
+
+struct AmominuOp {
+    constexpr static const char* const name = "amominu.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return std::min(old, value);
+    }
+    static constexpr uint32_t funct5 = 0b11000u;
+};
+
+struct AmomaxuOp {
+    constexpr static const char* const name = "amomaxu.w";
+    static uint32_t exec(uint32_t old, uint32_t value) {
+        return std::max(old, value);
+    }
+    static constexpr uint32_t funct5 = 0b11100u;
+};
+
+using AmoswapW = InstructionAmo<AmoswapOp>;
+using AmoaddW  = InstructionAmo<AmoaddOp>;
+using AmoxorW  = InstructionAmo<AmoxorOp>;
+using AmoandW  = InstructionAmo<AmoandOp>;
+using AmoorW   = InstructionAmo<AmoorOp>;
+using AmominW  = InstructionAmo<AmominOp>;
+using AmomaxW  = InstructionAmo<AmomaxOp>;
+using AmominuW = InstructionAmo<AmominuOp>;
+using AmomaxuW = InstructionAmo<AmomaxuOp>;
+
+namespace {
+
+constexpr uint32_t kFunct3Bits = 3u;
+constexpr uint32_t kFunct5Bits = 5u;
+constexpr uint32_t kFunct3Mask = (1u << kFunct3Bits) - 1u;
+constexpr size_t   kOpcodeGroupKeySpace = 1u << (kFunct5Bits + kFunct3Bits);
+
+// funct5 and funct3, without aq and rl.
+constexpr uint32_t KeyTypeR_Amo(const MicroOp& info) {
+    return (static_cast<uint32_t>(info.funct7 >> 2) << kFunct3Bits) | (info.funct3 & kFunct3Mask);
+}
+
+} // namespace
+
+using OpcodeGroupTypeR_Amo =
+    rvi::OpcodeGroup<kOpcodeAmo, kOpcodeGroupKeySpace, &KeyTypeR_Amo, &DecodeInstructionTypeR>;
+
+} // namespace rv32a
+} // namespace rvi
@@ -1,11 +0,0 @@
-#pragma once
-
-#include "rvi_instruction_registry.hpp"
-
-namespace rvi {
-namespace rv32f {
-
-void RegisterRV32F(InstructionRegistry* registry);
-
-} // namespace rv32f
-} // namespace rvi
@@ -7,7 +7,6 @@
 #include <cmath>
 #include <cstdint>
 #include <limits>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -126,32 +125,27 @@ class InstructionTypeRF final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x53u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeR>(decoded_info);
-
-        ScopedRoundingMode guard(info.funct7 & 0x03);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
+        ScopedRoundingMode guard(info.funct7 & 0x03u);
         Oper::exec(state, info);
 
         DLOG_F(INFO, "HUI %s(%f, %f) = %f", Oper::name, state->f_regs.Get(info.rs1), state->f_regs.Get(info.rs2), state->f_regs.Get(info.rd));
 
         state->pc += 4u;
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeR info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-            .rs2    = Oper::rs2 == 0b111111 ? 0 : Oper::rs2,
-            .funct7 = Oper::funct7,
-        };
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .rs2    = Oper::rs2 == 0b111111 ? 0 : Oper::rs2,
+        .funct3 = Oper::funct3,
+        .funct7 = Oper::funct7,
+    };
 
-        return info;
-    }
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 struct FAddSOper {
@@ -160,7 +154,7 @@ struct FAddSOper {
     constexpr static uint32_t funct3 = 0b111;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -174,7 +168,7 @@ struct FSubSOper {
     constexpr static uint32_t funct3 = 0b111;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -188,7 +182,7 @@ struct FMulSOper {
     constexpr static uint32_t funct3 = 0b111;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -202,7 +196,7 @@ struct FDivSOper {
     constexpr static uint32_t funct3 = 0b111;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -216,7 +210,7 @@ struct FSqrtSOper {
     constexpr static uint32_t funct3 = 0b111;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float value = state->f_regs.Get(info.rs1);
 
         state->f_regs.Set(info.rd, std::sqrt(value));
@@ -229,7 +223,7 @@ struct FSgnjSOper {
     constexpr static uint32_t funct3 = 0b000u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -243,7 +237,7 @@ struct FSgnjnSOper {
     constexpr static uint32_t funct3 = 0b001u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         float       rhs = state->f_regs.Get(info.rs2);
 
@@ -259,7 +253,7 @@ struct FSgnjxSOper {
     constexpr static uint32_t funct3 = 0b010u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t lhs_bits = std::bit_cast<uint32_t>(state->f_regs.Get(info.rs1));
         const uint32_t rhs_bits = std::bit_cast<uint32_t>(state->f_regs.Get(info.rs2));
 
@@ -276,7 +270,7 @@ struct FMinSOper {
     constexpr static uint32_t funct3 = 0b000u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -290,7 +284,7 @@ struct FMaxSOper {
     constexpr static uint32_t funct3 = 0b001u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -304,7 +298,7 @@ struct FEqSOper {
     constexpr static uint32_t funct3 = 0b010u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -320,7 +314,7 @@ struct FLtSOper {
     constexpr static uint32_t funct3 = 0b001u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -336,7 +330,7 @@ struct FLeSOper {
     constexpr static uint32_t funct3 = 0b000u;
     constexpr static uint32_t rs2 = 0b111111;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
 
@@ -352,7 +346,7 @@ struct FCvtWSOper {
     constexpr static uint32_t funct3 = 0b111;
     constexpr static uint32_t rs2 = 0b00000;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float   value = state->f_regs.Get(info.rs1);
         const int32_t result = ConvertFloatToInt<int32_t>(value);
 
@@ -366,7 +360,7 @@ struct FCvtWUSOper {
     constexpr static uint32_t funct3 = 111u;
     constexpr static uint32_t rs2 = 0b00001;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float    value = state->f_regs.Get(info.rs1);
         const uint32_t result = ConvertFloatToInt<uint32_t>(value);
 
@@ -380,7 +374,7 @@ struct FCvtSWOper {
     constexpr static uint32_t funct3 = 111u;
     constexpr static uint32_t rs2 = 0b00000;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const int32_t value = static_cast<int32_t>(state->regs.Get(info.rs1));
 
         state->f_regs.Set(info.rd, static_cast<float>(value));
@@ -393,7 +387,7 @@ struct FCvtSWUOper {
     constexpr static uint32_t funct3 = 111u;
     constexpr static uint32_t rs2 = 0b00001;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
 
         state->f_regs.Set(info.rd, static_cast<float>(value));
@@ -406,7 +400,7 @@ struct FClassSOper {
     constexpr static uint32_t funct3 = 0b001u;
     constexpr static uint32_t rs2 = 0b00000;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float value = state->f_regs.Get(info.rs1);
 
         state->regs.Set(info.rd, ClassifyFloat(value));
@@ -419,7 +413,7 @@ struct FMvXWOper {
     constexpr static uint32_t funct3 = 0b000u;
     constexpr static uint32_t rs2 = 0b00000;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const float value = state->f_regs.Get(info.rs1);
 
         state->regs.Set(info.rd, std::bit_cast<uint32_t>(value));
@@ -432,7 +426,7 @@ struct FMvWXOper {
     constexpr static uint32_t funct3 = 0b000u;
     constexpr static uint32_t rs2 = 0b00000;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeR& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
 
         state->f_regs.Set(info.rd, std::bit_cast<float>(value));
@@ -462,29 +456,6 @@ using FMvWX   = InstructionTypeRF<FMvWXOper>;
 
 namespace {
 
-inline void RegisterInstructionsTypeR_Float(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<FAddS>());
-    registry->RegisterInstruction(std::make_unique<FSubS>());
-    registry->RegisterInstruction(std::make_unique<FMulS>());
-    registry->RegisterInstruction(std::make_unique<FDivS>());
-    registry->RegisterInstruction(std::make_unique<FSqrtS>());
-    registry->RegisterInstruction(std::make_unique<FSgnjS>());
-    registry->RegisterInstruction(std::make_unique<FSgnjnS>());
-    registry->RegisterInstruction(std::make_unique<FSgnjxS>());
-    registry->RegisterInstruction(std::make_unique<FMinS>());
-    registry->RegisterInstruction(std::make_unique<FMaxS>());
-    registry->RegisterInstruction(std::make_unique<FEqS>());
-    registry->RegisterInstruction(std::make_unique<FLtS>());
-    registry->RegisterInstruction(std::make_unique<FLeS>());
-    registry->RegisterInstruction(std::make_unique<FCvtWS>());
-    registry->RegisterInstruction(std::make_unique<FCvtWUS>());
-    registry->RegisterInstruction(std::make_unique<FCvtSW>());
-    registry->RegisterInstruction(std::make_unique<FCvtSWU>());
-    registry->RegisterInstruction(std::make_unique<FClassS>());
-    registry->RegisterInstruction(std::make_unique<FMvXW>());
-    registry->RegisterInstruction(std::make_unique<FMvWX>());
-}
-
 constexpr uint32_t kFunct3Bits = 3u;
 constexpr uint32_t kFunct7Bits = 7u;
 constexpr uint32_t kRs2Bits = 5u;
@@ -493,12 +464,10 @@ constexpr uint32_t kFunct7Mask = (1u << kFunct7Bits) - 1u;
 constexpr uint32_t kRs2Mask = (1u << kRs2Bits) - 1u;
 constexpr size_t   kOpcodeGroupKeySpace = 32u;
 
-inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
-    const auto& r = std::get<InstructionDecodedInfoTypeR>(info);
-
+constexpr uint32_t KeyTypeR_Float(const MicroOp& info) {
     // well at least its memory efficient 
     // FIXME: remove
-    switch (r.funct7 & kFunct7Mask) {
+    switch (info.funct7 & kFunct7Mask) {
         // 0: fadd.s
         case 0b0000000u:
             return 0u;
@@ -521,7 +490,7 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
         // 5–7: fsgnj.s / fsgnjn.s / fsgnjx.s  (distinguish by funct3)
         case 0b0010000u:
-            switch (r.funct3 & kFunct3Mask) {
+            switch (info.funct3 & kFunct3Mask) {
                 // 5: fsgnj.s
                 case 0b000u: return 5u;
                 // 6: fsgnjn.s
@@ -534,7 +503,7 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
         // 8–9: fmin.s / fmax.s  (distinguish by funct3)
         case 0b0010100u:
-            switch (r.funct3 & kFunct3Mask) {
+            switch (info.funct3 & kFunct3Mask) {
                 // 8: fmin.s
                 case 0b000u: return 8u;
                 // 9: fmax.s
@@ -545,7 +514,7 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
         // 10–12: feq.s / flt.s / fle.s  (distinguish by funct3)
         case 0b1010000u:
-            switch (r.funct3 & kFunct3Mask) {
+            switch (info.funct3 & kFunct3Mask) {
                 // 12: fle.s
                 case 0b000u: return 12u;
                 // 11: flt.s
@@ -558,7 +527,7 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
         // 13–14: fcvt.w.s / fcvt.wu.s  (distinguish by rs2)
         case 0b1100000u:
-            switch (r.rs2 & kRs2Mask) {
+            switch (info.rs2 & kRs2Mask) {
                 // 13: fcvt.w.s
                 case 0b00000u: return 13u;
                 // 14: fcvt.wu.s
@@ -569,7 +538,7 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
         // 15–16: fcvt.s.w / fcvt.s.wu  (distinguish by rs2)
         case 0b1101000u:
-            switch (r.rs2 & kRs2Mask) {
+            switch (info.rs2 & kRs2Mask) {
                 // 15: fcvt.s.w
                 case 0b00000u: return 15u;
                 // 16: fcvt.s.wu
@@ -580,7 +549,7 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
         // 17–18: fclass.s / fmv.x.w  (distinguish by funct3)
         case 0b1110000u:
-            switch (r.funct3 & kFunct3Mask) {
+            switch (info.funct3 & kFunct3Mask) {
                 // 18: fmv.x.w
                 case 0b000u: return 18u;
                 // 17: fclass.s
@@ -603,13 +572,8 @@ inline uint32_t KeyTypeR_Float(InstructionDecodedCommonType info) {
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeR_Float(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(kOpcodeGroupKeySpace, &KeyTypeR_Float, &DecodeInstructionToCommonTypeR),
-        FAddS::kOpcode);
-
-    RegisterInstructionsTypeR_Float(registry);
-}
+using OpcodeGroupTypeR_Float =
+    rvi::OpcodeGroup<FAddS::kOpcode, kOpcodeGroupKeySpace, &KeyTypeR_Float, &DecodeInstructionTypeR>;
 
 } // namespace rv32f
 } // namespace rvi
@@ -2,7 +2,6 @@
 
 #include <cmath>
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,10 +15,8 @@ class InstructionTypeR4 final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = Oper::opcode;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeR4>(decoded_info);
-
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         const float lhs = state->f_regs.Get(info.rs1);
         const float rhs = state->f_regs.Get(info.rs2);
         const float acc = state->f_regs.Get(info.rs3);
@@ -28,26 +25,22 @@ public:
 
         state->f_regs.Set(info.rd, result);
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName() const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeR4 info = {
-            .opcode = kOpcode,
-            .rd = 0u,
-            .rm = Oper::rm,
-            .rs1 = 0u,
-            .rs2 = 0u,
-            .rs3 = 0u,
-            .fmt = Oper::fmt,
-        };
-
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .rd     = 0u,
+        .rs1    = 0u,
+        .rs2    = 0u,
+        .rs3    = 0u,
+        .funct3 = Oper::rm,
+        .funct7 = Oper::fmt,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 struct FmaddSOper {
@@ -101,59 +94,23 @@ using FnmsubS = InstructionTypeR4<FnmsubSOper>;
 
 namespace {
 
-inline void RegisterInstructionsTypeR4_Fmadd(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<FmaddS>());
-}
-
-inline void RegisterInstructionsTypeR4_Fmsub(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<FmsubS>());
-}
-
-inline void RegisterInstructionsTypeR4_Fnmadd(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<FnmaddS>());
-}
-
-inline void RegisterInstructionsTypeR4_Fnmsub(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<FnmsubS>());
-}
-
-inline uint32_t KeyTypeR4_Fma(InstructionDecodedCommonType /*info*/) {
+constexpr uint32_t KeyTypeR4_Fma(const MicroOp& /*info*/) {
     return 0u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeR4_Fmadd(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionToCommonTypeR4),
-        FmaddS::kOpcode);
-
-    RegisterInstructionsTypeR4_Fmadd(registry);
-}
+using OpcodeGroupTypeR4_Fmadd =
+    rvi::OpcodeGroup<FmaddS::kOpcode, /*key_space*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionTypeR4>;
 
-inline void RegisterOpcodeGroupTypeR4_Fmsub(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionToCommonTypeR4),
-        FmsubS::kOpcode);
-
-    RegisterInstructionsTypeR4_Fmsub(registry);
-}
+using OpcodeGroupTypeR4_Fmsub =
+    rvi::OpcodeGroup<FmsubS::kOpcode, /*key_space*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionTypeR4>;
 
-inline void RegisterOpcodeGroupTypeR4_Fnmadd(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionToCommonTypeR4),
-        FnmaddS::kOpcode);
+using OpcodeGroupTypeR4_Fnmadd =
+    rvi::OpcodeGroup<FnmaddS::kOpcode, /*key_space*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionTypeR4>;
 
-    RegisterInstructionsTypeR4_Fnmadd(registry);
-}
-
-inline void RegisterOpcodeGroupTypeR4_Fnmsub(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionToCommonTypeR4),
-        FnmsubS::kOpcode);
-
-    RegisterInstructionsTypeR4_Fnmsub(registry);
-}
+using OpcodeGroupTypeR4_Fnmsub =
+    rvi::OpcodeGroup<FnmsubS::kOpcode, /*key_space*/ 1u, &KeyTypeR4_Fma, &DecodeInstructionTypeR4>;
 
 } // namespace rv32f
 } // namespace rvi
@@ -3,7 +3,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,10 +15,8 @@ class Fsw final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x27u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeS>(decoded_info);
-
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         uint32_t addr = static_cast<uint32_t>(
             static_cast<int32_t>(state->regs.Get(info.rs1)) + info.imm
         );
@@ -28,41 +25,29 @@ public:
         state->memory.Set<float>(addr, value);
 
         state->pc += 4u;
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return "fsw"; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeS info = {
-            .opcode = kOpcode,
-            .funct3 = 0b010u,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = 0b010u,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
 
-inline void RegisterInstructionsTypeS_Fsw(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Fsw>());
-}
-
-inline uint32_t KeyTypeS_Fsw(InstructionDecodedCommonType /*info*/) {
+constexpr uint32_t KeyTypeS_Fsw(const MicroOp& /*info*/) {
     return 0u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeS_Fsw(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeS_Fsw, &DecodeInstructionToCommonTypeS),
-        Fsw::kOpcode
-    );
-
-    RegisterInstructionsTypeS_Fsw(registry);
-}
+using OpcodeGroupTypeS_Fsw =
+    rvi::OpcodeGroup<Fsw::kOpcode, /*key_space*/ 1u, &KeyTypeS_Fsw, &DecodeInstructionTypeS>;
 
 } // namespace rv32f
 } // namespace rvi
@@ -1,11 +0,0 @@
-#pragma once
-
-#include "rvi_instruction_registry.hpp"
-
-namespace rvi {
-namespace rv32i {
-
-void RegisterRV32I(InstructionRegistry* registry);
-
-} // namespace rv32i
-} // namespace rvi
@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,10 +15,8 @@ class Branch final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x63u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeB>(decoded_info);
-
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         auto lhs = static_cast<typename Oper::type>(state->regs.Get(info.rs1));
         auto rhs = static_cast<typename Oper::type>(state->regs.Get(info.rs2));
 
@@ -32,21 +29,17 @@ public:
         else {
             state->pc += 4u;
         }
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeB info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-        };
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+    };
 
-        return info;
-    }
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
@@ -100,29 +93,14 @@ using Bge  = Branch<BgeOper>;
 using Bltu = Branch<BltuOper>;
 using Bgeu = Branch<BgeuOper>;
 
-inline void RegisterInstructionsTypeB(InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Beq> ());
-    registry->RegisterInstruction(std::make_unique<Bne> ());
-    registry->RegisterInstruction(std::make_unique<Blt> ());
-    registry->RegisterInstruction(std::make_unique<Bge> ());
-    registry->RegisterInstruction(std::make_unique<Bltu>());
-    registry->RegisterInstruction(std::make_unique<Bgeu>()); 
-}
-
-inline uint32_t KeyTypeB_Branch(InstructionDecodedCommonType info) {
-    auto b = std::get<InstructionDecodedInfoTypeB>(info);
-    return b.funct3 & 0x7u;
+constexpr uint32_t KeyTypeB_Branch(const MicroOp& info) {
+    return info.funct3 & 0x7u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeB_Branch(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 8u, &KeyTypeB_Branch, &DecodeInstructionToCommonTypeB),
-        0x63u);
-
-    RegisterInstructionsTypeB(registry);
-}
+using OpcodeGroupTypeB_Branch =
+    rvi::OpcodeGroup<0x63u, /*key_space*/ 8u, &KeyTypeB_Branch, &DecodeInstructionTypeB>;
 
 } // namespace rv32i
 } // namespace rvi
@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -18,10 +17,8 @@ class Arithm final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x13u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeI>(decoded_info);
-
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         using lhs_type = typename Oper::value_type;
         using rhs_type = typename Oper::imm_type;
 
@@ -31,22 +28,18 @@ public:
         auto result = Oper::exec(lhs, rhs);
         state->regs.Set(info.rd, static_cast<uint32_t>(result));
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeI info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-            .imm = Oper::imm,
-        };
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+        .imm = Oper::imm,
+    };
 
-        return info;
-    }
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
@@ -56,7 +49,7 @@ struct AddiOper {
     using imm_type = int32_t;
     constexpr static const char* const name = "addi";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return info.imm;
     }
 
@@ -73,7 +66,7 @@ struct StliOper {
     using imm_type = int32_t;
     constexpr static const char* const name = "stli";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return info.imm;
     }
 
@@ -90,7 +83,7 @@ struct StliuOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "stliu";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm);
     }
 
@@ -107,7 +100,7 @@ struct XoriOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "xori";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm);
     }
 
@@ -124,7 +117,7 @@ struct AndiOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "andi";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm);
     }
 
@@ -141,7 +134,7 @@ struct OriOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "ori";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm);
     }
 
@@ -158,7 +151,7 @@ struct SlliOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "slli";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm) & 0x1Fu;
     }
 
@@ -175,7 +168,7 @@ struct SrliOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "srli";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm) & 0x1Fu;
     }
 
@@ -192,7 +185,7 @@ struct SraiOper {
     using imm_type = uint32_t;
     constexpr static const char* const name = "srai";
 
-    static imm_type GetImm(const InstructionDecodedInfoTypeI& info) {
+    static imm_type GetImm(const MicroOp& info) {
         return static_cast<uint32_t>(info.imm) & 0x1Fu;
     }
 
@@ -214,23 +207,10 @@ using Stliu = Arithm<StliuOper>;
 using Stli  = Arithm<StliOper>;
 using Addi  = Arithm<AddiOper>;
 
-inline void RegisterInstructionsTypeI_Arithm(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Srai> ()); 
-    registry->RegisterInstruction(std::make_unique<Srli> ()); 
-    registry->RegisterInstruction(std::make_unique<Slli> ()); 
-    registry->RegisterInstruction(std::make_unique<Ori>  ());  
-    registry->RegisterInstruction(std::make_unique<Andi> ()); 
-    registry->RegisterInstruction(std::make_unique<Xori> ()); 
-    registry->RegisterInstruction(std::make_unique<Stliu>());
-    registry->RegisterInstruction(std::make_unique<Stli> ()); 
-    registry->RegisterInstruction(std::make_unique<Addi> ());
-}
-
-inline uint32_t KeyTypeI_Arithm(InstructionDecodedCommonType info) {
+constexpr uint32_t KeyTypeI_Arithm(const MicroOp& info) {
     // FIXME: should be smarter and not specific to any instruction
-    const auto i = std::get<InstructionDecodedInfoTypeI>(info);
-    const uint32_t funct3 = i.funct3 & 0x7u;
-    const uint32_t imm = static_cast<uint32_t>(i.imm) & 0xFFFu;
+    const uint32_t funct3 = info.funct3 & 0x7u;
+    const uint32_t imm = static_cast<uint32_t>(info.imm) & 0xFFFu;
 
     switch (funct3) {
         case 0b000u: return 0u;  // addi
@@ -290,13 +270,8 @@ inline uint32_t KeyTypeI_Arithm(InstructionDecodedCommonType info) {
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeI_Arithm(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 32u, &KeyTypeI_Arithm, &DecodeInstructionToCommonTypeI),
-        Addi::kOpcode);
-
-    RegisterInstructionsTypeI_Arithm(registry);
-}
+using OpcodeGroupTypeI_Arithm =
+    rvi::OpcodeGroup<Addi::kOpcode, /*key_space*/ 32u, &KeyTypeI_Arithm, &DecodeInstructionTypeI>;
 
 } // namespace rv32i
 } // namespace rvi
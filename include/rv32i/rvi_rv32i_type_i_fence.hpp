@@ -1,9 +1,8 @@
 // I-type FENCE
 #pragma once
 
-#include <cassert>
+#include <atomic>
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,41 +15,35 @@ class Fence final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x0Fu;
 
-    ExecutionStatus Execute(InterpreterState* /*state*/,
-                            const InstructionDecodedCommonType& /*decoded_info*/) const override {
-        assert(0);
-        return ExecutionStatus::Success;
+    // Orders the accesses of this hart for harts on other host threads; a
+    // single hart sees its own accesses in order anyway.
+    static void Exec(InterpreterState* state,
+                     const MicroOp& /*info*/) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        state->pc += 4u;
     }
 
     const char* GetName()   const override { return "Fence"; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeI info = {
-            .opcode = kOpcode,
-            .funct3 = 0b000u,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = 0b000u,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
 
-inline void RegisterInstructionsTypeI_Fence(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Fence>());
-}
-
-inline uint32_t KeyTypeI_Fence(InstructionDecodedCommonType /*info*/) {
+constexpr uint32_t KeyTypeI_Fence(const MicroOp& /*info*/) {
     return 0;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeI_Fence(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeI_Fence, &DecodeInstructionToCommonTypeI),
-        Fence::kOpcode);
-}
+using OpcodeGroupTypeI_Fence =
+    rvi::OpcodeGroup<Fence::kOpcode, /*key_space*/ 1u, &KeyTypeI_Fence, &DecodeInstructionTypeI>;
 
 } // namespace rv32i
 } // namespace rvi
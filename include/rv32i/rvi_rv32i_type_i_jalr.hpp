@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -15,10 +14,8 @@ class Jalr final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x67u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeI>(decoded_info);
-
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         uint32_t addr = static_cast<uint32_t>(
             static_cast<int32_t>(state->regs.Get(info.rs1)) + info.imm
         ) & ~1u;
@@ -27,42 +24,29 @@ public:
         state->regs.Set(info.rd, return_addr);
 
         state->pc = addr;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return "jalr"; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeI info = {
-            .opcode = kOpcode,
-            .funct3 = 0b000,
-        };
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = 0b000,
+    };
 
-        return info;
-    }
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
 
-inline void RegisterInstructionsTypeI_Jalr(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Jalr>());
-}
-
-inline uint32_t KeyTypeI_Jalr(InstructionDecodedCommonType /*info*/) {
+constexpr uint32_t KeyTypeI_Jalr(const MicroOp& /*info*/) {
     return 0;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeI_Jalr(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 8u, &KeyTypeI_Jalr, &DecodeInstructionToCommonTypeI),
-        Jalr::kOpcode);
-
-    RegisterInstructionsTypeI_Jalr(registry);
-}
+using OpcodeGroupTypeI_Jalr =
+    rvi::OpcodeGroup<Jalr::kOpcode, /*key_space*/ 8u, &KeyTypeI_Jalr, &DecodeInstructionTypeI>;
 
 } // namespace rv32i
 } // namespace rvi
@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,9 +15,8 @@ class Load final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x03u;
 
-    ExecutionStatus Execute(InterpreterState* state, const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeI>(decoded_info);
-
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         uint32_t addr = static_cast<uint32_t>(
             static_cast<int32_t>(state->regs.Get(info.rs1)) + info.imm
         );
@@ -33,21 +31,17 @@ public:
         }
 
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeI info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-        };
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+    };
 
-        return info;
-    }
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
@@ -97,28 +91,14 @@ using Lw  = Load<LoadWordOper>;
 
 namespace {
 
-inline void RegisterInstructionsTypeI_Load(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Lb>    ());
-    registry->RegisterInstruction(std::make_unique<Lbu>   ());
-    registry->RegisterInstruction(std::make_unique<Lh>    ());
-    registry->RegisterInstruction(std::make_unique<Lhu>   ());
-    registry->RegisterInstruction(std::make_unique<Lw>    ());
-}
-
-inline uint32_t KeyTypeI_Load(InstructionDecodedCommonType info) {
-    auto i = std::get<InstructionDecodedInfoTypeI>(info);
-    return i.funct3 & 0x7u;
+constexpr uint32_t KeyTypeI_Load(const MicroOp& info) {
+    return info.funct3 & 0x7u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeI_Load(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 8u, &KeyTypeI_Load, &DecodeInstructionToCommonTypeI),
-        Lb::kOpcode);
-
-    RegisterInstructionsTypeI_Load(registry);
-}
+using OpcodeGroupTypeI_Load =
+    rvi::OpcodeGroup<Lb::kOpcode, /*key_space*/ 8u, &KeyTypeI_Load, &DecodeInstructionTypeI>;
 
 } // namespace rv32i
 } // namespace rvi
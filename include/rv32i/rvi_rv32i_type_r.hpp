@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,28 +15,24 @@ class InstructionTypeR final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x33u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeR>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         state->regs.Set(info.rd,
                         Oper::exec(state->regs.Get(info.rs1),
                                    state->regs.Get(info.rs2)));
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeR info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-            .funct7 = Oper::funct7,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+        .funct7 = Oper::funct7,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 struct AddOp {
@@ -161,19 +156,6 @@ using Sra  = InstructionTypeR<SraOp>;
 using Or   = InstructionTypeR<OrOp>;
 using And  = InstructionTypeR<AndOp>;
 
-inline void RegisterInstructionsTypeR(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Add>());
-    registry->RegisterInstruction(std::make_unique<Sub>());
-    registry->RegisterInstruction(std::make_unique<Sll>());
-    registry->RegisterInstruction(std::make_unique<Slt>());
-    registry->RegisterInstruction(std::make_unique<Sltu>());
-    registry->RegisterInstruction(std::make_unique<Xor>());
-    registry->RegisterInstruction(std::make_unique<Srl>());
-    registry->RegisterInstruction(std::make_unique<Sra>());
-    registry->RegisterInstruction(std::make_unique<Or>());
-    registry->RegisterInstruction(std::make_unique<And>());
-}
-
 namespace {
 
 constexpr uint32_t kFunct3Bits = 3u;
@@ -182,19 +164,14 @@ constexpr uint32_t kFunct3Mask = (1u << kFunct3Bits) - 1u;
 constexpr uint32_t kFunct7Mask = (1u << kFunct7Bits) - 1u;
 constexpr size_t   kOpcodeGroupKeySpace = 1u << (kFunct3Bits + kFunct7Bits);
 
-inline uint32_t KeyTypeR(InstructionDecodedCommonType info) {
-    const auto& r = std::get<InstructionDecodedInfoTypeR>(info);
-    return ((r.funct7 & kFunct7Mask) << kFunct3Bits) | (r.funct3 & kFunct3Mask);
+constexpr uint32_t KeyTypeR(const MicroOp& info) {
+    return ((info.funct7 & kFunct7Mask) << kFunct3Bits) | (info.funct3 & kFunct3Mask);
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeR_Arithm(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(rvi::PerOpcodeGroup(kOpcodeGroupKeySpace, &KeyTypeR, &DecodeInstructionToCommonTypeR),
-                            Add::kOpcode);
-
-    RegisterInstructionsTypeR(registry);
-}
+using OpcodeGroupTypeR_Arithm =
+    rvi::OpcodeGroup<Add::kOpcode, kOpcodeGroupKeySpace, &KeyTypeR, &DecodeInstructionTypeR>;
 
 } // namespace rv32i
 } // namespace rvi
@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -16,9 +15,8 @@ class Save final : public rvi::IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x23u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeS>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         uint32_t addr = static_cast<uint32_t>(
             static_cast<int32_t>(state->regs.Get(info.rs1)) + info.imm
         );
@@ -27,19 +25,17 @@ public:
         state->memory.Set<typename Oper::type>(addr, value);
 
         state->pc += 4u;
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeS info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 struct SaveWord {
@@ -66,26 +62,14 @@ using Sb = Save<SaveByte>;
 
 namespace {
 
-inline void RegisterInstructionsTypeS(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Sw>());
-    registry->RegisterInstruction(std::make_unique<Sh>());
-    registry->RegisterInstruction(std::make_unique<Sb>());
-}
-
-inline uint32_t KeyTypeS_Store(InstructionDecodedCommonType info) {
-    auto s = std::get<InstructionDecodedInfoTypeS>(info);
-    return s.funct3 & 0x7u;
+constexpr uint32_t KeyTypeS_Store(const MicroOp& info) {
+    return info.funct3 & 0x7u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeS_Store(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 8u, &KeyTypeS_Store, &DecodeInstructionToCommonTypeS),
-        Sw::kOpcode);
-
-    RegisterInstructionsTypeS(registry);
-}
+using OpcodeGroupTypeS_Store =
+    rvi::OpcodeGroup<Sw::kOpcode, /*key_space*/ 8u, &KeyTypeS_Store, &DecodeInstructionTypeS>;
 
 } // namespace rv32i
 } // namespace rvi
@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -15,46 +14,33 @@ class Auipc final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x17u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeU>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         state->regs.Set(info.rd, state->pc + static_cast<uint32_t>(info.imm));
 
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return "auipc"; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeU info = {
-            .opcode = kOpcode,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
 
-inline void RegisterInstructionsTypeU_Auipc(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Auipc>());
-}
-
-inline uint32_t KeyTypeU_Auipc(InstructionDecodedCommonType /*info*/) {
+constexpr uint32_t KeyTypeU_Auipc(const MicroOp& /*info*/) {
     return 0u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeU_Auipc(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeU_Auipc, &DecodeInstructionToCommonTypeU),
-        Auipc::kOpcode);
-
-    RegisterInstructionsTypeU_Auipc(registry);
-}
+using OpcodeGroupTypeU_Auipc =
+    rvi::OpcodeGroup<Auipc::kOpcode, /*key_space*/ 1u, &KeyTypeU_Auipc, &DecodeInstructionTypeU>;
 
 } // namespace rv32i
 } // namespace rvi
@@ -2,7 +2,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -15,46 +14,33 @@ class Lui : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x37u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeU>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         state->regs.Set(info.rd, static_cast<uint32_t>(info.imm));
 
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return "lui"; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeU info = {
-            .opcode = kOpcode,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
 
-inline void RegisterInstructionsTypeU_Lui(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Lui>());
-}
-
-inline uint32_t KeyTypeU_Lui(InstructionDecodedCommonType /*info*/) {
+constexpr uint32_t KeyTypeU_Lui(const MicroOp& /*info*/) {
     return 0u;
 }
 
 } // namespace
 
-inline void RegisterOpcodeGroupTypeU_Lui(rvi::InstructionRegistry* registry) {
-    registry->RegisterGroup(
-        rvi::PerOpcodeGroup(/*size*/ 1u, &KeyTypeU_Lui, &DecodeInstructionToCommonTypeU),
-        Lui::kOpcode);
-
-    RegisterInstructionsTypeU_Lui(registry);
-}
+using OpcodeGroupTypeU_Lui =
+    rvi::OpcodeGroup<Lui::kOpcode, /*key_space*/ 1u, &KeyTypeU_Lui, &DecodeInstructionTypeU>;
 
 } // namespace rv32i
 } // namespace rvi
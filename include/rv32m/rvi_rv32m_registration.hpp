@@ -1,11 +0,0 @@
-#pragma once
-
-#include "rvi_instruction_registry.hpp"
-
-namespace rvi {
-namespace rv32m {
-
-void RegisterRV32M(InstructionRegistry* registry);
-
-} // namespace rv32m
-} // namespace rvi
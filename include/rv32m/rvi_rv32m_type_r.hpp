@@ -3,7 +3,6 @@
 
 #include <cstdint>
 #include <limits>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -17,28 +16,24 @@ class InstructionTypeR final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x33u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeR>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         state->regs.Set(info.rd,
                         Oper::exec(state->regs.Get(info.rs1),
                                    state->regs.Get(info.rs2)));
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeR info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-            .funct7 = Oper::funct7,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+        .funct7 = Oper::funct7,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 namespace {
@@ -198,16 +193,5 @@ using Divu  = InstructionTypeR<DivuOp>;
 using Rem   = InstructionTypeR<RemOp>;
 using Remu  = InstructionTypeR<RemuOp>;
 
-inline void RegisterInstructionsTypeR(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Mul>());
-    registry->RegisterInstruction(std::make_unique<Mulh>());
-    registry->RegisterInstruction(std::make_unique<Mulhsu>());
-    registry->RegisterInstruction(std::make_unique<Mulhu>());
-    registry->RegisterInstruction(std::make_unique<Div>());
-    registry->RegisterInstruction(std::make_unique<Divu>());
-    registry->RegisterInstruction(std::make_unique<Rem>());
-    registry->RegisterInstruction(std::make_unique<Remu>());
-}
-
 } // namespace rv32m
 } // namespace rvi
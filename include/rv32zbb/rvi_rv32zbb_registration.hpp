@@ -1,11 +0,0 @@
-#pragma once
-
-#include "rvi_instruction_registry.hpp"
-
-namespace rvi {
-namespace rv32zbb {
-
-void RegisterRV32zbb(InstructionRegistry* registry);
-
-} // namespace rv32zbb
-} // namespace rvi
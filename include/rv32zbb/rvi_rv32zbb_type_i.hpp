@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -17,25 +16,22 @@ class InstructionTypeI final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x13u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeI>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         Oper::exec(state, info);
         state->pc += 4u;
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeI info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-            .imm    = static_cast<int32_t>(Oper::imm),
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+        .imm    = static_cast<int32_t>(Oper::imm),
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 struct ClzOper {
@@ -43,7 +39,7 @@ struct ClzOper {
     static constexpr uint32_t funct3 = 0b001u;
     static constexpr uint32_t imm = 0b011000000000u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         const uint32_t result = CountLeadingZeros(value);
         state->regs.Set(info.rd, result);
@@ -55,7 +51,7 @@ struct CtzOper {
     static constexpr uint32_t funct3 = 0b001u;
     static constexpr uint32_t imm = 0b011000000001u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         const uint32_t result = CountTrailingZeros(value);
         state->regs.Set(info.rd, result);
@@ -67,7 +63,7 @@ struct CpopOper {
     static constexpr uint32_t funct3 = 0b001u;
     static constexpr uint32_t imm = 0b011000000010u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         const uint32_t result = PopulationCount32(value);
         state->regs.Set(info.rd, result);
@@ -79,7 +75,7 @@ struct SextBOper {
     static constexpr uint32_t funct3 = 0b001u;
     static constexpr uint32_t imm = 0b011000000100u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         state->regs.Set(info.rd, SignExtend8(value));
     }
@@ -90,7 +86,7 @@ struct SextHOper {
     static constexpr uint32_t funct3 = 0b001u;
     static constexpr uint32_t imm = 0b011000000101u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         state->regs.Set(info.rd, SignExtend16(value));
     }
@@ -101,7 +97,7 @@ struct RoriOper {
     static constexpr uint32_t funct3 = 0b101u;
     static constexpr uint32_t imm = 0b011000000000u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         const uint32_t shamt = static_cast<uint32_t>(info.imm) & kRotateMask;
         state->regs.Set(info.rd, RotateRight32(value, shamt));
@@ -113,7 +109,7 @@ struct OrcbOper {
     static constexpr uint32_t funct3 = 0b101u;
     static constexpr uint32_t imm = 0b001010000111u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         state->regs.Set(info.rd, OrcByte(value));
     }
@@ -124,7 +120,7 @@ struct Rev8Oper {
     static constexpr uint32_t funct3 = 0b101u;
     static constexpr uint32_t imm = 0b011010011000u;
 
-    static void exec(InterpreterState* state, const InstructionDecodedInfoTypeI& info) {
+    static void exec(InterpreterState* state, const MicroOp& info) {
         const uint32_t value = state->regs.Get(info.rs1);
         state->regs.Set(info.rd, ReverseBytes(value));
     }
@@ -139,17 +135,6 @@ using Rori  = InstructionTypeI<RoriOper>;
 using Orcb  = InstructionTypeI<OrcbOper>;
 using Rev8  = InstructionTypeI<Rev8Oper>;
 
-inline void RegisterInstructionsTypeI(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Clz>());
-    registry->RegisterInstruction(std::make_unique<Ctz>());
-    registry->RegisterInstruction(std::make_unique<Cpop>());
-    registry->RegisterInstruction(std::make_unique<SextB>());
-    registry->RegisterInstruction(std::make_unique<SextH>());
-    registry->RegisterInstruction(std::make_unique<Rori>());
-    registry->RegisterInstruction(std::make_unique<Orcb>());
-    registry->RegisterInstruction(std::make_unique<Rev8>());
-}
-
 } // namespace rv32zbb
 } // namespace rvi
 
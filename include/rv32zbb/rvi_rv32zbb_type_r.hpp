@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <memory>
 
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
@@ -17,29 +16,25 @@ class InstructionTypeR final : public IInstruction {
 public:
     static constexpr uint32_t kOpcode = 0x33u;
 
-    ExecutionStatus Execute(InterpreterState* state,
-                            const InstructionDecodedCommonType& decoded_info) const override {
-        const auto& info = std::get<InstructionDecodedInfoTypeR>(decoded_info);
+    static void Exec(InterpreterState* state,
+                     const MicroOp& info) {
         const uint32_t lhs = state->regs.Get(info.rs1);
         const uint32_t rhs = state->regs.Get(info.rs2);
 
         state->regs.Set(info.rd, Oper::exec(lhs, rhs));
         state->pc += 4u;
-
-        return ExecutionStatus::Success;
     }
 
     const char* GetName()   const override { return Oper::name; }
     uint32_t    GetOpcode() const override { return kOpcode; }
 
-    InstructionDecodedCommonType GetDecodedInfo() const override {
-        InstructionDecodedInfoTypeR info = {
-            .opcode = kOpcode,
-            .funct3 = Oper::funct3,
-            .funct7 = Oper::funct7,
-        };
-        return info;
-    }
+    static constexpr MicroOp kDecodedInfo = {
+        .opcode = kOpcode,
+        .funct3 = Oper::funct3,
+        .funct7 = Oper::funct7,
+    };
+
+    MicroOp GetDecodedInfo() const override { return kDecodedInfo; }
 };
 
 struct AndnOp {
@@ -167,18 +162,5 @@ using Rol   = InstructionTypeR<RolOp>;
 using Ror   = InstructionTypeR<RorOp>;
 using Zext  = InstructionTypeR<ZextOp>;
 
-inline void RegisterInstructionsTypeR(rvi::InstructionRegistry* registry) {
-    registry->RegisterInstruction(std::make_unique<Andn>());
-    registry->RegisterInstruction(std::make_unique<Orn>());
-    registry->RegisterInstruction(std::make_unique<Xnor>());
-    registry->RegisterInstruction(std::make_unique<Min>());
-    registry->RegisterInstruction(std::make_unique<Max>());
-    registry->RegisterInstruction(std::make_unique<Minu>());
-    registry->RegisterInstruction(std::make_unique<Maxu>());
-    registry->RegisterInstruction(std::make_unique<Rol>());
-    registry->RegisterInstruction(std::make_unique<Ror>());
-    registry->RegisterInstruction(std::make_unique<Zext>());
-}
-
 } // namespace rv32zbb
 } // namespace rvi
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rvi_decode_info.hpp"
+#include "rvi_instruction_registry.hpp"
+#include "rvi_memory_state.hpp"
+
+#include <cstddef>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace rvi {
+
+// Straight-line run of instructions starting at start_pc. A block ends right
+// after the first control transfer (branch, jal, jalr, ecall/ebreak) or when
+// kMaxBlockSize instructions have been decoded.
+struct BasicBlock {
+    struct Link {
+        uint32_t pc = 0u;
+        const BasicBlock* block = nullptr;
+    };
+
+    uint32_t start_pc = 0u;
+    uint32_t end_pc   = 0u; // exclusive
+    std::vector<MicroOp> ops{}; // after fusion, see OpLength
+
+    // Most recently taken successors, filled by BlockCache::GetNextBlock.
+    // Direct exits have at most two, so they hit after the first visit.
+    mutable std::array<Link, 2> links{};
+};
+
+class BlockCache {
+public:
+    static constexpr size_t kMaxBlockSize = 64u;
+
+private:
+    std::unordered_map<uint32_t, std::unique_ptr<BasicBlock>> blocks_;
+    std::unordered_set<uint32_t> block_starts_{};
+
+    std::unique_ptr<BasicBlock> DecodeBlock(const InterpreterMemoryModel& memory, uint32_t pc) const;
+
+public:
+    BlockCache();
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    // Decodes the block on the first visit, afterwards the decoder is not
+    // touched. The block's instructions are marked as code in memory.
+    const BasicBlock& GetBlock(InterpreterMemoryModel& memory, uint32_t pc);
+
+    // GetBlock for the block execution continues at after prev, which skips
+    // the lookup when prev already links to it.
+    const BasicBlock& GetNextBlock(InterpreterMemoryModel& memory, const BasicBlock& prev,
+                                   uint32_t pc);
+
+    // Drops the blocks that overlap code written since the last call, and
+    // every link, since links may point at dropped blocks. Returns the start
+    // pcs of the dropped blocks, so engines can drop what they derived.
+    // References to dropped blocks become invalid.
+    std::vector<uint32_t> InvalidateWrittenCode(InterpreterMemoryModel* memory);
+
+    // Blocks decoded afterwards end before pc, so execution passes it at a
+    // block boundary. Already decoded blocks are kept.
+    void AddBlockStart(uint32_t pc) { block_starts_.insert(pc); }
+
+    void   Clear();
+    size_t Size() const noexcept { return blocks_.size(); }
+};
+
+} // namespace
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "rvi_state.hpp"
+
+#include <string>
+
+namespace rvi {
+
+// Checkpoints hold the registers, pc, exit status, heap bounds and guest
+// memory of an InterpreterState: page permissions, and the content of every
+// page that is not all zero, page-aligned in the file so restoring maps it
+// copy-on-write instead of reading it. Open files, VFS overlays and cached
+// code are not saved; the restored guest has the host's standard streams.
+//
+// A checkpoint is restored by the memory backend that saved it, on a host
+// with the same page size. Both throw std::runtime_error on failure.
+void SaveCheckpoint(const InterpreterState& state, const std::string& path);
+
+// Restores into a state whose memory nothing was loaded into yet.
+void RestoreCheckpoint(const std::string& path, InterpreterState* state);
+
+} // namespace
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace rvi {
+
+// Executable memory for generated code. Pages are W^X: they are writable only
+// while new code is copied in and are executable afterwards.
+class CodeCache {
+public:
+    static constexpr size_t kDefaultSize = 64u << 20;
+
+private:
+    uint8_t* base_ = nullptr;
+    size_t   size_ = 0u;
+    size_t   used_ = 0u;
+
+    size_t AlignedUsed() const noexcept;
+    void Write(size_t offset, std::span<const uint8_t> bytes);
+
+public:
+    explicit CodeCache(size_t size = kDefaultSize);
+    ~CodeCache();
+
+    CodeCache(const CodeCache&) = delete;
+    CodeCache& operator=(const CodeCache&) = delete;
+
+    bool Fits(size_t size) const noexcept;
+
+    // Returns the executable copy of code, nullptr if the cache is full.
+    const uint8_t* Add(std::span<const uint8_t> code);
+
+    // Overwrites bytes of code returned by Add, e.g. to link a jump.
+    void Patch(const uint8_t* at, std::span<const uint8_t> bytes);
+
+    // Forgets all code, pointers returned by Add become invalid.
+    void Reset() noexcept { used_ = 0u; }
+
+    size_t Used() const noexcept { return used_; }
+    size_t Size() const noexcept { return size_; }
+};
+
+} // namespace
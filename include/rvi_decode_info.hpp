@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <variant>
 
 namespace rvi {
 
@@ -14,84 +13,31 @@ enum class InstructionType {
     U,
 };
 
-struct InstructionDecodedInfoTypeR {
-    uint32_t opcode;
-    uint32_t rd;
-    uint32_t funct3;
-    uint32_t rs1;
-    uint32_t rs2;
-    uint32_t funct7;
-};
-
-struct InstructionDecodedInfoTypeR4 {
-    uint32_t opcode;
-    uint32_t rd;
-    uint32_t rm; 
-    uint32_t rs1;
-    uint32_t rs2;
-    uint32_t rs3;
-    uint32_t fmt;
-};
-
-struct InstructionDecodedInfoTypeI {
-    uint32_t opcode;
-    uint32_t rd;
-    uint32_t funct3;
-    uint32_t rs1;
+constexpr uint16_t kNoHandler = UINT16_MAX;
+
+// Fixed-layout decoded instruction shared by every format. Fields a format
+// does not have stay zero; for R4 funct3 holds rm and funct7 holds fmt.
+// The immediate is already sign-extended and shifted into place.
+struct MicroOp {
+    uint16_t handler = kNoHandler; // OpId of the implementation, filled by the decoder
+    uint8_t  opcode;
+    uint8_t  rd;
+    uint8_t  rs1;
+    uint8_t  rs2;
+    uint8_t  rs3;
+    uint8_t  funct3;
+    uint8_t  funct7;
     int32_t  imm;
 };
 
-struct InstructionDecodedInfoTypeS {
-    uint32_t opcode;
-    uint32_t funct3;
-    uint32_t rs1;
-    uint32_t rs2;
-    int32_t  imm;
-};
-
-struct InstructionDecodedInfoTypeU {
-    uint32_t opcode;
-    uint32_t rd;
-    int32_t  imm;
-};
-
-struct InstructionDecodedInfoTypeB {
-    uint32_t opcode;
-    uint32_t funct3;
-    uint32_t rs1;
-    uint32_t rs2;
-    int32_t  imm;
-};
-
-struct InstructionDecodedInfoTypeJ {
-    uint32_t opcode;
-    uint32_t rd;
-    int32_t  imm;
-};
-
-using InstructionDecodedCommonType =
-      std::variant<InstructionDecodedInfoTypeR,
-                   InstructionDecodedInfoTypeI,
-                   InstructionDecodedInfoTypeB,
-                   InstructionDecodedInfoTypeJ,
-                   InstructionDecodedInfoTypeU,
-                   InstructionDecodedInfoTypeS,
-                   InstructionDecodedInfoTypeR4>;
-
-InstructionDecodedInfoTypeR DecodeInstructionTypeR(uint32_t instr);
-InstructionDecodedInfoTypeI DecodeInstructionTypeI(uint32_t instr);
-InstructionDecodedInfoTypeS DecodeInstructionTypeS(uint32_t instr);
-InstructionDecodedInfoTypeU DecodeInstructionTypeU(uint32_t instr);
-InstructionDecodedInfoTypeB DecodeInstructionTypeB(uint32_t instr);
-InstructionDecodedInfoTypeJ DecodeInstructionTypeJ(uint32_t instr);
-InstructionDecodedInfoTypeR4 DecodeInstructionTypeR4(uint32_t instr);
+static_assert(sizeof(MicroOp) <= 16u, "MicroOp must stay cache-dense");
 
-InstructionDecodedCommonType DecodeInstructionToCommonTypeR(uint32_t instr);
-InstructionDecodedCommonType DecodeInstructionToCommonTypeI(uint32_t instr);
-InstructionDecodedCommonType DecodeInstructionToCommonTypeS(uint32_t instr);
-InstructionDecodedCommonType DecodeInstructionToCommonTypeU(uint32_t instr);
-InstructionDecodedCommonType DecodeInstructionToCommonTypeB(uint32_t instr);
-InstructionDecodedCommonType DecodeInstructionToCommonTypeJ(uint32_t instr);
-InstructionDecodedCommonType DecodeInstructionToCommonTypeR4(uint32_t instr);
+MicroOp DecodeInstructionTypeR (uint32_t instr);
+MicroOp DecodeInstructionTypeI (uint32_t instr);
+MicroOp DecodeInstructionTypeS (uint32_t instr);
+MicroOp DecodeInstructionTypeU (uint32_t instr);
+MicroOp DecodeInstructionTypeB (uint32_t instr);
+MicroOp DecodeInstructionTypeJ (uint32_t instr);
+MicroOp DecodeInstructionTypeR4(uint32_t instr);
 
 } // namespace
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "rvi_session.hpp"
+
+namespace rvi {
+
+// First of the two fds of the AFL fork server protocol, FORKSRV_FD.
+constexpr int kForkServerFd = 198;
+
+// Serves runs of a loaded session, typically stopped by RunToRead or RunToPc,
+// as an AFL-style fork server: for every request on control_fd the process
+// forks, and the child continues the session from where it stands, with its
+// guest memory copy-on-write. The server answers on control_fd + 1 with the
+// child's pid and then its wait status. Children share host fds with the
+// server, so the client rewinds the input file between runs.
+//
+// Returns true in each child, and right away when no client is attached;
+// the caller then runs the session. Returns false in the server once the
+// client closes control_fd. Throws std::runtime_error for sessions using
+// io_uring, whose rings the children would share.
+bool ServeForks(Session* session, int control_fd = kForkServerFd);
+
+} // namespace
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "rvi_decode_info.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace rvi {
+
+// Replaces adjacent instruction pairs of a decoded block with fused ops
+// (fused/rvi_fused_ops.hpp): lui+addi, auipc+jalr, auipc+lw, slli+add and
+// slt[u]+bnez/beqz. Use OpLength to step the guest pc over the result.
+// Returns the number of fused pairs.
+size_t FuseOps(std::vector<MicroOp>* ops);
+
+} // namespace
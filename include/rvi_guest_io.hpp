@@ -0,0 +1,163 @@
+#pragma once
+
+#include "rvi_io_ring.hpp"
+#include "rvi_memory_state.hpp"
+#include "rvi_vfs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+namespace rvi {
+
+// Receives what the guest writes to a standard stream instead of the host fd.
+using OutputSink = std::function<void(std::span<const uint8_t> data)>;
+
+// A guest buffer, e.g. one element of a readv/writev iovec array.
+struct GuestRange {
+    uint32_t address;
+    uint32_t size;
+};
+
+// Host side of the guest's file descriptors. Guest fds index a table of host
+// fds and VFS files; 0, 1 and 2 are the host's standard streams, which
+// closing them does not close on the host. Embedders may replace stdin with a
+// byte buffer and stdout or stderr with sinks. Guest buffers are handed to the host as spans of
+// guest memory, not copied byte by byte, and reads land in guest memory
+// directly.
+//
+// Host stdout is buffered: writes that fit are collected and flushed when the
+// buffer fills, before reading stdin, before writing stderr, on exit and on
+// destruction. Larger writes go straight from guest memory to writev.
+//
+// With EnableIoUring, a full stdout buffer is written by io_uring while the
+// guest fills a second one, and stdin is read ahead into a host buffer while
+// the guest runs. A guest read first waits for all earlier output, so the
+// guest still sees its I/O complete in program order. Input read ahead but
+// not consumed by the guest is lost to later readers of stdin.
+class GuestIo {
+public:
+    static constexpr size_t kDefaultOutputBuffer = 64u << 10;
+    static constexpr size_t kReadAhead = 64u << 10;
+
+    static constexpr uint32_t kStdin  = 0u;
+    static constexpr uint32_t kStdout = 1u;
+    static constexpr uint32_t kStderr = 2u;
+
+private:
+    // A guest fd is a host fd, a VFS file, a sink or none if it is closed.
+    struct OpenFd {
+        int host = -1;
+        std::unique_ptr<VfsFile> file{};
+        OutputSink sink{};
+
+        bool IsOpen() const noexcept { return host >= 0 || file != nullptr || sink != nullptr; }
+    };
+
+    std::vector<OpenFd> fds_{};
+    int directory_ = AT_FDCWD;
+    std::vector<uint8_t> output_{};
+    size_t output_capacity_ = kDefaultOutputBuffer;
+    std::vector<std::span<const uint8_t>> read_spans_{};
+    std::vector<std::span<uint8_t>> write_spans_{};
+    std::vector<iovec> iov_{};
+
+    // io_uring only: output being written and stdin read ahead.
+    std::unique_ptr<IoRing> ring_{};
+    std::vector<uint8_t> draining_{};
+    size_t drained_ = 0u;
+    bool write_in_flight_ = false;
+    std::vector<uint8_t> input_{};
+    size_t input_begin_ = 0u;
+    size_t input_end_ = 0u;
+    int32_t input_error_ = 0;
+    bool read_in_flight_ = false;
+
+    OpenFd* FreeFd();
+    int32_t WriteDirect(int host_fd);
+    void SubmitOutput();
+    void StartDrain();
+    void StartReadAhead();
+    void Reap();
+    int32_t ReadAhead(InterpreterMemoryModel* memory, std::span<const GuestRange> ranges);
+
+public:
+    GuestIo();
+    ~GuestIo();
+
+    GuestIo(const GuestIo&) = delete;
+    GuestIo& operator=(const GuestIo&) = delete;
+
+    // 0 makes every guest write a host write.
+    void SetOutputBuffer(size_t capacity);
+
+    // Moves stdin and stdout I/O to io_uring. Returns false if the host has
+    // none; I/O then stays synchronous.
+    bool EnableIoUring();
+
+    // Relative guest paths on the host file system start from path rather
+    // than the process's working directory. Throws if it cannot be opened.
+    void SetDirectory(const std::string& path);
+
+    // Host dirfd relative guest paths start from, AT_FDCWD by default.
+    int Directory() const noexcept { return directory_; }
+
+    // Host fd behind a guest fd, -1 if it is not open.
+    int HostFd(uint32_t fd) const noexcept {
+        return fd < fds_.size() ? fds_[fd].host : -1;
+    }
+
+    bool IsOpen(uint32_t fd) const noexcept {
+        return fd < fds_.size() && fds_[fd].IsOpen();
+    }
+
+    // VFS file behind a guest fd, nullptr if it is not one.
+    VfsFile* File(uint32_t fd) const noexcept {
+        return fd < fds_.size() ? fds_[fd].file.get() : nullptr;
+    }
+
+    // Gives an open host fd or VFS file the lowest free guest fd, which is
+    // returned. The host fd is closed with it.
+    uint32_t Adopt(int host_fd);
+    uint32_t Adopt(std::unique_ptr<VfsFile> file);
+
+    // Guest stdin reads data, then end of file.
+    void SetInput(std::vector<uint8_t> data);
+
+    // Guest writes to fd, stdout or stderr, go to sink.
+    void SetOutput(uint32_t fd, OutputSink sink);
+
+    // close(2) of a guest fd. Returns 0 or -errno.
+    int32_t Close(uint32_t fd);
+
+    // write(2) of [address, address + size) to a guest fd. Returns the number
+    // of bytes written or -errno.
+    int32_t Write(uint32_t fd, const InterpreterMemoryModel& memory, uint32_t address, uint32_t size) {
+        const GuestRange range{address, size};
+        return Write(fd, memory, {&range, 1u});
+    }
+
+    // writev(2) of the ranges in order.
+    int32_t Write(uint32_t fd, const InterpreterMemoryModel& memory, std::span<const GuestRange> ranges);
+
+    // read(2) into [address, address + size). Like the kernel it returns
+    // what one host read delivers, which may be less than size, 0 at end of
+    // file or -errno.
+    int32_t Read(uint32_t fd, InterpreterMemoryModel* memory, uint32_t address, uint32_t size) {
+        const GuestRange range{address, size};
+        return Read(fd, memory, {&range, 1u});
+    }
+
+    // readv(2) into the ranges in order.
+    int32_t Read(uint32_t fd, InterpreterMemoryModel* memory, std::span<const GuestRange> ranges);
+
+    void Flush();
+};
+
+} // namespace
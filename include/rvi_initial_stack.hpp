@@ -0,0 +1,35 @@
+#pragma once
+
+#include "rvi_memory_state.hpp"
+#include "rvi_read_binary.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace rvi {
+
+// Auxiliary vector keys of the Linux ABI.
+enum class AuxKey : uint32_t {
+    Null   = 0,
+    Phdr   = 3,
+    Phent  = 4,
+    Phnum  = 5,
+    Pagesz = 6,
+    Entry  = 9,
+    Random = 25,
+    Execfn = 31,
+};
+
+// Writes the stack a Linux kernel hands a new process below stack_top and
+// returns the initial sp, 16-byte aligned:
+//
+//   sp -> argc, argv[0..argc), 0, envp..., 0, auxv key/value pairs, AT_NULL
+//
+// with the strings and the 16 AT_RANDOM bytes above them. args includes
+// argv[0]. Throws std::runtime_error if the strings take more than the
+// kernel allows, a quarter of an 8 MiB stack.
+uint32_t BuildInitialStack(InterpreterMemoryModel* memory, uint32_t stack_top, const ImageInfo& image,
+                           std::span<const std::string> args, std::span<const std::string> env);
+
+} // namespace
@@ -8,17 +8,13 @@ namespace rvi {
 
 struct InterpreterState;
 
-enum class ExecutionStatus {
-    Success = 0,
-    Exit = 1,
-};
-
+// Introspection only. Every implementation also provides
+//     static void Exec(InterpreterState* state, const MicroOp& info);
+// which the engines call directly, see RVI_INSTRUCTION_LIST.
 class IInstruction {
 public:
-    virtual InstructionDecodedCommonType GetDecodedInfo()    const = 0;
-    virtual uint32_t                     GetOpcode()         const = 0;
-    virtual ExecutionStatus Execute(InterpreterState* state,
-                                    const InstructionDecodedCommonType& decoded_info) const = 0;
+    virtual MicroOp  GetDecodedInfo()    const = 0;
+    virtual uint32_t GetOpcode()         const = 0;
 
     virtual const char* GetName() const = 0;
 
@@ -0,0 +1,204 @@
+// Every instruction the interpreter implements, as X(name, type) entries.
+// Engines expand this list to generate per-instruction handlers.
+#pragma once
+
+#include "rv32i/rvi_rv32i_type_b_branch.hpp"
+#include "rv32i/rvi_rv32i_type_i_arithm.hpp"
+#include "rv32i/rvi_rv32i_type_i_fence.hpp"
+#include "rv32i/rvi_rv32i_type_i_jalr.hpp"
+#include "rv32i/rvi_rv32i_type_i_load.hpp"
+#include "rv32i/rvi_rv32i_type_i_system.hpp"
+#include "rv32i/rvi_rv32i_type_j_jal.hpp"
+#include "rv32i/rvi_rv32i_type_r.hpp"
+#include "rv32i/rvi_rv32i_type_s_store.hpp"
+#include "rv32i/rvi_rv32i_type_u_auipc.hpp"
+#include "rv32i/rvi_rv32i_type_u_lui.hpp"
+
+#include "rv32m/rvi_rv32m_type_r.hpp"
+
+#include "rv32a/rvi_rv32a_type_r.hpp"
+
+#include "rv32f/rvi_rv32f_type_f_load.hpp"
+#include "rv32f/rvi_rv32f_type_r.hpp"
+#include "rv32f/rvi_rv32f_type_r4.hpp"
+#include "rv32f/rvi_rv32f_type_s_save.hpp"
+
+#include "rv32zbb/rvi_rv32zbb_type_i.hpp"
+#include "rv32zbb/rvi_rv32zbb_type_r.hpp"
+
+#include "fused/rvi_fused_ops.hpp"
+
+#define RVI_INSTRUCTION_LIST_RV32I(X) \
+    X(Add,     rv32i::Add)            \
+    X(Sub,     rv32i::Sub)            \
+    X(Sll,     rv32i::Sll)            \
+    X(Slt,     rv32i::Slt)            \
+    X(Sltu,    rv32i::Sltu)           \
+    X(Xor,     rv32i::Xor)            \
+    X(Srl,     rv32i::Srl)            \
+    X(Sra,     rv32i::Sra)            \
+    X(Or,      rv32i::Or)             \
+    X(And,     rv32i::And)            \
+    X(Addi,    rv32i::Addi)           \
+    X(Stli,    rv32i::Stli)           \
+    X(Stliu,   rv32i::Stliu)          \
+    X(Xori,    rv32i::Xori)           \
+    X(Ori,     rv32i::Ori)            \
+    X(Andi,    rv32i::Andi)           \
+    X(Slli,    rv32i::Slli)           \
+    X(Srli,    rv32i::Srli)           \
+    X(Srai,    rv32i::Srai)           \
+    X(Lb,      rv32i::Lb)             \
+    X(Lbu,     rv32i::Lbu)            \
+    X(Lh,      rv32i::Lh)             \
+    X(Lhu,     rv32i::Lhu)            \
+    X(Lw,      rv32i::Lw)             \
+    X(Sb,      rv32i::Sb)             \
+    X(Sh,      rv32i::Sh)             \
+    X(Sw,      rv32i::Sw)             \
+    X(Beq,     rv32i::Beq)            \
+    X(Bne,     rv32i::Bne)            \
+    X(Blt,     rv32i::Blt)            \
+    X(Bge,     rv32i::Bge)            \
+    X(Bltu,    rv32i::Bltu)           \
+    X(Bgeu,    rv32i::Bgeu)           \
+    X(Jal,     rv32i::Jal)            \
+    X(Jalr,    rv32i::Jalr)           \
+    X(Lui,     rv32i::Lui)            \
+    X(Auipc,   rv32i::Auipc)          \
+    X(Fence,   rv32i::Fence)          \
+    X(Ecall,   rv32i::Ecall)          \
+    X(Ebreak,  rv32i::Ebreak)
+
+#define RVI_INSTRUCTION_LIST_RV32M(X) \
+    X(Mul,     rv32m::Mul)            \
+    X(Mulh,    rv32m::Mulh)           \
+    X(Mulhsu,  rv32m::Mulhsu)         \
+    X(Mulhu,   rv32m::Mulhu)          \
+    X(Div,     rv32m::Div)            \
+    X(Divu,    rv32m::Divu)           \
+    X(Rem,     rv32m::Rem)            \
+    X(Remu,    rv32m::Remu)
+
+#define RVI_INSTRUCTION_LIST_RV32A(X) \
+    X(LrW,      rv32a::LrW)           \
+    X(ScW,      rv32a::ScW)           \
+    X(AmoswapW, rv32a::AmoswapW)      \
+    X(AmoaddW,  rv32a::AmoaddW)       \
+    X(AmoxorW,  rv32a::AmoxorW)       \
+    X(AmoandW,  rv32a::AmoandW)       \
+    X(AmoorW,   rv32a::AmoorW)        \
+    X(AmominW,  rv32a::AmominW)       \
+    X(AmomaxW,  rv32a::AmomaxW)       \
+    X(AmominuW, rv32a::AmominuW)      \
+    X(AmomaxuW, rv32a::AmomaxuW)
+
+#define RVI_INSTRUCTION_LIST_RV32F(X) \
+    X(Flw,     rv32f::Flw)            \
+    X(Fsw,     rv32f::Fsw)            \
+    X(FAddS,   rv32f::FAddS)          \
+    X(FSubS,   rv32f::FSubS)          \
+    X(FMulS,   rv32f::FMulS)          \
+    X(FDivS,   rv32f::FDivS)          \
+    X(FSqrtS,  rv32f::FSqrtS)         \
+    X(FSgnjS,  rv32f::FSgnjS)         \
+    X(FSgnjnS, rv32f::FSgnjnS)        \
+    X(FSgnjxS, rv32f::FSgnjxS)        \
+    X(FMinS,   rv32f::FMinS)          \
+    X(FMaxS,   rv32f::FMaxS)          \
+    X(FEqS,    rv32f::FEqS)           \
+    X(FLtS,    rv32f::FLtS)           \
+    X(FLeS,    rv32f::FLeS)           \
+    X(FCvtWS,  rv32f::FCvtWS)         \
+    X(FCvtWUS, rv32f::FCvtWUS)        \
+    X(FCvtSW,  rv32f::FCvtSW)         \
+    X(FCvtSWU, rv32f::FCvtSWU)        \
+    X(FClassS, rv32f::FClassS)        \
+    X(FMvXW,   rv32f::FMvXW)          \
+    X(FMvWX,   rv32f::FMvWX)          \
+    X(FmaddS,  rv32f::FmaddS)         \
+    X(FmsubS,  rv32f::FmsubS)         \
+    X(FnmaddS, rv32f::FnmaddS)        \
+    X(FnmsubS, rv32f::FnmsubS)
+
+#define RVI_INSTRUCTION_LIST_RV32ZBB(X) \
+    X(Andn,    rv32zbb::Andn)           \
+    X(Orn,     rv32zbb::Orn)            \
+    X(Xnor,    rv32zbb::Xnor)           \
+    X(Min,     rv32zbb::Min)            \
+    X(Max,     rv32zbb::Max)            \
+    X(Minu,    rv32zbb::Minu)           \
+    X(Maxu,    rv32zbb::Maxu)           \
+    X(Rol,     rv32zbb::Rol)            \
+    X(Ror,     rv32zbb::Ror)            \
+    X(Zext,    rv32zbb::Zext)           \
+    X(Clz,     rv32zbb::Clz)            \
+    X(Ctz,     rv32zbb::Ctz)            \
+    X(Cpop,    rv32zbb::Cpop)           \
+    X(SextB,   rv32zbb::SextB)          \
+    X(SextH,   rv32zbb::SextH)          \
+    X(Rori,    rv32zbb::Rori)           \
+    X(Orcb,    rv32zbb::Orcb)           \
+    X(Rev8,    rv32zbb::Rev8)
+
+// Produced by the fusion pass only, never by the decoder.
+#define RVI_INSTRUCTION_LIST_FUSED(X)   \
+    X(LuiAddi,   fused::LuiAddi)        \
+    X(AuipcJalr, fused::AuipcJalr)      \
+    X(AuipcLw,   fused::AuipcLw)        \
+    X(SlliAdd,   fused::SlliAdd)        \
+    X(SltBnez,   fused::SltBnez)        \
+    X(SltBeqz,   fused::SltBeqz)        \
+    X(SltuBnez,  fused::SltuBnez)       \
+    X(SltuBeqz,  fused::SltuBeqz)
+
+// Fused ops must stay last, see OpLength.
+#define RVI_INSTRUCTION_LIST(X)     \
+    RVI_INSTRUCTION_LIST_RV32I(X)   \
+    RVI_INSTRUCTION_LIST_RV32M(X)   \
+    RVI_INSTRUCTION_LIST_RV32A(X)   \
+    RVI_INSTRUCTION_LIST_RV32F(X)   \
+    RVI_INSTRUCTION_LIST_RV32ZBB(X) \
+    RVI_INSTRUCTION_LIST_FUSED(X)
+
+// Every major opcode with its decode group, as X(group) entries.
+#define RVI_OPCODE_GROUP_LIST(X)            \
+    X(rv32i::OpcodeGroupTypeR_Arithm)       \
+    X(rv32i::OpcodeGroupTypeI_Arithm)       \
+    X(rv32i::OpcodeGroupTypeI_Load)         \
+    X(rv32i::OpcodeGroupTypeS_Store)        \
+    X(rv32i::OpcodeGroupTypeB_Branch)       \
+    X(rv32i::OpcodeGroupTypeI_Jalr)         \
+    X(rv32i::OpcodeGroupTypeJ_Jal)          \
+    X(rv32i::OpcodeGroupTypeU_Lui)          \
+    X(rv32i::OpcodeGroupTypeU_Auipc)        \
+    X(rv32i::OpcodeGroupTypeI_Fence)        \
+    X(rv32i::OpcodeGroupTypeI_System)       \
+    X(rv32a::OpcodeGroupTypeR_Amo)          \
+    X(rv32f::OpcodeGroupTypeI_Flw)          \
+    X(rv32f::OpcodeGroupTypeS_Fsw)          \
+    X(rv32f::OpcodeGroupTypeR_Float)        \
+    X(rv32f::OpcodeGroupTypeR4_Fmadd)       \
+    X(rv32f::OpcodeGroupTypeR4_Fmsub)       \
+    X(rv32f::OpcodeGroupTypeR4_Fnmadd)      \
+    X(rv32f::OpcodeGroupTypeR4_Fnmsub)
+
+namespace rvi {
+
+enum class OpId : uint16_t {
+#define RVI_DEFINE_OP_ID(name, type) name,
+    RVI_INSTRUCTION_LIST(RVI_DEFINE_OP_ID)
+#undef RVI_DEFINE_OP_ID
+    kCount,
+};
+
+#define RVI_COUNT_OP(name, type) + 1u
+constexpr uint16_t kFusedOpCount = 0u RVI_INSTRUCTION_LIST_FUSED(RVI_COUNT_OP);
+#undef RVI_COUNT_OP
+
+// Bytes of guest code an op stands for.
+constexpr uint32_t OpLength(uint16_t handler) {
+    return handler >= static_cast<uint16_t>(OpId::kCount) - kFusedOpCount ? 8u : 4u;
+}
+
+} // namespace rvi
@@ -4,43 +4,30 @@
 #include "rvi_decode_info.hpp"
 #include "rvi_instruction_interface.hpp"
 
-#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
-#include <vector>
-#include <utility>
 
 namespace rvi {
 
-using GetOpcodeGroupUniqueKeyFuncPtr = uint32_t (*)(InstructionDecodedCommonType);
-using DecodeInstructionToCommonTypeFuncPtr = InstructionDecodedCommonType (*)(uint32_t);
-using InstructionLookupResult = std::pair<const IInstruction*, InstructionDecodedCommonType>;
-
-class PerOpcodeGroup {
-private:
-    GetOpcodeGroupUniqueKeyFuncPtr get_key_;
-    DecodeInstructionToCommonTypeFuncPtr decode_instruction_;
-    std::vector<std::unique_ptr<IInstruction>> lookup_table_;
-
-public:
-    PerOpcodeGroup();
-    PerOpcodeGroup(size_t size,
-                   GetOpcodeGroupUniqueKeyFuncPtr get_key,
-                   DecodeInstructionToCommonTypeFuncPtr decode_instruction);
-    bool IsInit() const;
-    bool AddInstruction(std::unique_ptr<IInstruction> instr);
-    InstructionLookupResult GetInstruction(uint32_t instr) const;
+// Compile-time description of one major opcode: the format decoder and the
+// function reducing decoded fields to a dense key in [0, key_space).
+// The key -> instruction tables are generated from RVI_INSTRUCTION_LIST.
+template <uint32_t opcode, uint32_t key_space, auto get_key, auto decode>
+struct OpcodeGroup {
+    static constexpr uint32_t kOpcode   = opcode;
+    static constexpr uint32_t kKeySpace = key_space;
+
+    static constexpr uint32_t GetKey(const MicroOp& info) { return get_key(info); }
+    static MicroOp Decode(uint32_t instr) { return decode(instr); }
 };
-class InstructionRegistry {
-private:
-    std::array<PerOpcodeGroup, (1u << kOpcodeSize)> lookup_table_;
 
-public:
-    InstructionRegistry();
+// MicroOp::handler is the OpId of the instruction, kNoHandler if unknown.
+MicroOp DecodeInstruction(uint32_t instr);
 
-    bool RegisterInstruction(std::unique_ptr<IInstruction> instr);
-    bool RegisterGroup(PerOpcodeGroup group, uint32_t opcode);
-    InstructionLookupResult GetInstruction(uint32_t instr) const;
-};
+const IInstruction* GetInstructionHandler(uint16_t handler);
+
+// Runs decoded ops in order, dispatching on MicroOp::handler with a switch
+// over the static Exec implementations.
+void ExecuteOps(InterpreterState* state, const MicroOp* ops, size_t count);
 
 } // namespace
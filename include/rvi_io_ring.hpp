@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace rvi {
+
+// A minimal io_uring driven with the raw syscalls: operations are submitted
+// one at a time and their completions, which may arrive in any order, are
+// told apart by tag.
+class IoRing {
+public:
+    struct Completion {
+        uint64_t tag    = 0u;
+        int32_t  result = 0; // like the syscall: a count or -errno
+    };
+
+private:
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0u;
+    void* cq_ring_ = nullptr; // the same mapping as sq_ring_ on newer kernels
+    size_t cq_ring_size_ = 0u;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0u;
+
+    uint32_t* sq_head_ = nullptr;
+    uint32_t* sq_tail_ = nullptr;
+    uint32_t* sq_array_ = nullptr;
+    uint32_t sq_mask_ = 0u;
+    uint32_t sq_entries_ = 0u;
+    uint32_t* cq_head_ = nullptr;
+    uint32_t* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    uint32_t cq_mask_ = 0u;
+
+    // The next submission queue slot, zeroed; Submit passes it to the kernel.
+    io_uring_sqe* NextSqe();
+    void Submit();
+    void Release() noexcept;
+
+public:
+    IoRing() = default;
+    ~IoRing();
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    // Returns false if the kernel has no usable io_uring or does not allow
+    // it.
+    bool Init(uint32_t entries);
+
+    // Reads and writes use and advance the file position, like read(2) and
+    // write(2). Buffers must stay valid until the completion is taken.
+    void Read(int fd, void* data, uint32_t size, uint64_t tag);
+    void Write(int fd, const void* data, uint32_t size, uint64_t tag);
+
+    // Asks the kernel to cancel the operation with tag; both complete.
+    void Cancel(uint64_t tag, uint64_t cancel_tag);
+
+    // Blocks until an operation completes.
+    Completion Wait();
+};
+
+} // namespace
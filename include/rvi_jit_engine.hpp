@@ -0,0 +1,78 @@
+#pragma once
+
+#include "rvi_block_cache.hpp"
+#include "rvi_code_cache.hpp"
+#include "rvi_decode_info.hpp"
+#include "rvi_jit_x86_64.hpp"
+#include "rvi_state.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rvi {
+
+// Tiered engine: blocks are interpreted until they have run kHotThreshold
+// times, then they are translated to host code and run natively.
+// Direct exits of translated blocks are patched to jump straight to their
+// successor once it is translated, and jalr looks its target up in the
+// JitRuntime tables, so control only returns here for blocks that are not
+// translated yet.
+class JitEngine {
+public:
+    static constexpr uint32_t kHotThreshold = 32u;
+
+private:
+    struct Entry {
+        const BasicBlock* block = nullptr;
+        JitFunction code = nullptr;
+        const uint8_t* body = nullptr; // entered by linked exits
+        uint32_t exec_count = 0u;
+        bool not_translatable = false;
+        std::vector<MicroOp> ops{}; // referenced by the generated code
+        size_t code_size = 0u;
+        std::vector<JitLinks::PcMark> pcs{};
+        std::vector<const void**> return_slots{}; // baked into the code
+    };
+
+    // Waits for the block at some pc to be translated: either the rel32 of a
+    // direct exit or a return slot.
+    struct PendingLink {
+        const uint8_t* jump = nullptr;
+        const void**   slot = nullptr;
+    };
+
+    BlockCache* block_cache_;
+    CodeCache code_cache_;
+    std::unique_ptr<JitRuntime> runtime_;
+    std::unordered_map<uint32_t, Entry> entries_;
+    std::map<const uint8_t*, const Entry*> code_entries_; // by code address
+    std::unordered_map<uint32_t, std::vector<PendingLink>> pending_links_;
+    std::deque<const void*> return_slots_; // addresses are baked into the code
+    std::vector<uint8_t> code_buffer_;
+    JitLinks links_;
+
+    Entry& GetEntry(InterpreterState* state);
+    void Translate(Entry* entry);
+    void AddLink(uint32_t target_pc, const PendingLink& link);
+    void ResolveLink(const PendingLink& link, const uint8_t* body);
+    void DropLinksOf(const Entry& entry);
+    void FlushCode();
+    void InvalidateWrittenCode(InterpreterMemoryModel* memory);
+
+public:
+    explicit JitEngine(BlockCache* block_cache);
+
+    JitEngine(const JitEngine&) = delete;
+    JitEngine& operator=(const JitEngine&) = delete;
+
+    ExecutionStatus Run(InterpreterState* state);
+
+    // GuestPcLookup for MemoryGuard, engine is the JitEngine.
+    static bool LookupGuestPc(const void* engine, uintptr_t host_pc, uint32_t* guest_pc);
+};
+
+} // namespace
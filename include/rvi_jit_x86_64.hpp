@@ -0,0 +1,96 @@
+#pragma once
+
+#include "rvi_decode_info.hpp"
+#include "rvi_state.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rvi {
+
+// Entry point of a translated block. Returns the guest pc to continue at.
+using JitFunction = uint32_t (*)(InterpreterState* state, uint32_t* regs, uint8_t* memory);
+
+// Guest pc of a translated block and the host code of its body. Jump targets
+// are even, so kNoPc never matches.
+struct JitTarget {
+    static constexpr uint32_t kNoPc = 1u;
+
+    uint32_t    pc   = kNoPc;
+    const void* code = nullptr;
+};
+
+static_assert(sizeof(JitTarget) == 16u, "Generated code indexes JitTarget arrays by pc");
+
+// Prediction tables read by generated code on indirect jumps. The code embeds
+// their address, so the object must not move while translations exist.
+struct JitRuntime {
+    static constexpr uint32_t kIndirectCacheSize = 4096u;
+    static constexpr uint32_t kReturnStackSize   = 16u;
+
+    // Direct-mapped pc -> block cache, consulted by every jalr.
+    std::array<JitTarget, kIndirectCacheSize> indirect_cache{};
+    // Ring of return addresses pushed by calls (jal/jalr writing ra or t0)
+    // and popped by returns.
+    std::array<JitTarget, kReturnStackSize> return_stack{};
+    uint32_t return_top = 0u; // byte offset of the top entry
+
+    static constexpr uint32_t IndirectIndex(uint32_t pc) {
+        return (pc >> 2) & (kIndirectCacheSize - 1u);
+    }
+
+    void Remember(uint32_t pc, const void* code) { indirect_cache[IndirectIndex(pc)] = {pc, code}; }
+    void Reset() {
+        indirect_cache.fill({});
+        return_stack.fill({});
+        return_top = 0u;
+    }
+};
+
+// Places in a translated block that wait for other blocks to be translated.
+struct JitLinks {
+    // rel32 of a jmp that falls through to returning target_pc until it is
+    // patched to jump to the body of the target block.
+    struct Exit {
+        size_t   offset;
+        uint32_t target_pc;
+    };
+
+    // imm64 that must hold the address of a slot, where the engine stores the
+    // body of the block at return_pc once it is translated.
+    struct ReturnSite {
+        size_t   offset;
+        uint32_t return_pc;
+    };
+
+    // Start of the code of the op at pc, or of the part of a fused op at pc,
+    // for mapping faults back to the guest.
+    struct PcMark {
+        size_t   offset;
+        uint32_t pc;
+    };
+
+    size_t body_offset = 0u; // linked exits enter here, past the prologue
+    std::vector<Exit> exits{};
+    std::vector<ReturnSite> return_sites{};
+    std::vector<PcMark> pcs{};
+};
+
+// Translates the longest supported prefix of ops, starting at guest start_pc,
+// into position-independent x86-64 code appended to code. RV32I, the
+// multiplications and fused ops are emitted inline, other instructions call
+// their Exec with a pointer into ops, so ops must outlive the code. Offsets in
+// links are relative to the start of the block.
+// Returns the number of translated ops, 0 if the first op is not supported
+// (ecall, ebreak) or the host is not x86-64.
+size_t TranslateBlockX86_64(const MicroOp* ops, size_t count, uint32_t start_pc,
+                            JitRuntime* runtime, std::vector<uint8_t>* code, JitLinks* links);
+
+// Appends code that returns pc to the engine without touching guest state.
+// It is shorter than any translated block body, so the engine writes it over
+// the body of blocks whose guest code changed.
+void EmitExitStubX86_64(uint32_t pc, std::vector<uint8_t>* code);
+
+} // namespace
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace rvi {
+
+// A parsed JSON document, enough to read test manifests.
+class Json {
+public:
+    using Array  = std::vector<Json>;
+    using Object = std::vector<std::pair<std::string, Json>>; // in document order
+
+private:
+    std::variant<std::nullptr_t, bool, double, std::string, Array, Object> value_{};
+
+public:
+    Json() = default;
+    template <typename T>
+    explicit Json(T value) : value_(std::move(value)) {}
+
+    // Throws std::runtime_error naming the offset of the first error.
+    static Json Parse(std::string_view text);
+
+    // The value if it has that type, nullptr otherwise.
+    const bool*        AsBool() const noexcept { return std::get_if<bool>(&value_); }
+    const double*      AsNumber() const noexcept { return std::get_if<double>(&value_); }
+    const std::string* AsString() const noexcept { return std::get_if<std::string>(&value_); }
+    const Array*       AsArray() const noexcept { return std::get_if<Array>(&value_); }
+    const Object*      AsObject() const noexcept { return std::get_if<Object>(&value_); }
+
+    // Member of an object, nullptr if it is missing or this is no object.
+    const Json* Find(std::string_view key) const noexcept;
+};
+
+} // namespace
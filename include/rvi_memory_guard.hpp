@@ -0,0 +1,109 @@
+#pragma once
+
+#include "rvi_state.hpp"
+
+#include <csetjmp>
+#include <csignal>
+#include <cstdint>
+
+namespace rvi {
+
+// Finds the guest pc of a host instruction. Returns false if host_pc is not
+// in generated code.
+using GuestPcLookup = bool (*)(const void* context, uintptr_t host_pc, uint32_t* guest_pc);
+
+// Turns SIGSEGVs on guest memory into guest faults. With
+// FlatMemory::EnableGuards every page that was not loaded, protected or given
+// to the stack is inaccessible, so the host MMU checks guest accesses and the
+// accesses themselves stay unchecked.
+//
+// A fault longjmps out of the engine: the state is left as it was at the
+// faulting instruction and the engine must not be resumed. Only engine code
+// is jumped out of; host code it calls runs in a HostCodeScope. Guards on
+// different threads share the process's SIGSEGV handler, which is only
+// installed while memory with guards runs. PagedMemory checks accesses
+// itself and leaves through RaiseFault the same way.
+class MemoryGuard {
+public:
+    struct Fault {
+        uint32_t address = 0u;
+        uint32_t pc      = 0u; // of the faulting instruction
+    };
+
+private:
+    InterpreterState* state_;
+    const void* lookup_context_ = nullptr;
+    GuestPcLookup lookup_ = nullptr;
+    sigjmp_buf jump_{};
+    Fault fault_{};
+    bool handles_signals_ = false;
+
+    static void Handler(int signal, siginfo_t* info, void* context);
+
+    void Arm();
+    void Disarm() noexcept;
+
+public:
+    explicit MemoryGuard(InterpreterState* state);
+
+    MemoryGuard(const MemoryGuard&) = delete;
+    MemoryGuard& operator=(const MemoryGuard&) = delete;
+
+    // Generated code does not keep state->pc up to date, lookup maps the
+    // faulting host instruction back to the guest.
+    void SetGuestPcLookup(const void* context, GuestPcLookup lookup) {
+        lookup_context_ = context;
+        lookup_ = lookup;
+    }
+
+    // Runs fn(). Returns false if it was cut short by a guest memory fault,
+    // see GetFault. Flat memory without guards cannot fault, so fn() runs as
+    // is.
+    template <class Fn>
+    bool Run(Fn&& fn) {
+        if (InterpreterMemoryModel::kIsFlat && !state_->memory.IsGuarded()) {
+            fn();
+            return true;
+        }
+
+        Arm();
+        if (sigsetjmp(jump_, 1) != 0) {
+            Disarm();
+            return false;
+        }
+
+        try {
+            fn();
+        } catch (...) {
+            Disarm();
+            throw;
+        }
+        Disarm();
+        return true;
+    }
+
+    const Fault& GetFault() const noexcept { return fault_; }
+
+    // Cuts the guard armed on this thread short with a fault that memory
+    // found without the MMU, at the instruction at pc or at state->pc.
+    // Returns if no guard is armed, e.g. in a HostCodeScope.
+    static void RaiseFault(uint32_t address);
+    static void RaiseFault(uint32_t address, uint32_t pc);
+};
+
+// Host code the engine calls, such as syscalls, checks guest ranges before
+// touching them (see FlatMemory::ReadSpans) and is not jumped out of, which
+// would skip its destructors and lock releases. While a scope is alive, a
+// fault on the thread is a host bug for the previous SIGSEGV handler.
+class HostCodeScope {
+    MemoryGuard* guard_;
+
+public:
+    HostCodeScope() noexcept;
+    ~HostCodeScope();
+
+    HostCodeScope(const HostCodeScope&) = delete;
+    HostCodeScope& operator=(const HostCodeScope&) = delete;
+};
+
+} // namespace
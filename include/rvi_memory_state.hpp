@@ -1,27 +1,114 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <deque>
+#include <mutex>
 #include <span>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "loguru.hpp"
+#include "rvi_paged_memory.hpp"
 
 namespace rvi {
 
-class InterpreterMemoryModel {
+// Hands the code writes each view of one FlatMemory records to all the other
+// views, so a hart drops cached code another hart wrote over. Views are added
+// before the harts run.
+class SharedCodeWrites {
+    struct Inbox {
+        std::vector<CodeWrite> writes{};
+        std::atomic<bool> pending{false};
+    };
+
+    std::mutex mutex_{};
+    std::deque<Inbox> inboxes_{};
+
+public:
+    // Returns the new view's index.
+    size_t AddView();
+
+    bool HasPending(size_t view) const noexcept {
+        return inboxes_[view].pending.load(std::memory_order_relaxed);
+    }
+
+    // Sends writes to the other views, then appends those sent to view.
+    void Exchange(size_t view, std::vector<CodeWrite>* writes);
+};
+
+// The whole 32-bit guest space is one MAP_NORESERVE anonymous reservation:
+// pages are committed and zero-filled by the kernel on first touch, so
+// startup is cheap and RSS follows the guest's working set.
+// There are no permissions, every address is readable, writable and
+// executable, unless guards are enabled: then only loaded, protected and
+// stack pages are accessible and every other access raises SIGSEGV, which
+// MemoryGuard turns into a guest fault.
+class FlatMemory {
+public:
+    static constexpr bool kIsFlat = true;
+
+    // The code map has one byte per code granule, non-zero once MarkCode
+    // covered it. It sits right below guest address 0, so generated code
+    // reaches it from the memory base.
+    static constexpr int32_t kCodeMapOffset = -(1 << (32 - kCodeGranuleBits));
+
 private:
-    const size_t kMemorySize = 1ull << 32;
+    static constexpr size_t kMemorySize = 1ull << 32;
+    // Accesses that start near the top of the space may run past 4 GiB.
+    static constexpr size_t kTailSlack = 1ull << 16;
+    static constexpr size_t kCodeMapSize = kMemorySize >> kCodeGranuleBits;
+    // With guards, one byte per page below the code map holds the
+    // permissions Protect gave it, so host accesses are checked before they
+    // are made. Host pages are at least 4 KiB.
+    static constexpr size_t kPageMapSize = kMemorySize >> 12;
+    // Guest address 0 is aligned to this, so guest and host huge pages match.
+    static constexpr size_t kHugePageSize = 2u << 20;
+    static constexpr size_t kReservationSize =
+        kPageMapSize + kCodeMapSize + kMemorySize + kTailSlack + kHugePageSize;
 
 private:
-    std::vector<uint8_t> memory_;
+    uint8_t* reservation_ = nullptr;
+    uint8_t* memory_ = nullptr;
+    bool guarded_ = false;
+    bool huge_pages_ = false;
+    std::vector<CodeWrite> code_writes_{};
+    SharedCodeWrites* shared_code_writes_ = nullptr; // views of harts only
+    size_t view_ = 0u;
+
+    bool IsCode(uint32_t address, uint32_t size) const noexcept {
+        const uint8_t* code_map = memory_ + kCodeMapOffset;
+        return (code_map[address >> kCodeGranuleBits] |
+                code_map[(address + size - 1u) >> kCodeGranuleBits]) != 0u;
+    }
+
+    uint8_t* PageMap() const noexcept { return memory_ + kCodeMapOffset - kPageMapSize; }
+
+    // Without guards everything is accessible.
+    bool IsAccessible(uint32_t address, uint32_t size, uint8_t permission) const noexcept;
+    void SetPageMap(uintptr_t start, uintptr_t end, uint8_t permissions) noexcept;
 
 public:
-    InterpreterMemoryModel();
+    FlatMemory();
+    ~FlatMemory();
+
+    // Another view of the memory of owner, for a hart running on another
+    // thread: it shares the pages, guards and code map, and exchanges the
+    // code writes it records with the other views through shared. owner and
+    // shared must outlive it, and owner have its guards set up.
+    FlatMemory(FlatMemory* owner, SharedCodeWrites* shared);
+
+    FlatMemory(const FlatMemory&) = delete;
+    FlatMemory& operator=(const FlatMemory&) = delete;
+
+    size_t Size() const noexcept { return kMemorySize; }
+    static size_t PageSize() noexcept;
 
-    size_t Size() const noexcept { return memory_.size(); }
+    // Host address of guest address 0, the whole 32-bit space is backed.
+    uint8_t* Data() noexcept { return memory_; }
 
     template <typename T>
     T Get(uint32_t address) const;
@@ -29,23 +116,109 @@ public:
     template <typename T>
     void Set(uint32_t address, T value);
 
+    // Makes every page inaccessible, including the slack past 4 GiB. Must be
+    // called before anything is loaded.
+    void EnableGuards();
+    bool IsGuarded() const noexcept { return guarded_; }
+
+    // Asks the kernel to back guest memory with transparent huge pages.
+    // Returns false if the host does not support them; memory keeps working
+    // with normal pages. Segments mapped from files stay in normal pages.
+    bool EnableHugePages() noexcept;
+
+    // Reads /proc/self/smaps, so it is meant for reports, not hot paths.
+    MemoryUsage Usage() const;
+
+    // The accessible parts of the guest space in address order, from
+    // /proc/self/maps; anonymous pages the guest never touched have no data.
+    // Everything else is inaccessible, which only happens with guards.
+    std::vector<MemoryRegion> Regions() const;
+
+    // Guest address of a host address inside the reservation.
+    bool ToGuest(const void* host, uint32_t* address) const noexcept;
+
     void LoadBytes(uint32_t address, std::span<const uint8_t> data) {
         if (data.empty()) {
             return;
         }
+        if (guarded_) {
+            Unguard(address, data.size());
+        }
         std::memcpy(&memory_[address], data.data(), data.size());
     }
 
+    // Replaces [address, address + size) with a private copy-on-write mapping
+    // of the file, so untouched pages stay shared with the page cache.
+    // address, file_offset and size must be page-aligned.
+    void MapFile(uint32_t address, int fd, size_t file_offset, size_t size);
+
+    // Only has an effect with guards: pages without permissions become
+    // inaccessible, the others readable and, with kPermWrite, writable.
+    void Protect(uint32_t address, size_t size, uint8_t permissions);
+
+    // Replaces the pages of [address, address + size) with fresh zero-filled
+    // memory, inaccessible with guards. Cached code in them counts as
+    // written. address and size must be page-aligned.
+    void Discard(uint32_t address, size_t size);
+
+    // There are no execute permissions to check.
+    uint32_t Fetch(uint32_t address) const noexcept { return Read<uint32_t>(address); }
+    bool CanFetch(uint32_t /*address*/) const noexcept { return true; }
+
+    // Appends the host memory of [address, address + size) for bulk reads,
+    // two spans if the range wraps around. Returns false if, with guards,
+    // part of it is not readable, so the host never faults on guest memory.
+    bool ReadSpans(uint32_t address, uint32_t size, std::vector<std::span<const uint8_t>>* spans) const;
+
+    // The same for bulk writes by the host, which are checked for code
+    // writes as a whole. Returns false if part of it is not writable.
+    bool WriteSpans(uint32_t address, uint32_t size, std::vector<std::span<uint8_t>>* spans);
+
+    // Marks [begin, end) as decoded into a cache. Stores overlapping it are
+    // recorded until TakeCodeWrites, which of a view also returns the code
+    // writes of the other views.
+    void MarkCode(uint32_t begin, uint32_t end);
+    bool HasCodeWrites() const noexcept {
+        return !code_writes_.empty() ||
+               (shared_code_writes_ != nullptr && shared_code_writes_->HasPending(view_));
+    }
+    std::vector<CodeWrite> TakeCodeWrites();
+    void AddCodeWrites(std::span<const CodeWrite> writes) {
+        code_writes_.insert(code_writes_.end(), writes.begin(), writes.end());
+    }
+
+    // Word accesses of the A extension, atomic with respect to harts on
+    // other threads if address is aligned; misaligned ones are plain
+    // accesses. AtomicUpdate stores fn(old) and returns old.
+    uint32_t AtomicLoad(uint32_t address) const noexcept;
+    template <typename Fn>
+    uint32_t AtomicUpdate(uint32_t address, Fn fn);
+    bool CompareExchange(uint32_t address, uint32_t expected, uint32_t desired);
+
     template <typename T>
     T Read(uint32_t address) const noexcept {
         T value{};
         std::memcpy(&value, &memory_[address], sizeof(T));
         return value;
     }
+
+private:
+    void Unguard(uint32_t address, size_t size);
+
+    std::atomic_ref<uint32_t> Word(uint32_t address) const noexcept {
+        return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(&memory_[address]));
+    }
 };
 
+// Backend of the guest address space, chosen at build time.
+#ifdef RVI_PAGED_MEMORY
+using InterpreterMemoryModel = PagedMemory;
+#else
+using InterpreterMemoryModel = FlatMemory;
+#endif
+
 template <typename T>
-T InterpreterMemoryModel::Get(uint32_t address) const {
+T FlatMemory::Get(uint32_t address) const {
     DLOG_F(INFO, "Getting mem[%x] ...", address);
 
     T value{};
@@ -61,14 +234,57 @@ T InterpreterMemoryModel::Get(uint32_t address) const {
 }
 
 template <typename T>
-void InterpreterMemoryModel::Set(uint32_t address, T value) {
+void FlatMemory::Set(uint32_t address, T value) {
     {
         uint32_t debug_value = 0;
         std::memcpy(&debug_value, &value, sizeof(value));
         DLOG_F(INFO, "Setting mem[%x] = %x", address, debug_value);
     }
 
+    if (IsCode(address, sizeof(T))) [[unlikely]] {
+        code_writes_.push_back({address, sizeof(T)});
+    }
     std::memcpy(&memory_[address], &value, sizeof(T));
 }
 
+inline uint32_t FlatMemory::AtomicLoad(uint32_t address) const noexcept {
+    if (address % sizeof(uint32_t) != 0u) [[unlikely]] {
+        return Read<uint32_t>(address);
+    }
+    return Word(address).load();
+}
+
+template <typename Fn>
+uint32_t FlatMemory::AtomicUpdate(uint32_t address, Fn fn) {
+    if (address % sizeof(uint32_t) != 0u) [[unlikely]] {
+        const auto old = Get<uint32_t>(address);
+        Set<uint32_t>(address, fn(old));
+        return old;
+    }
+
+    if (IsCode(address, sizeof(uint32_t))) [[unlikely]] {
+        code_writes_.push_back({address, sizeof(uint32_t)});
+    }
+    const auto word = Word(address);
+    uint32_t old = word.load(std::memory_order_relaxed);
+    while (!word.compare_exchange_weak(old, fn(old))) {
+    }
+    return old;
+}
+
+inline bool FlatMemory::CompareExchange(uint32_t address, uint32_t expected, uint32_t desired) {
+    if (address % sizeof(uint32_t) != 0u) [[unlikely]] {
+        if (Get<uint32_t>(address) != expected) {
+            return false;
+        }
+        Set<uint32_t>(address, desired);
+        return true;
+    }
+
+    if (IsCode(address, sizeof(uint32_t))) [[unlikely]] {
+        code_writes_.push_back({address, sizeof(uint32_t)});
+    }
+    return Word(address).compare_exchange_strong(expected, desired);
+}
+
 } // namespace
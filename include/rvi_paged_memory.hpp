@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "loguru.hpp"
+
+namespace rvi {
+
+enum MemoryPermission : uint8_t {
+    kPermRead  = 1u << 0,
+    kPermWrite = 1u << 1,
+    kPermExec  = 1u << 2,
+};
+
+// Both backends track where cached code was decoded from in granules this
+// small, so stores to data next to code rarely look like code writes.
+constexpr uint32_t kCodeGranuleBits = 6u;
+
+// Host memory behind the guest space.
+struct MemoryUsage {
+    size_t resident_bytes  = 0u;
+    size_t huge_page_bytes = 0u; // part of resident_bytes
+};
+
+// Part of the guest space as listed by Regions. data is the host memory
+// behind it, nullptr for pages that were never touched and read as zero.
+struct MemoryRegion {
+    uint32_t address;
+    uint64_t size;
+    uint8_t permissions;
+    const uint8_t* data;
+};
+
+// A guest store that overlapped memory marked with MarkCode.
+struct CodeWrite {
+    uint32_t address;
+    uint32_t size;
+};
+
+// Sparse guest memory: 4 KiB pages in a two-level page table, allocated on
+// first write, each with R/W/X permissions and a dirty bit. Untouched pages
+// read as zero without being allocated.
+//
+// Get/Set go through direct-mapped read and write TLBs. A hit costs one
+// compare and one add; misaligned accesses always take the slow path, which
+// also handles accesses crossing a page. Write TLB entries are only filled
+// for writable pages without code and mark them dirty, so a hit needs no
+// further checks.
+// Permission violations are guest faults under a MemoryGuard and throw
+// std::runtime_error elsewhere.
+class PagedMemory {
+public:
+    static constexpr bool     kIsFlat    = false;
+    static constexpr uint32_t kPageBits  = 12u;
+    static constexpr uint32_t kPageSize  = 1u << kPageBits;
+    static constexpr uint32_t kTlbSize   = 256u;
+    static constexpr size_t   kMaxPages  = (1ull << 32) >> kPageBits;
+
+    // Permissions of pages nobody has protected, e.g. the stack.
+    static constexpr uint8_t kDefaultPermissions = kPermRead | kPermWrite;
+
+private:
+    static constexpr uint32_t kLevelBits = 10u;
+    static constexpr uint32_t kLevelSize = 1u << kLevelBits;
+    static constexpr uint32_t kPageMask  = kPageSize - 1u;
+    // Tags are page addresses with at most the low 3 bits set, see Key.
+    static constexpr uint32_t kInvalidTag = kPageMask;
+
+    struct Page {
+        std::array<uint8_t, kPageSize> data{};
+        std::bitset<(kPageSize >> kCodeGranuleBits)> code{};
+        uint8_t permissions = kDefaultPermissions;
+        bool dirty = false;
+    };
+
+    using PageTable = std::array<std::unique_ptr<Page>, kLevelSize>;
+
+    struct TlbEntry {
+        uint32_t  tag = kInvalidTag;
+        uintptr_t addend = 0u; // host address = addend + guest address
+    };
+
+    std::array<std::unique_ptr<PageTable>, kLevelSize> directory_{};
+    mutable std::array<TlbEntry, kTlbSize> read_tlb_{};
+    std::array<TlbEntry, kTlbSize> write_tlb_{};
+    size_t page_count_ = 0u;
+    size_t page_limit_;
+    std::vector<CodeWrite> code_writes_{};
+
+    // Aligned accesses keep the page address, misaligned ones get low bits
+    // set and never match a tag.
+    template <typename T>
+    static constexpr uint32_t Key(uint32_t address) {
+        return address & (~kPageMask | static_cast<uint32_t>(sizeof(T) - 1u));
+    }
+    static constexpr uint32_t TlbIndex(uint32_t address) {
+        return (address >> kPageBits) % kTlbSize;
+    }
+
+    Page* FindPage(uint32_t address) const noexcept;
+    Page& GetOrCreatePage(uint32_t address);
+    void FlushTlb() noexcept;
+
+    const uint8_t* TranslateRead(uint32_t address) const;
+    uint8_t* TranslateWrite(uint32_t address);
+    bool IsCode(uint32_t address) const noexcept;
+    void ReadSlow(uint32_t address, void* dst, size_t size) const;
+    void WriteSlow(uint32_t address, const void* src, size_t size);
+
+public:
+    PagedMemory() : PagedMemory(kMaxPages) {}
+    explicit PagedMemory(size_t page_limit);
+
+    PagedMemory(const PagedMemory&) = delete;
+    PagedMemory& operator=(const PagedMemory&) = delete;
+
+    size_t Size() const noexcept { return 1ull << 32; }
+    static size_t PageSize() noexcept { return kPageSize; }
+
+    // There is no flat host mapping of the guest space.
+    uint8_t* Data() noexcept { return nullptr; }
+
+    // Accesses are always checked, there are no guard regions.
+    void EnableGuards() noexcept {}
+    bool IsGuarded() const noexcept { return false; }
+    bool ToGuest(const void* /*host*/, uint32_t* /*address*/) const noexcept { return false; }
+
+    // Pages are allocated one by one, so they cannot be huge.
+    bool EnableHugePages() noexcept { return false; }
+    MemoryUsage Usage() const noexcept { return {page_count_ * kPageSize, 0u}; }
+
+    // Allocated pages, bounded by page_limit.
+    size_t PageCount() const noexcept { return page_count_; }
+
+    template <typename T>
+    T Get(uint32_t address) const {
+        T value{};
+        const auto& entry = read_tlb_[TlbIndex(address)];
+        if (entry.tag == Key<T>(address)) {
+            std::memcpy(&value, reinterpret_cast<const void*>(entry.addend + address), sizeof(T));
+        } else {
+            ReadSlow(address, &value, sizeof(T));
+        }
+        return value;
+    }
+
+    template <typename T>
+    void Set(uint32_t address, T value) {
+        const auto& entry = write_tlb_[TlbIndex(address)];
+        if (entry.tag == Key<T>(address)) {
+            std::memcpy(reinterpret_cast<void*>(entry.addend + address), &value, sizeof(T));
+        } else {
+            WriteSlow(address, &value, sizeof(T));
+        }
+    }
+
+    // Instruction fetch, requires execute permission. CanFetch checks it
+    // without faulting.
+    uint32_t Fetch(uint32_t address) const;
+    bool CanFetch(uint32_t address) const noexcept;
+
+    // Reads without permission checks.
+    template <typename T>
+    T Read(uint32_t address) const noexcept {
+        T value{};
+        auto* bytes = reinterpret_cast<uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            const Page* page = FindPage(address + static_cast<uint32_t>(i));
+            if (page != nullptr) {
+                bytes[i] = page->data[(address + i) & kPageMask];
+            }
+        }
+        return value;
+    }
+
+    // Loader writes, ignore permissions.
+    void LoadBytes(uint32_t address, std::span<const uint8_t> data);
+    void MapFile(uint32_t address, int fd, size_t file_offset, size_t size);
+
+    // Sets the permissions of every page in [address, address + size).
+    void Protect(uint32_t address, size_t size, uint8_t permissions);
+
+    // Frees every page in [address, address + size): they read as zero again
+    // and get the default permissions. Cached code in them counts as written.
+    void Discard(uint32_t address, size_t size);
+
+    // Appends the host memory of [address, address + size) for bulk reads,
+    // one span per page. Returns false if a page is not readable.
+    bool ReadSpans(uint32_t address, uint32_t size, std::vector<std::span<const uint8_t>>* spans) const;
+
+    // The same for bulk writes by the host, allocating missing pages.
+    // Returns false if a page is not writable.
+    bool WriteSpans(uint32_t address, uint32_t size, std::vector<std::span<uint8_t>>* spans);
+
+    // Marks [begin, end) as decoded into a cache. Stores overlapping it are
+    // recorded until TakeCodeWrites.
+    void MarkCode(uint32_t begin, uint32_t end);
+    bool HasCodeWrites() const noexcept { return !code_writes_.empty(); }
+    std::vector<CodeWrite> TakeCodeWrites() { return std::exchange(code_writes_, {}); }
+    void AddCodeWrites(std::span<const CodeWrite> writes) {
+        code_writes_.insert(code_writes_.end(), writes.begin(), writes.end());
+    }
+
+    // Word accesses of the A extension. Paged memory has a single hart, so
+    // they are plain accesses. AtomicUpdate stores fn(old) and returns old.
+    uint32_t AtomicLoad(uint32_t address) const { return Get<uint32_t>(address); }
+    template <typename Fn>
+    uint32_t AtomicUpdate(uint32_t address, Fn fn) {
+        const auto old = Get<uint32_t>(address);
+        Set<uint32_t>(address, fn(old));
+        return old;
+    }
+    bool CompareExchange(uint32_t address, uint32_t expected, uint32_t desired) {
+        if (Get<uint32_t>(address) != expected) {
+            return false;
+        }
+        Set<uint32_t>(address, desired);
+        return true;
+    }
+
+    // Every allocated page, in address order; the others read as zero with
+    // the default permissions.
+    std::vector<MemoryRegion> Regions() const;
+
+    // Calls fn(page_address, page_bytes) for every page written since the
+    // last ClearDirty.
+    template <typename Fn>
+    void ForEachDirtyPage(Fn&& fn) const {
+        for (uint32_t i = 0; i < kLevelSize; ++i) {
+            if (!directory_[i]) {
+                continue;
+            }
+            for (uint32_t j = 0; j < kLevelSize; ++j) {
+                const Page* page = (*directory_[i])[j].get();
+                if (page != nullptr && page->dirty) {
+                    const uint32_t page_address = ((i << kLevelBits) | j) << kPageBits;
+                    fn(page_address, std::span<const uint8_t>(page->data));
+                }
+            }
+        }
+    }
+
+    void ClearDirty() noexcept;
+};
+
+} // namespace
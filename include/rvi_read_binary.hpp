@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <span>
 #include <string>
@@ -9,9 +10,21 @@
 
 namespace rvi {
 
+// Where a loaded image lies; the initial stack tells the guest about it.
+struct ImageInfo {
+    uint32_t entry_point = 0u;
+    uint32_t end         = 0u; // end of the highest segment, where the heap starts
+    uint32_t phdr        = 0u; // guest address of the program headers, 0 if not loaded
+    uint32_t phent       = 0u;
+    uint32_t phnum       = 0u;
+};
+
 class ReadBinary {
     std::string path_;
     MMapRO mmap_;
+
+    void LoadSegment(InterpreterMemoryModel* memory, int fd, uint32_t vaddr,
+                     std::size_t file_off, std::size_t file_sz) const;
 public:
     struct SectionInfo {
         std::span<const uint8_t> section;
@@ -21,7 +34,7 @@ public:
     ReadBinary(std::string_view path);
 
     SectionInfo GetTextSectionView() const;
-    void LoadIntoMemory(InterpreterMemoryModel* memory, uint32_t* entry_point) const;
+    void LoadIntoMemory(InterpreterMemoryModel* memory, ImageInfo* image) const;
 };
 
 } // namespace
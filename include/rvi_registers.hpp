@@ -28,6 +28,9 @@ public:
         regs_[index] = value;
     }
 
+    // Raw storage for generated code, which must never write x0.
+    uint32_t* Data() noexcept { return regs_.data(); }
+
 private:
     std::array<uint32_t, kNumRegs> regs_{};
 };
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "rvi_block_cache.hpp"
+#include "rvi_guest_io.hpp"
+#include "rvi_jit_engine.hpp"
+#include "rvi_memory_guard.hpp"
+#include "rvi_state.hpp"
+#include "rvi_threaded_engine.hpp"
+#include "rvi_vfs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace rvi {
+
+enum class Engine {
+    Block,
+    Threaded,
+    Jit,
+};
+
+// One guest program run inside the host process; the embedding API of
+// librvi. The decode and dispatch tables are compile-time constants shared by
+// every session, so a session only owns its guest memory, caches and I/O.
+// Sessions are independent and may run on different threads, one thread per
+// session at a time.
+class Session {
+public:
+    struct Options {
+        Engine engine = Engine::Block;
+        bool safe = false;       // see FlatMemory::EnableGuards
+        bool huge_pages = false; // see FlatMemory::EnableHugePages
+        bool io_uring = false;   // see GuestIo::EnableIoUring
+        size_t output_buffer = GuestIo::kDefaultOutputBuffer;
+        std::shared_ptr<const FsImage> fs{}; // the host file system if null
+        // Host directory relative guest paths start from, the process's
+        // working directory if empty; see GuestIo::SetDirectory.
+        std::string directory{};
+        std::vector<std::string> env{};
+        // Harts sharing the guest memory, each on its own host thread; see
+        // Load and Run. More than one needs flat memory and no jit.
+        uint32_t harts = 1u;
+    };
+
+    enum class Status {
+        Paused, // the instruction budget ran out
+        Exited,
+        Faulted,
+    };
+
+    static constexpr uint64_t kNoLimit = INT64_MAX;
+
+    // Exit code of a process killed by SIGSEGV.
+    static constexpr int32_t kFaultExitCode = 128 + 11;
+
+    static constexpr uint32_t kMaxHarts = 64u;
+
+private:
+    Options options_;
+    std::unique_ptr<InterpreterState> state_;
+    BlockCache block_cache_{}; // outlives the engines, which refer to it
+    std::unique_ptr<ThreadedEngine> threaded_engine_{};
+    std::unique_ptr<JitEngine> jit_engine_{};
+    MemoryGuard::Fault fault_{};
+    uint64_t instructions_ = 0u;
+    bool loaded_ = false;
+    bool ran_ = false;
+
+    // With several harts, each has its own registers, caches and engine on
+    // the memory of state_, which then keeps the guest's files, heap and
+    // exit status, and hart 0's registers between runs.
+    struct Hart {
+        std::unique_ptr<InterpreterState> state{};
+        BlockCache block_cache{};
+        std::unique_ptr<ThreadedEngine> threaded_engine{};
+    };
+    std::vector<std::unique_ptr<Hart>> harts_{};
+    HartGroup hart_group_{};
+
+    // Where RunToMarker stops, see RunToRead and RunToPc.
+    struct Marker {
+        bool at_read = false;
+        bool at_pc = false;
+        uint32_t pc = 0u;
+    };
+
+    static void RunBlocks(InterpreterState* state, BlockCache* block_cache, int64_t* budget);
+    void AddHarts(std::span<const uint32_t> stacks);
+    Status RunHarts(uint64_t max_instructions);
+    uint64_t RunHart(Hart* hart, int64_t limit, std::exception_ptr* error);
+    void RunBlocksTo(const Marker& marker);
+    Status RunToMarker(const Marker& marker);
+    void RecordFault(const MemoryGuard& guard);
+    Status CurrentStatus() const noexcept;
+
+public:
+    Session();
+    explicit Session(Options options);
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Loads an ELF executable and sets up its stack, with argv[0] = path
+    // followed by args, and its heap. A session loads one program. Throws
+    // std::runtime_error if the file is not a loadable RV32 executable.
+    //
+    // With several harts, all of them start at the entry point with their
+    // id in a0 and a stack of their own; hart 0 gets the one holding argv.
+    // The guest's start-up code sends the others to their work.
+    void Load(const std::string& path, std::span<const std::string> args = {});
+
+    // Continues a guest saved with Save, in place of Load. Throws
+    // std::runtime_error if the file is no checkpoint this build can restore.
+    // Checkpoints hold a single hart.
+    void Restore(const std::string& path);
+
+    // Writes a checkpoint of the guest (see SaveCheckpoint) between runs, e.g.
+    // after a warm-up phase or when paused for host maintenance.
+    void Save(const std::string& path);
+
+    // Replace the host's standard streams; call before Run.
+    void SetStdin(std::vector<uint8_t> data) { state_->io.SetInput(std::move(data)); }
+    void SetStdout(OutputSink sink) { state_->io.SetOutput(GuestIo::kStdout, std::move(sink)); }
+    void SetStderr(OutputSink sink) { state_->io.SetOutput(GuestIo::kStderr, std::move(sink)); }
+
+    // Runs until the guest exits, faults or has run at least max_instructions
+    // more instructions; the budget is checked at basic block ends. A paused
+    // session continues where it stopped on the next Run. The jit engine only
+    // runs without a limit.
+    //
+    // With several harts the limit holds for each of them. exit stops the
+    // calling hart, the guest ends with exit_group, an exit of hart 0 or a
+    // fault on any hart. Code a hart modifies is decoded again by every hart
+    // at its next block end.
+    Status Run(uint64_t max_instructions = kNoLimit);
+
+    // Run the guest's start-up code up to a point worth snapshotting, e.g.
+    // with fork (see ServeForks): until it is about to make its first read or
+    // readv syscall, or until pc is about to run. Both return Paused there,
+    // whatever the engine, since they interpret the start-up code with the
+    // block engine. Call them before Run, with a single hart.
+    Status RunToRead();
+    Status RunToPc(uint32_t pc);
+
+    const Options& GetOptions() const noexcept { return options_; }
+
+    // Registers, pc, memory and I/O of the guest; hart 0's registers and pc
+    // with several harts.
+    InterpreterState& State() noexcept { return *state_; }
+    const InterpreterState& State() const noexcept { return *state_; }
+
+    // The guest's exit code, kFaultExitCode after a fault.
+    int32_t ExitCode() const noexcept { return state_->return_code; }
+    const MemoryGuard::Fault& GetFault() const noexcept { return fault_; }
+
+    // Instructions run so far by all harts; the jit engine does not count them.
+    uint64_t Instructions() const noexcept { return instructions_; }
+};
+
+} // namespace
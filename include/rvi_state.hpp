@@ -1,17 +1,65 @@
 #pragma once
 
+#include "rvi_guest_io.hpp"
 #include "rvi_memory_state.hpp"
 #include "rvi_registers.hpp"
+#include "rvi_vfs.hpp"
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 
 namespace rvi {
 
+enum class ExecutionStatus {
+    Success = 0,
+    Exit = 1,
+    Fault = 2,
+};
+
+// Guest memory handed out by brk and mmap. The break grows up from the end of
+// the loaded image, mmap takes pages downwards from mmap_end; the two meet at
+// mmap_start, the lowest mapped address.
+struct GuestHeap {
+    uint32_t brk_start  = 0u;
+    uint32_t brk        = 0u;
+    uint32_t mmap_start = 0u;
+    uint32_t mmap_end   = 0u;
+};
+
+// Set by lr.w for the next sc.w, which only stores if the word still holds
+// value. A store of the same value in between goes unnoticed.
+struct Reservation {
+    bool     valid   = false;
+    uint32_t address = 0u;
+    uint32_t value   = 0u;
+};
+
+struct InterpreterState;
+
+// What the harts of a guest running on several host threads share besides
+// memory. Every hart has its own InterpreterState; their syscalls run one at
+// a time on the files and heap of process, which runs no code itself. exit
+// stops the calling hart, exit_group or an exit of main stop the guest.
+struct HartGroup {
+    InterpreterState* process = nullptr;
+    const InterpreterState* main = nullptr; // hart 0
+    std::mutex mutex{};
+    std::atomic<bool> stopped{false}; // checked by every hart between slices
+    SharedCodeWrites code_writes{};   // of the harts' memory views
+};
+
 struct InterpreterState {
-    InterpreterRegisters regs;
-    InterpreterRegistersFloat f_regs;
-    uint32_t pc;
-    InterpreterMemoryModel memory;
-    int32_t return_code;
+    InterpreterRegisters regs{};
+    InterpreterRegistersFloat f_regs{};
+    uint32_t pc = 0u;
+    InterpreterMemoryModel memory{};
+    int32_t return_code = 0;
+    ExecutionStatus status = ExecutionStatus::Success; // set by instructions, checked between blocks
+    Vfs vfs{}; // files the guest can open if mounted, the host's otherwise
+    GuestIo io{};
+    GuestHeap heap{};
+    Reservation reservation{};
+    HartGroup* harts = nullptr; // null if the guest has a single hart
 };
 
 } // namespace
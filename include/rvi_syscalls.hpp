@@ -0,0 +1,36 @@
+#pragma once
+
+#include "rvi_state.hpp"
+
+#include <cstdint>
+
+namespace rvi {
+
+// Numbers of the Linux asm-generic syscall table, which RISC-V uses.
+enum class Syscall : uint32_t {
+    Openat         = 56,
+    Close          = 57,
+    Lseek          = 62,
+    Read           = 63,
+    Write          = 64,
+    Readv          = 65,
+    Writev         = 66,
+    Fstat          = 80,
+    Exit           = 93,
+    ExitGroup      = 94,
+    ClockGettime   = 113,
+    Gettimeofday   = 169,
+    Brk            = 214,
+    Munmap         = 215,
+    Mmap           = 222,
+    ClockGettime64 = 403,
+};
+
+// Runs the syscall numbered by a7 with arguments a0-a5 and returns its result
+// in a0: a value or -errno, like the kernel. Unknown syscalls fail with
+// -ENOSYS. Struct layouts are those newlib and picolibc use on rv32, with
+// 64-bit time_t; lseek takes and returns a 32-bit offset as in newlib.
+// Does not advance pc.
+void ExecSyscall(InterpreterState* state);
+
+} // namespace
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace rvi {
+
+// Runs a batch of independent tasks on a fixed number of host threads. Each
+// worker owns a deque of task indices seeded round-robin, takes from its
+// back and, once empty, steals from the front of the other deques, so uneven
+// tasks still keep every thread busy.
+class ThreadPool {
+    size_t threads_;
+
+public:
+    // 0 threads means one per hardware thread.
+    explicit ThreadPool(size_t threads);
+
+    size_t Threads() const noexcept { return threads_; }
+
+    // Calls task(i) for every i in [0, count) and returns when all are done.
+    // If tasks throw, the remaining tasks still run and the first exception
+    // is rethrown.
+    void Run(size_t count, const std::function<void(size_t)>& task);
+};
+
+} // namespace
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "rvi_block_cache.hpp"
+#include "rvi_decode_info.hpp"
+#include "rvi_instruction_interface.hpp"
+#include "rvi_state.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rvi {
+
+// Direct-threaded execution engine: blocks from the BlockCache are translated
+// once into a stream of handler addresses, and every handler jumps straight
+// to the handler of the next op instead of returning to a dispatch loop.
+class ThreadedEngine {
+public:
+    struct Op {
+        const void* handler;
+        MicroOp     info;
+    };
+
+    // ops always ends with a block-exit op that looks up the next block.
+    struct Block {
+        std::vector<Op> ops{};
+        uint32_t instructions = 0u; // guest instructions, before fusion
+    };
+
+private:
+    BlockCache* block_cache_;
+    std::unordered_map<uint32_t, std::unique_ptr<Block>> blocks_;
+
+public:
+    explicit ThreadedEngine(BlockCache* block_cache);
+
+    ThreadedEngine(const ThreadedEngine&) = delete;
+    ThreadedEngine& operator=(const ThreadedEngine&) = delete;
+
+    // Runs until the guest stops or, checked at block ends, *budget
+    // instructions have run; *budget is decreased by the instructions run.
+    ExecutionStatus Run(InterpreterState* state, int64_t* budget);
+};
+
+} // namespace
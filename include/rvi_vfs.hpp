@@ -0,0 +1,117 @@
+#pragma once
+
+#include "rvi_mmap_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+namespace rvi {
+
+// A read-only file tree loaded once from a tar archive or a host directory.
+// Archives are mapped and served in place, directories are read into memory.
+// Guests share an image through a shared_ptr; none of them can change it.
+class FsImage {
+public:
+    struct Node {
+        std::span<const uint8_t> data{}; // empty for directories
+        uint32_t mode  = 0u;             // file type and permission bits
+        int64_t  mtime = 0;
+        uint64_t ino   = 0u;
+    };
+
+private:
+    std::optional<MMapRO> archive_{};
+    std::vector<std::vector<uint8_t>> contents_{};
+    std::unordered_map<std::string, Node> nodes_{};
+
+    void Add(const std::string& path, Node node);
+    void LoadTar();
+    void LoadDirectory(const std::string& root);
+
+public:
+    FsImage() = default;
+
+    FsImage(const FsImage&) = delete;
+    FsImage& operator=(const FsImage&) = delete;
+
+    // path is a directory or a tar archive. Throws std::runtime_error if it
+    // cannot be read.
+    static std::shared_ptr<const FsImage> Load(const std::string& path);
+
+    // path is absolute and normalized, see Vfs::Resolve.
+    const Node* Find(const std::string& path) const;
+};
+
+// A file the guest created or opened for writing, private to one Vfs.
+struct OverlayFile {
+    std::vector<uint8_t> data{};
+    uint32_t mode  = 0u;
+    int64_t  mtime = 0;
+    uint64_t ino   = 0u;
+};
+
+// An open file description of a Vfs.
+class VfsFile {
+    std::string path_;
+    const FsImage::Node* node_ = nullptr;   // an image file or directory,
+    std::shared_ptr<OverlayFile> overlay_;  // or an overlay file
+    bool readable_ = false;
+    bool writable_ = false;
+    bool append_   = false;
+    uint64_t position_ = 0u;
+
+public:
+    VfsFile(std::string path, const FsImage::Node* node, std::shared_ptr<OverlayFile> overlay,
+            bool readable, bool writable, bool append);
+
+    VfsFile(const VfsFile&) = delete;
+    VfsFile& operator=(const VfsFile&) = delete;
+
+    const std::string& Path() const noexcept { return path_; }
+    bool IsDirectory() const noexcept;
+    std::span<const uint8_t> Data() const noexcept;
+
+    // Copies from offset into data, returns the number of bytes copied.
+    size_t ReadAt(uint64_t offset, std::span<uint8_t> data) const noexcept;
+
+    // read(2), write(2) and lseek(2) at the file position. Return a count or
+    // offset, or -errno.
+    int64_t Read(std::span<const std::span<uint8_t>> spans);
+    int64_t Write(std::span<const std::span<const uint8_t>> spans);
+    int64_t Seek(int64_t offset, int whence);
+
+    void Stat(struct stat* st) const noexcept;
+};
+
+// One guest's view of an FsImage. Reads are served from the shared image;
+// files the guest creates, truncates or opens for writing are copied into a
+// private overlay first. Nothing on the host file system is visible. The
+// working directory is /.
+class Vfs {
+    std::shared_ptr<const FsImage> image_{};
+    std::unordered_map<std::string, std::shared_ptr<OverlayFile>> overlay_{};
+    uint64_t next_ino_ = 1u << 30;
+
+    bool IsDirectory(const std::string& path) const;
+
+public:
+    void Mount(std::shared_ptr<const FsImage> image) { image_ = std::move(image); }
+    bool IsMounted() const noexcept { return image_ != nullptr; }
+
+    // Absolute path of path relative to base, with ".", ".." and repeated
+    // slashes removed.
+    static std::string Resolve(std::string_view base, std::string_view path);
+
+    // open(2) with host O_* flags. Returns 0 or -errno.
+    int32_t Open(const std::string& path, int flags, uint32_t mode, std::unique_ptr<VfsFile>* file);
+};
+
+} // namespace
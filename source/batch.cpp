@@ -0,0 +1,382 @@
+#include "rvi_json.hpp"
+#include "rvi_session.hpp"
+#include "rvi_thread_pool.hpp"
+#include "rvi_vfs.hpp"
+
+#include "cxxopts.hpp"
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Runs test manifests in the format of tests/cases/*.json in one process, every
+// case in its own Session, spread over a thread pool; see tests/run_tests.py.
+
+namespace {
+
+struct Case {
+    std::string name{};
+    std::vector<std::string> args{};
+    std::vector<uint8_t> stdin_data{};
+    std::vector<uint8_t> stdout_data{};
+    int64_t exit_code = 0;
+    uint32_t harts = 1u;
+    bool safe = false;
+};
+
+struct Spec {
+    std::string binary{};
+    std::filesystem::path path{};
+    std::vector<Case> cases{};
+};
+
+struct Result {
+    bool skipped = false; // several harts on the jit engine
+    std::vector<std::string> issues{};
+    std::vector<uint8_t> stdout_data{};
+    std::vector<uint8_t> stderr_data{};
+};
+
+std::vector<uint8_t> DecodeHex(const std::string& raw, const std::string& context) {
+    std::string cleaned;
+    for (char c : raw) {
+        if (!std::isspace(static_cast<unsigned char>(c)) && c != '_') {
+            cleaned.push_back(c);
+        }
+    }
+    if (cleaned.starts_with("0x") || cleaned.starts_with("0X")) {
+        cleaned.erase(0, 2);
+    }
+    if (cleaned.size() % 2u != 0u) {
+        throw std::runtime_error(context + ": hex data has odd length");
+    }
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(cleaned.size() / 2u);
+    for (size_t i = 0u; i < cleaned.size(); i += 2u) {
+        if (!std::isxdigit(static_cast<unsigned char>(cleaned[i])) ||
+            !std::isxdigit(static_cast<unsigned char>(cleaned[i + 1u]))) {
+            throw std::runtime_error(context + ": invalid hex data");
+        }
+        bytes.push_back(static_cast<uint8_t>(std::stoul(cleaned.substr(i, 2u), nullptr, 16)));
+    }
+    return bytes;
+}
+
+std::string Hex(const std::vector<uint8_t>& bytes) {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(bytes.size() * 2u);
+    for (uint8_t byte : bytes) {
+        out.push_back(kDigits[byte >> 4]);
+        out.push_back(kDigits[byte & 0xFu]);
+    }
+    return out;
+}
+
+std::vector<uint8_t> HexField(const rvi::Json& json, const std::string& key, const std::string& context) {
+    const rvi::Json* field = json.Find(key);
+    if (field == nullptr) {
+        return {};
+    }
+    if (const std::string* text = field->AsString()) {
+        return DecodeHex(*text, context + " " + key);
+    }
+    throw std::runtime_error(context + " '" + key + "' must be a string");
+}
+
+Case LoadCase(const rvi::Json& json, size_t index, const std::string& where) {
+    if (json.AsObject() == nullptr) {
+        throw std::runtime_error(where + ": case #" + std::to_string(index) + " is not an object");
+    }
+
+    Case test_case{};
+    const rvi::Json* name = json.Find("name");
+    if (name == nullptr || name->AsString() == nullptr || name->AsString()->empty()) {
+        throw std::runtime_error(where + ": case #" + std::to_string(index) + " is missing a name");
+    }
+    test_case.name = *name->AsString();
+    const std::string context = where + "::" + test_case.name;
+
+    if (const rvi::Json* args = json.Find("args")) {
+        const auto* array = args->AsArray();
+        if (array == nullptr) {
+            throw std::runtime_error(context + " 'args' must be a list of strings");
+        }
+        for (const auto& arg : *array) {
+            if (arg.AsString() == nullptr) {
+                throw std::runtime_error(context + " 'args' must be a list of strings");
+            }
+            test_case.args.push_back(*arg.AsString());
+        }
+    }
+
+    test_case.stdin_data = HexField(json, "stdin_hex", context);
+    test_case.stdout_data = HexField(json, "stdout_hex", context);
+
+    if (const rvi::Json* exit_code = json.Find("exit_code")) {
+        if (const double* number = exit_code->AsNumber()) {
+            test_case.exit_code = static_cast<int64_t>(*number);
+        } else if (const std::string* text = exit_code->AsString()) {
+            test_case.exit_code = std::stoll(*text);
+        } else {
+            throw std::runtime_error(context + " 'exit_code' must be a number");
+        }
+    }
+
+    if (const rvi::Json* harts = json.Find("harts")) {
+        const double* number = harts->AsNumber();
+        if (number == nullptr || *number < 1.0 || *number > rvi::Session::kMaxHarts) {
+            throw std::runtime_error(context + " 'harts' must be 1 to " + std::to_string(rvi::Session::kMaxHarts));
+        }
+        test_case.harts = static_cast<uint32_t>(*number);
+    }
+
+    if (const rvi::Json* safe = json.Find("safe")) {
+        if (safe->AsBool() == nullptr) {
+            throw std::runtime_error(context + " 'safe' must be true or false");
+        }
+        test_case.safe = *safe->AsBool();
+    }
+    return test_case;
+}
+
+Spec LoadSpec(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path.string());
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    rvi::Json json;
+    try {
+        json = rvi::Json::Parse(text.str());
+    } catch (const std::runtime_error& error) {
+        throw std::runtime_error("Failed to parse " + path.string() + ": " + error.what());
+    }
+
+    Spec spec{};
+    spec.path = path;
+    const rvi::Json* binary = json.Find("binary");
+    if (binary == nullptr || binary->AsString() == nullptr || binary->AsString()->empty()) {
+        throw std::runtime_error(path.string() + ": missing or invalid 'binary' field");
+    }
+    spec.binary = *binary->AsString();
+
+    const rvi::Json* cases = json.Find("cases");
+    if (cases == nullptr || cases->AsArray() == nullptr || cases->AsArray()->empty()) {
+        throw std::runtime_error(path.string() + ": missing or invalid 'cases' list");
+    }
+    for (size_t i = 0u; i < cases->AsArray()->size(); ++i) {
+        spec.cases.push_back(LoadCase((*cases->AsArray())[i], i, path.string()));
+    }
+    return spec;
+}
+
+Result RunCase(const std::string& binary, const Case& test_case,
+               const rvi::Session::Options& options, uint64_t max_instructions) {
+    Result result{};
+    int32_t exit_code = 0;
+    if (test_case.harts > 1u && options.engine == rvi::Engine::Jit) {
+        result.skipped = true;
+        return result;
+    }
+
+    rvi::Session::Options case_options = options;
+    case_options.harts = test_case.harts;
+    case_options.safe = options.safe || test_case.safe;
+
+    // The session is destroyed before the output is compared, flushing it.
+    {
+        // Options the session cannot run fail only this case.
+        std::optional<rvi::Session> session;
+        try {
+            session.emplace(case_options);
+        } catch (const std::exception& error) {
+            result.issues.push_back(error.what());
+            return result;
+        }
+
+        session->SetStdin(test_case.stdin_data);
+        session->SetStdout([&](std::span<const uint8_t> data) {
+            result.stdout_data.insert(result.stdout_data.end(), data.begin(), data.end());
+        });
+        session->SetStderr([&](std::span<const uint8_t> data) {
+            result.stderr_data.insert(result.stderr_data.end(), data.begin(), data.end());
+        });
+
+        try {
+            session->Load(binary, test_case.args);
+            const auto status = session->Run(max_instructions);
+            if (status == rvi::Session::Status::Paused) {
+                result.issues.push_back("still running after " + std::to_string(session->Instructions()) +
+                                        " instructions");
+            } else if (status == rvi::Session::Status::Faulted &&
+                       test_case.exit_code != rvi::Session::kFaultExitCode) {
+                const auto& fault = session->GetFault();
+                std::ostringstream message;
+                message << std::hex << "memory fault at " << fault.address << ", pc " << fault.pc;
+                result.issues.push_back(message.str());
+            }
+        } catch (const std::exception& error) {
+            result.issues.push_back(error.what());
+        }
+        exit_code = static_cast<uint8_t>(session->ExitCode());
+    }
+    if (!result.issues.empty()) {
+        return result;
+    }
+
+    if (exit_code != test_case.exit_code) {
+        result.issues.push_back("exit code " + std::to_string(exit_code) + " != expected " +
+                                std::to_string(test_case.exit_code));
+    }
+    if (result.stdout_data != test_case.stdout_data) {
+        result.issues.push_back("stdout mismatch (expected " + Hex(test_case.stdout_data) + " got " +
+                                Hex(result.stdout_data) + ")");
+    }
+    return result;
+}
+
+void SaveFailureLogs(const std::filesystem::path& dir, const Spec& spec, const Case& test_case,
+                     const Result& result) {
+    const auto logdir = dir / spec.binary;
+    std::filesystem::create_directories(logdir);
+    std::ofstream(logdir / (test_case.name + ".stdout"), std::ios::binary)
+        .write(reinterpret_cast<const char*>(result.stdout_data.data()),
+               static_cast<std::streamsize>(result.stdout_data.size()));
+    std::ofstream(logdir / (test_case.name + ".stderr"), std::ios::binary)
+        .write(reinterpret_cast<const char*>(result.stderr_data.data()),
+               static_cast<std::streamsize>(result.stderr_data.size()));
+}
+
+} // namespace
+
+int main(const int argc, const char* const* argv) {
+    cxxopts::Options options("rvi-batch", "Run RiscV test manifests in parallel");
+    options.add_options()
+        ("manifests", "Test manifests in the format of tests/cases/*.json", cxxopts::value<std::vector<std::string>>())
+        ("binary-dir", "Directory the manifests' binaries are in, and relative guest paths start from", cxxopts::value<std::string>()->default_value("."))
+        ("jobs", "Host threads, 0 for one per hardware thread", cxxopts::value<size_t>()->default_value("0"))
+        ("engine", "Execution engine: block, threaded, jit", cxxopts::value<std::string>()->default_value("block"))
+        ("safe", "Fault on guest accesses outside loaded segments and the stack", cxxopts::value<bool>()->default_value("false"))
+        ("max-instructions", "Fail cases still running after this many instructions, 0 for no limit", cxxopts::value<uint64_t>()->default_value("0"))
+        ("fs", "Serve guest files from a tar archive or directory loaded into memory, shared by all cases", cxxopts::value<std::string>())
+        ("logs", "Write the output of failed cases to this directory", cxxopts::value<std::string>());
+
+    options.parse_positional({"manifests"});
+    auto result = options.parse(argc, argv);
+
+    if (!result.count("manifests")) {
+        std::cout << options.help() << std::endl;
+        return 1;
+    }
+
+    const auto engine = result["engine"].as<std::string>();
+    if (engine != "block" && engine != "threaded" && engine != "jit") {
+        std::cout << "Unknown engine: " << engine << std::endl;
+        return 1;
+    }
+
+    rvi::Session::Options session_options{};
+    session_options.engine = engine == "threaded" ? rvi::Engine::Threaded
+                           : engine == "jit"      ? rvi::Engine::Jit
+                                                  : rvi::Engine::Block;
+    session_options.safe = result["safe"].as<bool>();
+    // Guests open their data files by relative paths, as if started from
+    // tests/ by run_tests.py.
+    session_options.directory = result["binary-dir"].as<std::string>();
+    if (result.count("fs")) {
+        session_options.fs = rvi::FsImage::Load(result["fs"].as<std::string>());
+    }
+
+    const auto max_instructions = result["max-instructions"].as<uint64_t>();
+    if (max_instructions != 0u && session_options.engine == rvi::Engine::Jit) {
+        std::cout << "The jit engine cannot stop after a number of instructions" << std::endl;
+        return 1;
+    }
+
+    std::vector<Spec> specs;
+    for (const auto& path : result["manifests"].as<std::vector<std::string>>()) {
+        try {
+            specs.push_back(LoadSpec(path));
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // Cases are scheduled individually, so one slow binary does not hold up
+    // the others; results are reported in manifest order.
+    struct Job {
+        const Spec* spec;
+        const Case* test_case;
+        std::string binary{};
+    };
+    const std::filesystem::path binary_dir = result["binary-dir"].as<std::string>();
+    std::vector<Job> jobs;
+    for (const auto& spec : specs) {
+        for (const auto& test_case : spec.cases) {
+            jobs.push_back({&spec, &test_case, (binary_dir / spec.binary).string()});
+        }
+    }
+
+    std::vector<Result> results(jobs.size());
+    rvi::ThreadPool pool(result["jobs"].as<size_t>());
+    pool.Run(jobs.size(), [&](size_t i) {
+        results[i] = RunCase(jobs[i].binary, *jobs[i].test_case, session_options,
+                             max_instructions != 0u ? max_instructions : rvi::Session::kNoLimit);
+    });
+
+    constexpr const char* kGreen = "\033[32m";
+    constexpr const char* kRed = "\033[31m";
+    constexpr const char* kReset = "\033[0m";
+
+    size_t failures = 0u;
+    size_t skipped = 0u;
+    const Spec* current = nullptr;
+    for (size_t i = 0u; i < jobs.size(); ++i) {
+        const Job& job = jobs[i];
+        if (job.spec != current) {
+            current = job.spec;
+            std::cout << "\n== " << current->binary << " (" << current->path.filename().string() << ") ==\n";
+        }
+        if (results[i].skipped) {
+            ++skipped;
+            std::cout << "[SKIP] " << job.test_case->name << " (the jit engine runs a single hart)\n";
+            continue;
+        }
+        if (results[i].issues.empty()) {
+            std::cout << "[" << kGreen << "OK" << kReset << "]   " << job.test_case->name << "\n";
+            continue;
+        }
+
+        ++failures;
+        std::cout << "[" << kRed << "FAIL" << kReset << "] " << job.test_case->name << "\n";
+        for (const auto& issue : results[i].issues) {
+            std::cout << "  - " << issue << "\n";
+        }
+        if (result.count("logs")) {
+            SaveFailureLogs(result["logs"].as<std::string>(), *job.spec, *job.test_case, results[i]);
+        }
+    }
+
+    std::cout << "\nSummary:\n";
+    std::cout << "  Total cases: " << jobs.size() << "\n";
+    std::cout << "  Failures:    " << failures << "\n";
+    if (skipped != 0u) {
+        std::cout << "  Skipped:     " << skipped << "\n";
+    }
+    std::cout << "  Threads:     " << pool.Threads() << std::endl;
+
+    return failures == 0u ? 0 : 1;
+}
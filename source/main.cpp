@@ -1,66 +1,166 @@
-#include "rvi_instruction_interface.hpp"
-#include "rvi_instruction_registry.hpp"
-#include "rvi_read_binary.hpp"
-
-#include "rv32i/rvi_rv32i_registration.hpp"
-#include "rv32m/rvi_rv32m_registration.hpp"
-#include "rv32f/rvi_rv32f_registration.hpp"
-#include "rv32zbb/rvi_rv32zbb_registration.hpp"
+#include "rvi_fork_server.hpp"
+#include "rvi_session.hpp"
+#include "rvi_vfs.hpp"
 
 #include "loguru.hpp"
 #include "cxxopts.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <csignal>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace {
-rvi::InstructionRegistry GetReadyRegistry() {
-    rvi::InstructionRegistry registry{};
-
-    rvi::rv32i::RegisterRV32I(&registry);
-    rvi::rv32m::RegisterRV32M(&registry);
-    rvi::rv32f::RegisterRV32F(&registry);
-    rvi::rv32zbb::RegisterRV32zbb(&registry);
-    return registry;
+
+// A guest address in decimal or, with a 0x prefix, in hex.
+std::optional<uint32_t> ParseAddress(std::string_view text) {
+    int base = 10;
+    if (text.starts_with("0x") || text.starts_with("0X")) {
+        text.remove_prefix(2u);
+        base = 16;
+    }
+    uint32_t address = 0u;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), address, base);
+    if (text.empty() || error != std::errc{} || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return address;
 }
+
 } // namespace
 
 int main(const int argc, const char* const* argv) {
     cxxopts::Options options("rvi", "RiscV Intepreter");
     options.add_options()
         ("input", "Executable elf file", cxxopts::value<std::string>())
+        ("engine", "Execution engine: block, threaded, jit", cxxopts::value<std::string>()->default_value("block"))
+        ("safe", "Fault on guest accesses outside loaded segments and the stack", cxxopts::value<bool>()->default_value("false"))
+        ("output-buffer", "Bytes of guest stdout buffered before a host write, 0 to write through", cxxopts::value<size_t>()->default_value("65536"))
+        ("io-uring", "Run guest stdin and stdout I/O through io_uring, overlapped with execution", cxxopts::value<bool>()->default_value("false"))
+        ("harts", "Harts sharing guest memory, each on its own host thread; they start with their id in a0", cxxopts::value<uint32_t>()->default_value("1"))
+        ("huge-pages", "Back guest memory with transparent huge pages and report their use", cxxopts::value<bool>()->default_value("false"))
+        ("fs", "Serve guest files from a tar archive or directory loaded into memory; the host file system is not visible", cxxopts::value<std::string>())
+        ("fork-server", "Serve runs to an AFL-style fork server client on fds 198 and 199, each in a forked copy of the loaded guest", cxxopts::value<bool>()->default_value("false"))
+        ("snapshot-at", "With --fork-server or --save, run the guest up to its first read syscall (read) or to a pc first", cxxopts::value<std::string>())
+        ("save", "Save a checkpoint of the guest at the --snapshot-at point to this file and exit", cxxopts::value<std::string>())
+        ("restore", "Continue the guest saved in this checkpoint instead of loading an executable", cxxopts::value<std::string>())
+        ("env", "Guest environment variable NAME=VALUE; the guest environment is empty otherwise", cxxopts::value<std::vector<std::string>>())
         ("args", "Executable args", cxxopts::value<std::vector<std::string>>());
 
     options.parse_positional({"input", "args"});
     auto result = options.parse(argc, argv);
 
-    if (!result.count("input")) {
+    if (!result.count("input") && !result.count("restore")) {
         std::cout << options.help() << std::endl;
         return 1;
     }
 
-    rvi::ReadBinary read_binary(result["input"].as<std::string>());
-    rvi::InterpreterState state{};
+    const auto engine = result["engine"].as<std::string>();
+    if (engine != "block" && engine != "threaded" && engine != "jit") {
+        std::cout << "Unknown engine: " << engine << std::endl;
+        return 1;
+    }
 
-    uint32_t entry_point = 0;
-    read_binary.LoadIntoMemory(&state.memory, &entry_point);
+    rvi::Session::Options session_options{};
+    session_options.engine = engine == "threaded" ? rvi::Engine::Threaded
+                           : engine == "jit"      ? rvi::Engine::Jit
+                                                  : rvi::Engine::Block;
+    session_options.safe = result["safe"].as<bool>();
+    session_options.huge_pages = result["huge-pages"].as<bool>();
+    session_options.io_uring = result["io-uring"].as<bool>();
+    session_options.output_buffer = result["output-buffer"].as<size_t>();
+    session_options.harts = result["harts"].as<uint32_t>();
+    if (result.count("fs")) {
+        session_options.fs = rvi::FsImage::Load(result["fs"].as<std::string>());
+    }
+    if (result.count("env")) {
+        session_options.env = result["env"].as<std::vector<std::string>>();
+    }
 
-    auto registry = GetReadyRegistry();
+    std::vector<std::string> guest_args;
+    if (result.count("args")) {
+        guest_args = result["args"].as<std::vector<std::string>>();
+    }
 
-    state.pc = entry_point;
-    constexpr uint32_t kStackPadding = 0x10000u;
-    const uint32_t stack_top = static_cast<uint32_t>(state.memory.Size() - kStackPadding) & ~0xFu;
-    state.regs.Set(2u, stack_top); // x2 = sp
+    if (session_options.harts == 0u || session_options.harts > rvi::Session::kMaxHarts) {
+        std::cout << "--harts takes 1 to " << rvi::Session::kMaxHarts << " harts" << std::endl;
+        return 1;
+    }
+    if (session_options.harts > 1u && session_options.engine == rvi::Engine::Jit) {
+        std::cout << "--harts does not work with --engine jit" << std::endl;
+        return 1;
+    }
 
-    rvi::ExecutionStatus status = rvi::ExecutionStatus::Success;
-    while (status == rvi::ExecutionStatus::Success) {
-        DLOG_F(INFO, "[pc = %x]", state.pc);
-        auto instr_raw = state.memory.Read<uint32_t>(state.pc);
+    const bool fork_server = result["fork-server"].as<bool>();
+    if (fork_server && session_options.io_uring) {
+        std::cout << "--fork-server does not work with --io-uring" << std::endl;
+        return 1;
+    }
+
+    std::optional<uint32_t> snapshot_pc{};
+    const bool snapshot = result.count("snapshot-at") != 0u;
+    if (snapshot) {
+        if (!fork_server && !result.count("save")) {
+            std::cout << "--snapshot-at needs --fork-server or --save" << std::endl;
+            return 1;
+        }
+        const auto marker = result["snapshot-at"].as<std::string>();
+        if (marker != "read") {
+            snapshot_pc = ParseAddress(marker);
+            if (!snapshot_pc) {
+                std::cout << "--snapshot-at takes read or a pc, not " << marker << std::endl;
+                return 1;
+            }
+        }
+    }
 
-        auto [instr_interface, decoded_info] = registry.GetInstruction(instr_raw);
+    rvi::Session session(std::move(session_options));
+    if (result.count("restore")) {
+        session.Restore(result["restore"].as<std::string>());
+    } else {
+        session.Load(result["input"].as<std::string>(), guest_args);
+    }
+
+    if (snapshot_pc) {
+        session.RunToPc(*snapshot_pc);
+    } else if (snapshot) {
+        session.RunToRead();
+    }
+    if (result.count("save")) {
+        session.Save(result["save"].as<std::string>());
+        return 0;
+    }
+
+    if (fork_server) {
+        if (!rvi::ServeForks(&session)) {
+            return 0;
+        }
+    }
+
+    if (session.Run() == rvi::Session::Status::Faulted) {
+        const auto& fault = session.GetFault();
+        LOG_F(ERROR, "Guest memory fault at %x, pc %x", fault.address, fault.pc);
+
+        // Fork server clients tell crashes from exits by the wait status.
+        if (fork_server) {
+            std::signal(SIGSEGV, SIG_DFL);
+            std::raise(SIGSEGV);
+        }
+    }
 
-        status = instr_interface->Execute(&state, decoded_info);
+    if (result["huge-pages"].as<bool>()) {
+        const auto usage = session.State().memory.Usage();
+        LOG_F(INFO, "Guest memory: %zu KiB resident, %zu KiB (%zu%%) in huge pages",
+              usage.resident_bytes >> 10, usage.huge_page_bytes >> 10,
+              usage.huge_page_bytes * 100u / std::max<size_t>(usage.resident_bytes, 1u));
     }
 
-    DLOG_F(INFO, "Program exit with code %i", state.return_code);
+    DLOG_F(INFO, "Program exit with code %i", session.ExitCode());
 
-    return state.return_code;
+    return session.ExitCode();
 }
@@ -0,0 +1,145 @@
+#include "rvi_block_cache.hpp"
+
+#include "rvi_fusion.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+constexpr uint32_t kOpcodeMask   = 0x7Fu;
+constexpr uint32_t kOpcodeBranch = 0x63u;
+constexpr uint32_t kOpcodeJal    = 0x6Fu;
+constexpr uint32_t kOpcodeJalr   = 0x67u;
+constexpr uint32_t kOpcodeSystem = 0x73u;
+
+bool IsBlockTerminator(uint32_t instr_raw) {
+    switch (instr_raw & kOpcodeMask) {
+        case kOpcodeBranch:
+        case kOpcodeJal:
+        case kOpcodeJalr:
+        case kOpcodeSystem:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+BlockCache::BlockCache()
+    : blocks_() {
+}
+
+std::unique_ptr<BasicBlock> BlockCache::DecodeBlock(const InterpreterMemoryModel& memory,
+                                                    uint32_t pc) const {
+    // A fetch fault leaves without unwinding, so the only one is raised
+    // before anything is allocated. Later instructions end the block instead
+    // and fault once execution reaches them.
+    static_cast<void>(memory.Fetch(pc));
+
+    auto block = std::make_unique<BasicBlock>();
+    block->start_pc = pc;
+    block->ops.reserve(kMaxBlockSize);
+
+    uint32_t cur_pc = pc;
+    while (block->ops.size() < kMaxBlockSize) {
+        if (cur_pc != pc && (block_starts_.contains(cur_pc) || !memory.CanFetch(cur_pc))) {
+            break;
+        }
+        auto instr_raw = memory.Fetch(cur_pc);
+
+        auto decoded_info = DecodeInstruction(instr_raw);
+        if (decoded_info.handler == kNoHandler) {
+            // Let the previous instructions run, the fault is raised once
+            // execution actually reaches the bad one.
+            if (block->ops.empty()) {
+                DLOG_F(ERROR, "Illegal instruction %x at pc = %x", instr_raw, cur_pc);
+                throw std::runtime_error("Illegal instruction");
+            }
+            break;
+        }
+
+        block->ops.push_back(decoded_info);
+        cur_pc += 4u;
+
+        if (IsBlockTerminator(instr_raw)) {
+            break;
+        }
+    }
+
+    block->end_pc = cur_pc;
+    [[maybe_unused]] const size_t fused = FuseOps(&block->ops);
+    block->ops.shrink_to_fit();
+
+    DLOG_F(INFO, "Decoded block [%x, %x) with %zu ops, %zu fused",
+           block->start_pc, block->end_pc, block->ops.size(), fused);
+
+    return block;
+}
+
+const BasicBlock& BlockCache::GetBlock(InterpreterMemoryModel& memory, uint32_t pc) {
+    auto it = blocks_.find(pc);
+    if (it != blocks_.end()) {
+        return *it->second;
+    }
+
+    auto inserted = blocks_.emplace(pc, DecodeBlock(memory, pc)).first;
+    const auto& block = *inserted->second;
+    memory.MarkCode(block.start_pc, block.end_pc);
+    return block;
+}
+
+const BasicBlock& BlockCache::GetNextBlock(InterpreterMemoryModel& memory,
+                                           const BasicBlock& prev, uint32_t pc) {
+    auto& links = prev.links;
+    if (links[0].block != nullptr && links[0].pc == pc) {
+        return *links[0].block;
+    }
+    if (links[1].block != nullptr && links[1].pc == pc) {
+        std::swap(links[0], links[1]);
+        return *links[0].block;
+    }
+
+    const auto& block = GetBlock(memory, pc);
+    links[1] = links[0];
+    links[0] = {pc, &block};
+    return block;
+}
+
+std::vector<uint32_t> BlockCache::InvalidateWrittenCode(InterpreterMemoryModel* memory) {
+    constexpr uint64_t kMaxBlockBytes = kMaxBlockSize * 4u;
+
+    std::vector<uint32_t> dropped;
+    for (const auto& write : memory->TakeCodeWrites()) {
+        const uint64_t begin = write.address;
+        const uint64_t end   = begin + write.size;
+
+        // Jump targets are even, and a block overlapping the write starts
+        // less than a block length before it.
+        const uint64_t first = (begin > kMaxBlockBytes ? begin - kMaxBlockBytes : 0u) & ~1ull;
+        for (uint64_t pc = first; pc < end; pc += 2u) {
+            auto it = blocks_.find(static_cast<uint32_t>(pc));
+            if (it != blocks_.end() && it->second->end_pc > begin) {
+                DLOG_F(INFO, "Code write at %x drops block %x", write.address, it->first);
+                dropped.push_back(it->first);
+                blocks_.erase(it);
+            }
+        }
+    }
+
+    if (!dropped.empty()) {
+        for (auto& [pc, block] : blocks_) {
+            block->links = {};
+        }
+    }
+    return dropped;
+}
+
+void BlockCache::Clear() {
+    blocks_.clear();
+}
@@ -0,0 +1,239 @@
+#include "rvi_checkpoint.hpp"
+
+#include "rvi_config.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+constexpr std::array<char, 8> kMagic = {'R', 'V', 'I', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t kVersion = 1u;
+
+struct Header {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t page_size;
+    uint32_t flat; // InterpreterMemoryModel::kIsFlat of the saving build
+    uint32_t pc;
+    int32_t return_code;
+    uint32_t status;
+    std::array<uint32_t, kNumRegs> regs;
+    std::array<uint32_t, kNumRegs> f_regs; // bit patterns
+    GuestHeap heap;
+    uint32_t region_count;
+};
+
+// Follows the header; data_offset is 0 for regions that read as zero.
+struct Region {
+    uint32_t address;
+    uint32_t permissions;
+    uint64_t size;
+    uint64_t data_offset;
+};
+
+static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Region>);
+
+class File {
+    int fd_;
+
+public:
+    File(const std::string& path, int flags) : fd_(open(path.c_str(), flags | O_CLOEXEC, 0644)) {
+        if (fd_ < 0) {
+            throw std::runtime_error("Cannot open checkpoint " + path);
+        }
+    }
+    ~File() { close(fd_); }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    int Fd() const noexcept { return fd_; }
+
+    void WriteAt(const void* data, size_t size, uint64_t offset) const {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0u) {
+            const ssize_t written = pwrite(fd_, bytes, size, static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                throw std::runtime_error("Checkpoint write failed");
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+    }
+
+    void ReadAt(void* data, size_t size, uint64_t offset) const {
+        if (pread(fd_, data, size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size)) {
+            throw std::runtime_error("Checkpoint is truncated");
+        }
+    }
+};
+
+bool IsZero(const uint8_t* data, size_t size) {
+    return std::all_of(data, data + size, [](uint8_t b) { return b == 0u; });
+}
+
+// Splits the touched regions of memory at their all-zero pages, which then
+// need no data in the file.
+std::vector<MemoryRegion> SavedRegions(const InterpreterMemoryModel& memory) {
+    const size_t page = InterpreterMemoryModel::PageSize();
+
+    // Regions with data are only merged if the host memory is contiguous
+    // too, which paged memory never is.
+    std::vector<MemoryRegion> regions;
+    auto add = [&](uint32_t address, uint64_t size, uint8_t permissions, const uint8_t* data) {
+        if (!regions.empty()) {
+            auto& last = regions.back();
+            const bool contiguous = data == nullptr ? last.data == nullptr
+                                                    : last.data != nullptr && last.data + last.size == data;
+            if (last.address + last.size == address && last.permissions == permissions && contiguous) {
+                last.size += size;
+                return;
+            }
+        }
+        regions.push_back({address, size, permissions, data});
+    };
+
+    for (const auto& region : memory.Regions()) {
+        if (region.data == nullptr) {
+            add(region.address, region.size, region.permissions, nullptr);
+            continue;
+        }
+        for (uint64_t offset = 0u; offset < region.size; offset += page) {
+            const uint8_t* data = region.data + offset;
+            add(static_cast<uint32_t>(region.address + offset), page, region.permissions,
+                IsZero(data, page) ? nullptr : data);
+        }
+    }
+    return regions;
+}
+
+} // namespace
+
+void rvi::SaveCheckpoint(const InterpreterState& state, const std::string& path) {
+    const uint64_t page = InterpreterMemoryModel::PageSize();
+    const std::vector<MemoryRegion> regions = SavedRegions(state.memory);
+
+    Header header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.page_size = static_cast<uint32_t>(page);
+    header.flat = InterpreterMemoryModel::kIsFlat;
+    header.pc = state.pc;
+    header.return_code = state.return_code;
+    header.status = static_cast<uint32_t>(state.status);
+    for (uint32_t i = 0; i < kNumRegs; ++i) {
+        header.regs[i] = state.regs.Get(i);
+        header.f_regs[i] = std::bit_cast<uint32_t>(state.f_regs.Get(i));
+    }
+    header.heap = state.heap;
+    header.region_count = static_cast<uint32_t>(regions.size());
+
+    // Page data starts at the first page boundary after the region table.
+    const uint64_t table_end = sizeof(Header) + regions.size() * sizeof(Region);
+    uint64_t data_offset = (table_end + page - 1u) / page * page;
+    uint64_t data_bytes = 0u;
+
+    std::vector<Region> table;
+    table.reserve(regions.size());
+    for (const auto& region : regions) {
+        table.push_back({region.address, region.permissions, region.size,
+                         region.data != nullptr ? data_offset : 0u});
+        if (region.data != nullptr) {
+            data_offset += region.size;
+            data_bytes += region.size;
+        }
+    }
+
+    // A crash while saving leaves the previous checkpoint intact.
+    const std::string temp_path = path + ".tmp";
+    {
+        File file(temp_path, O_WRONLY | O_CREAT | O_TRUNC);
+        file.WriteAt(&header, sizeof(header), 0u);
+        file.WriteAt(table.data(), table.size() * sizeof(Region), sizeof(Header));
+        for (size_t i = 0u; i < regions.size(); ++i) {
+            if (regions[i].data != nullptr) {
+                file.WriteAt(regions[i].data, regions[i].size, table[i].data_offset);
+            }
+        }
+        if (ftruncate(file.Fd(), static_cast<off_t>(data_offset)) != 0 || fsync(file.Fd()) != 0) {
+            throw std::runtime_error("Checkpoint write failed");
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace checkpoint " + path);
+    }
+
+    DLOG_F(INFO, "Saved checkpoint %s: %zu regions, %llu bytes of pages", path.c_str(), regions.size(),
+           static_cast<unsigned long long>(data_bytes));
+}
+
+void rvi::RestoreCheckpoint(const std::string& path, InterpreterState* state) {
+    const File file(path, O_RDONLY);
+
+    Header header{};
+    file.ReadAt(&header, sizeof(header), 0u);
+    if (header.magic != kMagic || header.version != kVersion) {
+        throw std::runtime_error(path + " is not a checkpoint");
+    }
+    if (header.page_size != InterpreterMemoryModel::PageSize() ||
+        header.flat != InterpreterMemoryModel::kIsFlat) {
+        throw std::runtime_error(path + " was saved with a different page size or memory backend");
+    }
+
+    struct stat info{};
+    if (fstat(file.Fd(), &info) != 0) {
+        throw std::runtime_error("Cannot open checkpoint " + path);
+    }
+    const auto file_size = static_cast<uint64_t>(info.st_size);
+    if (static_cast<uint64_t>(header.region_count) * sizeof(Region) > file_size ||
+        header.status > static_cast<uint32_t>(ExecutionStatus::Fault)) {
+        throw std::runtime_error(path + " is corrupt");
+    }
+
+    std::vector<Region> table(header.region_count);
+    file.ReadAt(table.data(), table.size() * sizeof(Region), sizeof(Header));
+
+    // Mapped pages past the end of the file would raise SIGBUS when touched.
+    const uint64_t page = header.page_size;
+    auto& memory = state->memory;
+    for (const auto& region : table) {
+        if (static_cast<uint64_t>(region.address) + region.size > memory.Size() ||
+            region.address % page != 0u || region.size % page != 0u || region.data_offset % page != 0u ||
+            (region.data_offset != 0u && region.data_offset + region.size > file_size)) {
+            throw std::runtime_error(path + " is corrupt");
+        }
+        if (region.data_offset != 0u) {
+            memory.MapFile(region.address, file.Fd(), region.data_offset, region.size);
+        }
+        memory.Protect(region.address, region.size, static_cast<uint8_t>(region.permissions));
+    }
+
+    for (uint32_t i = 0; i < kNumRegs; ++i) {
+        state->regs.Set(i, header.regs[i]);
+        state->f_regs.Set(i, std::bit_cast<float>(header.f_regs[i]));
+    }
+    state->pc = header.pc;
+    state->return_code = header.return_code;
+    state->status = static_cast<ExecutionStatus>(header.status);
+    state->heap = header.heap;
+}
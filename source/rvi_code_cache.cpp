@@ -0,0 +1,84 @@
+#include "rvi_code_cache.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+constexpr size_t kCodeAlignment = 16u;
+
+size_t PageSize() {
+    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return kPageSize;
+}
+
+} // namespace
+
+CodeCache::CodeCache(size_t size) {
+    const size_t page = PageSize();
+    size = (size + page - 1u) & ~(page - 1u);
+
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Code cache map failed");
+    }
+
+    base_ = static_cast<uint8_t*>(addr);
+    size_ = size;
+}
+
+CodeCache::~CodeCache() {
+    if (base_) {
+        munmap(base_, size_);
+    }
+}
+
+size_t CodeCache::AlignedUsed() const noexcept {
+    return (used_ + kCodeAlignment - 1u) & ~(kCodeAlignment - 1u);
+}
+
+void CodeCache::Write(size_t offset, std::span<const uint8_t> bytes) {
+    const size_t page = PageSize();
+    const size_t first_page = offset & ~(page - 1u);
+    const size_t last_page  = (offset + bytes.size() + page - 1u) & ~(page - 1u);
+
+    if (mprotect(base_ + first_page, last_page - first_page, PROT_READ | PROT_WRITE) != 0) {
+        throw std::runtime_error("Code cache mprotect failed");
+    }
+    std::memcpy(base_ + offset, bytes.data(), bytes.size());
+    if (mprotect(base_ + first_page, last_page - first_page, PROT_READ | PROT_EXEC) != 0) {
+        throw std::runtime_error("Code cache mprotect failed");
+    }
+}
+
+bool CodeCache::Fits(size_t size) const noexcept {
+    const size_t offset = AlignedUsed();
+    return offset <= size_ && size <= size_ - offset;
+}
+
+const uint8_t* CodeCache::Add(std::span<const uint8_t> code) {
+    if (!Fits(code.size())) {
+        return nullptr;
+    }
+
+    const size_t offset = AlignedUsed();
+    Write(offset, code);
+
+    used_ = offset + code.size();
+    DLOG_F(INFO, "Code cache: +%zu bytes, %zu/%zu used", code.size(), used_, size_);
+
+    return base_ + offset;
+}
+
+void CodeCache::Patch(const uint8_t* at, std::span<const uint8_t> bytes) {
+    const auto offset = static_cast<size_t>(at - base_);
+    assert(at >= base_ && offset + bytes.size() <= used_);
+    Write(offset, bytes);
+}
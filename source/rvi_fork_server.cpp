@@ -0,0 +1,74 @@
+#include "rvi_fork_server.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+bool ReadWord(int fd, uint32_t* value) {
+    ssize_t result = 0;
+    do {
+        result = read(fd, value, sizeof(*value));
+    } while (result < 0 && errno == EINTR);
+    return result == sizeof(*value);
+}
+
+bool WriteWord(int fd, uint32_t value) {
+    ssize_t result = 0;
+    do {
+        result = write(fd, &value, sizeof(value));
+    } while (result < 0 && errno == EINTR);
+    return result == sizeof(value);
+}
+
+} // namespace
+
+bool rvi::ServeForks(Session* session, int control_fd) {
+    if (session->GetOptions().io_uring) {
+        throw std::runtime_error("A session using io_uring cannot be forked");
+    }
+    const int status_fd = control_fd + 1;
+
+    // The hello; without a client the session just runs once.
+    if (!WriteWord(status_fd, 0u)) {
+        return true;
+    }
+
+    // Output the start-up code buffered must not be written by every child.
+    session->State().io.Flush();
+
+    DLOG_F(INFO, "Fork server waiting on fd %i", control_fd);
+    uint32_t request = 0u;
+    while (ReadWord(control_fd, &request)) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error("Fork server failed to fork");
+        }
+        if (pid == 0) {
+            close(control_fd);
+            close(status_fd);
+            return true;
+        }
+
+        if (!WriteWord(status_fd, static_cast<uint32_t>(pid))) {
+            throw std::runtime_error("Fork server lost its client");
+        }
+        int status = 0;
+        pid_t waited = 0;
+        do {
+            waited = waitpid(pid, &status, 0);
+        } while (waited < 0 && errno == EINTR);
+        if (waited < 0 || !WriteWord(status_fd, static_cast<uint32_t>(status))) {
+            throw std::runtime_error("Fork server lost its client");
+        }
+    }
+    return false;
+}
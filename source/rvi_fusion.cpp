@@ -0,0 +1,91 @@
+#include "rvi_fusion.hpp"
+
+#include "rvi_instruction_list.hpp"
+
+#include <cstddef>
+
+using namespace rvi;
+
+namespace {
+
+// Pairs whose first instruction writes x0 are left alone, the second one
+// would read zero rather than the intermediate value.
+bool Fuse(const MicroOp& first, const MicroOp& second, MicroOp* fused) {
+    const auto first_id  = static_cast<OpId>(first.handler);
+    const auto second_id = static_cast<OpId>(second.handler);
+
+    if (first.rd == 0u) {
+        return false;
+    }
+
+    *fused = MicroOp{};
+    auto set_id = [&](OpId id) { fused->handler = static_cast<uint16_t>(id); };
+
+    if (first_id == OpId::Lui && second_id == OpId::Addi &&
+        second.rd == first.rd && second.rs1 == first.rd) {
+        set_id(OpId::LuiAddi);
+        fused->rd  = first.rd;
+        fused->imm = static_cast<int32_t>(static_cast<uint32_t>(first.imm) +
+                                          static_cast<uint32_t>(second.imm));
+        return true;
+    }
+
+    if (first_id == OpId::Auipc && (second_id == OpId::Jalr || second_id == OpId::Lw) &&
+        second.rs1 == first.rd) {
+        set_id(second_id == OpId::Jalr ? OpId::AuipcJalr : OpId::AuipcLw);
+        fused->rd  = first.rd;
+        fused->rs3 = second.rd;
+        fused->imm = static_cast<int32_t>(static_cast<uint32_t>(first.imm) +
+                                          static_cast<uint32_t>(second.imm));
+        return true;
+    }
+
+    if (first_id == OpId::Slli && second_id == OpId::Add &&
+        (second.rs1 == first.rd || second.rs2 == first.rd)) {
+        set_id(OpId::SlliAdd);
+        fused->rd  = first.rd;
+        fused->rs1 = first.rs1;
+        fused->rs2 = second.rs1 == first.rd ? second.rs2 : second.rs1;
+        fused->rs3 = second.rd;
+        fused->imm = first.imm & 0x1F;
+        return true;
+    }
+
+    if ((first_id == OpId::Slt || first_id == OpId::Sltu) &&
+        (second_id == OpId::Bne || second_id == OpId::Beq) &&
+        ((second.rs1 == first.rd && second.rs2 == 0u) ||
+         (second.rs1 == 0u && second.rs2 == first.rd))) {
+        const bool is_signed = first_id == OpId::Slt;
+        const bool is_bnez   = second_id == OpId::Bne;
+        set_id(is_signed ? (is_bnez ? OpId::SltBnez  : OpId::SltBeqz)
+                         : (is_bnez ? OpId::SltuBnez : OpId::SltuBeqz));
+        fused->rd  = first.rd;
+        fused->rs1 = first.rs1;
+        fused->rs2 = first.rs2;
+        fused->imm = static_cast<int32_t>(4u + static_cast<uint32_t>(second.imm));
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace
+
+size_t rvi::FuseOps(std::vector<MicroOp>* ops) {
+    size_t fused_count = 0u;
+    size_t out = 0u;
+
+    for (size_t i = 0; i < ops->size(); ++i, ++out) {
+        MicroOp fused{};
+        if (i + 1u < ops->size() && Fuse((*ops)[i], (*ops)[i + 1u], &fused)) {
+            (*ops)[out] = fused;
+            ++i;
+            ++fused_count;
+        } else {
+            (*ops)[out] = (*ops)[i];
+        }
+    }
+
+    ops->erase(ops->begin() + static_cast<std::ptrdiff_t>(out), ops->end());
+    return fused_count;
+}
@@ -0,0 +1,368 @@
+#include "rvi_guest_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+// Linux transfers at most this much per call as well.
+constexpr uint32_t kMaxTransfer = 0x7FFFF000u;
+
+// A write, a read and a cancel at most are in flight.
+constexpr uint32_t kRingEntries = 4u;
+constexpr uint64_t kWriteTag  = 1u;
+constexpr uint64_t kReadTag   = 2u;
+constexpr uint64_t kCancelTag = 3u;
+
+// Paged memory yields a span per page; what does not fit is a short transfer.
+int IovCount(const std::vector<iovec>& iov) {
+    return static_cast<int>(std::min<size_t>(iov.size(), IOV_MAX));
+}
+
+} // namespace
+
+GuestIo::GuestIo() : fds_(3u) {
+    fds_[kStdin].host  = STDIN_FILENO;
+    fds_[kStdout].host = STDOUT_FILENO;
+    fds_[kStderr].host = STDERR_FILENO;
+}
+
+GuestIo::~GuestIo() {
+    Flush();
+    if (read_in_flight_) {
+        // input_ must outlive the read.
+        ring_->Cancel(kReadTag, kCancelTag);
+        while (read_in_flight_) {
+            Reap();
+        }
+    }
+    for (const auto& open_fd : fds_) {
+        if (open_fd.host > STDERR_FILENO) {
+            close(open_fd.host);
+        }
+    }
+    if (directory_ != AT_FDCWD) {
+        close(directory_);
+    }
+}
+
+void GuestIo::SetDirectory(const std::string& path) {
+    const int directory = open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (directory < 0) {
+        throw std::runtime_error("Cannot open directory " + path + ": " + std::strerror(errno));
+    }
+    if (directory_ != AT_FDCWD) {
+        close(directory_);
+    }
+    directory_ = directory;
+}
+
+void GuestIo::SetOutputBuffer(size_t capacity) {
+    Flush();
+    output_capacity_ = capacity;
+    output_.shrink_to_fit();
+}
+
+bool GuestIo::EnableIoUring() {
+    auto ring = std::make_unique<IoRing>();
+    if (!ring->Init(kRingEntries)) {
+        return false;
+    }
+
+    Flush();
+    ring_ = std::move(ring);
+    input_.resize(kReadAhead);
+    return true;
+}
+
+void GuestIo::StartDrain() {
+    const auto size = static_cast<uint32_t>(std::min<size_t>(draining_.size() - drained_, kMaxTransfer));
+    ring_->Write(STDOUT_FILENO, draining_.data() + drained_, size, kWriteTag);
+    write_in_flight_ = true;
+}
+
+void GuestIo::StartReadAhead() {
+    input_begin_ = input_end_ = 0u;
+    ring_->Read(STDIN_FILENO, input_.data(), static_cast<uint32_t>(input_.size()), kReadTag);
+    read_in_flight_ = true;
+}
+
+void GuestIo::Reap() {
+    const auto [tag, result] = ring_->Wait();
+    if (tag == kWriteTag) {
+        write_in_flight_ = false;
+        if (result == -EINTR || result == -EAGAIN) {
+            StartDrain();
+            return;
+        }
+        if (result <= 0) {
+            LOG_F(ERROR, "Dropping %zu bytes of guest output", draining_.size() - drained_);
+            drained_ = draining_.size();
+        } else {
+            drained_ += static_cast<size_t>(result);
+        }
+        if (drained_ < draining_.size()) {
+            StartDrain();
+        } else {
+            draining_.clear();
+            drained_ = 0u;
+        }
+    } else if (tag == kReadTag) {
+        read_in_flight_ = false;
+        if (result < 0) {
+            input_error_ = result;
+        } else {
+            input_end_ = static_cast<size_t>(result);
+        }
+    }
+}
+
+// Hands the buffered output to the ring, or writes it without one.
+void GuestIo::SubmitOutput() {
+    if (!ring_) {
+        Flush();
+        return;
+    }
+
+    while (write_in_flight_) {
+        Reap();
+    }
+    if (!output_.empty()) {
+        std::swap(output_, draining_);
+        drained_ = 0u;
+        StartDrain();
+    }
+}
+
+GuestIo::OpenFd* GuestIo::FreeFd() {
+    const auto it = std::find_if(fds_.begin(), fds_.end(), [](const OpenFd& open_fd) {
+        return !open_fd.IsOpen();
+    });
+    return it != fds_.end() ? &*it : &fds_.emplace_back();
+}
+
+uint32_t GuestIo::Adopt(int host_fd) {
+    OpenFd* open_fd = FreeFd();
+    open_fd->host = host_fd;
+    return static_cast<uint32_t>(open_fd - fds_.data());
+}
+
+uint32_t GuestIo::Adopt(std::unique_ptr<VfsFile> file) {
+    OpenFd* open_fd = FreeFd();
+    open_fd->file = std::move(file);
+    return static_cast<uint32_t>(open_fd - fds_.data());
+}
+
+void GuestIo::SetInput(std::vector<uint8_t> data) {
+    auto input = std::make_shared<OverlayFile>(OverlayFile{std::move(data), S_IFREG | 0444u});
+    fds_[kStdin] = {-1, std::make_unique<VfsFile>("", nullptr, std::move(input), true, false, false)};
+}
+
+void GuestIo::SetOutput(uint32_t fd, OutputSink sink) {
+    Flush();
+    fds_[fd] = {-1, nullptr, std::move(sink)};
+}
+
+int32_t GuestIo::Close(uint32_t fd) {
+    if (File(fd) != nullptr || (IsOpen(fd) && fds_[fd].sink != nullptr)) {
+        fds_[fd] = {};
+        return 0;
+    }
+
+    const int host_fd = HostFd(fd);
+    if (host_fd < 0) {
+        return -EBADF;
+    }
+
+    fds_[fd].host = -1;
+    if (host_fd == STDOUT_FILENO) {
+        Flush();
+    }
+    if (host_fd > STDERR_FILENO && close(host_fd) != 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+int32_t GuestIo::WriteDirect(int host_fd) {
+    iov_.clear();
+    for (const auto& span : read_spans_) {
+        iov_.push_back({const_cast<uint8_t*>(span.data()), span.size()});
+    }
+
+    const ssize_t written = writev(host_fd, iov_.data(), IovCount(iov_));
+    return written < 0 ? -errno : static_cast<int32_t>(written);
+}
+
+int32_t GuestIo::Write(uint32_t fd, const InterpreterMemoryModel& memory, std::span<const GuestRange> ranges) {
+    if (!IsOpen(fd)) {
+        return -EBADF;
+    }
+    const int host_fd = HostFd(fd);
+    VfsFile* file = File(fd);
+
+    uint32_t size = 0u;
+    read_spans_.clear();
+    for (const auto& range : ranges) {
+        const uint32_t chunk = std::min(range.size, kMaxTransfer - size);
+        if (!memory.ReadSpans(range.address, chunk, &read_spans_)) {
+            return -EFAULT;
+        }
+        size += chunk;
+    }
+    if (file != nullptr) {
+        return static_cast<int32_t>(file->Write(read_spans_));
+    }
+    if (fds_[fd].sink != nullptr) {
+        for (const auto& span : read_spans_) {
+            fds_[fd].sink(span);
+        }
+        return static_cast<int32_t>(size);
+    }
+
+    const bool to_stdout = host_fd == STDOUT_FILENO;
+    if (to_stdout && output_.size() + size > output_capacity_) {
+        SubmitOutput();
+    }
+    if (to_stdout && output_.size() + size <= output_capacity_) {
+        if (output_.capacity() < output_capacity_) {
+            output_.reserve(output_capacity_);
+        }
+        for (const auto& span : read_spans_) {
+            output_.insert(output_.end(), span.begin(), span.end());
+        }
+        return static_cast<int32_t>(size);
+    }
+
+    // Buffered output goes first, whichever standard stream this is.
+    if (host_fd <= STDERR_FILENO) {
+        Flush();
+    }
+    return WriteDirect(host_fd);
+}
+
+int32_t GuestIo::Read(uint32_t fd, InterpreterMemoryModel* memory, std::span<const GuestRange> ranges) {
+    const int host_fd = HostFd(fd);
+    VfsFile* file = File(fd);
+    if (host_fd < 0 && file == nullptr) {
+        return -EBADF; // sinks are write-only
+    }
+
+    // Prompts written so far must be visible before blocking on input.
+    if (host_fd == STDIN_FILENO) {
+        Flush();
+        if (ring_) {
+            return ReadAhead(memory, ranges);
+        }
+    }
+
+    uint32_t size = 0u;
+    write_spans_.clear();
+    for (const auto& range : ranges) {
+        const uint32_t chunk = std::min(range.size, kMaxTransfer - size);
+        if (!memory->WriteSpans(range.address, chunk, &write_spans_)) {
+            return -EFAULT;
+        }
+        size += chunk;
+    }
+    if (file != nullptr) {
+        return static_cast<int32_t>(file->Read(write_spans_));
+    }
+
+    iov_.clear();
+    for (const auto& span : write_spans_) {
+        iov_.push_back({span.data(), span.size()});
+    }
+
+    ssize_t got = 0;
+    do {
+        got = readv(host_fd, iov_.data(), IovCount(iov_));
+    } while (got < 0 && errno == EINTR);
+    return got < 0 ? -errno : static_cast<int32_t>(got);
+}
+
+// Serves a guest read from the read-ahead buffer, waiting for it to fill if
+// it is empty. Once the guest has consumed everything, the next read ahead
+// starts.
+int32_t GuestIo::ReadAhead(InterpreterMemoryModel* memory, std::span<const GuestRange> ranges) {
+    uint64_t requested = 0u;
+    for (const auto& range : ranges) {
+        requested += range.size;
+    }
+    if (requested == 0u) {
+        return 0;
+    }
+
+    while (input_begin_ == input_end_) {
+        if (!read_in_flight_) {
+            StartReadAhead();
+        }
+        while (read_in_flight_) {
+            Reap();
+        }
+        if (input_error_ == -EINTR) {
+            input_error_ = 0;
+            continue;
+        }
+        if (input_error_ != 0) {
+            return std::exchange(input_error_, 0);
+        }
+        if (input_begin_ == input_end_) {
+            return 0; // end of file
+        }
+    }
+
+    const size_t available = input_end_ - input_begin_;
+    uint32_t size = 0u;
+    write_spans_.clear();
+    for (const auto& range : ranges) {
+        const auto chunk = static_cast<uint32_t>(std::min<size_t>(range.size, available - size));
+        if (!memory->WriteSpans(range.address, chunk, &write_spans_)) {
+            return -EFAULT;
+        }
+        size += chunk;
+    }
+
+    for (const auto& span : write_spans_) {
+        std::memcpy(span.data(), input_.data() + input_begin_, span.size());
+        input_begin_ += span.size();
+    }
+    if (input_begin_ == input_end_) {
+        StartReadAhead();
+    }
+    return static_cast<int32_t>(size);
+}
+
+void GuestIo::Flush() {
+    if (ring_) {
+        SubmitOutput();
+        while (write_in_flight_) {
+            Reap();
+        }
+        return;
+    }
+
+    size_t done = 0u;
+    while (done < output_.size()) {
+        const ssize_t written = write(static_cast<int>(kStdout), output_.data() + done, output_.size() - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            LOG_F(ERROR, "Dropping %zu bytes of guest output", output_.size() - done);
+            break;
+        }
+        done += static_cast<size_t>(written);
+    }
+    output_.clear();
+}
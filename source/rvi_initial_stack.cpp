@@ -0,0 +1,80 @@
+#include "rvi_initial_stack.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+constexpr uint32_t kMaxStrings = 2u << 20;
+constexpr uint32_t kRandomSize = 16u;
+
+std::span<const uint8_t> Bytes(const std::vector<uint32_t>& words) {
+    return {reinterpret_cast<const uint8_t*>(words.data()), words.size() * sizeof(uint32_t)};
+}
+
+} // namespace
+
+uint32_t rvi::BuildInitialStack(InterpreterMemoryModel* memory, uint32_t stack_top, const ImageInfo& image,
+                                std::span<const std::string> args, std::span<const std::string> env) {
+    std::vector<uint8_t> strings;
+    std::vector<uint32_t> offsets;
+    for (const auto& list : {args, env}) {
+        for (const auto& string : list) {
+            offsets.push_back(static_cast<uint32_t>(strings.size()));
+            strings.insert(strings.end(), string.begin(), string.end());
+            strings.push_back(0u);
+            if (strings.size() > kMaxStrings) {
+                throw std::runtime_error("Guest arguments and environment are too long");
+            }
+        }
+    }
+
+    const auto strings_start = static_cast<uint32_t>(stack_top - strings.size());
+    memory->LoadBytes(strings_start, strings);
+
+    std::random_device device;
+    std::vector<uint32_t> random(kRandomSize / sizeof(uint32_t));
+    for (auto& word : random) {
+        word = device();
+    }
+    const uint32_t random_start = (strings_start - kRandomSize) & ~0xFu;
+    memory->LoadBytes(random_start, Bytes(random));
+
+    std::vector<uint32_t> words;
+    words.push_back(static_cast<uint32_t>(args.size()));
+    for (size_t i = 0; i < args.size(); ++i) {
+        words.push_back(strings_start + offsets[i]);
+    }
+    words.push_back(0u);
+    for (size_t i = args.size(); i < offsets.size(); ++i) {
+        words.push_back(strings_start + offsets[i]);
+    }
+    words.push_back(0u);
+
+    const auto aux = [&words](AuxKey key, uint32_t value) {
+        words.push_back(static_cast<uint32_t>(key));
+        words.push_back(value);
+    };
+    if (image.phdr != 0u) {
+        aux(AuxKey::Phdr, image.phdr);
+        aux(AuxKey::Phent, image.phent);
+        aux(AuxKey::Phnum, image.phnum);
+    }
+    aux(AuxKey::Pagesz, static_cast<uint32_t>(InterpreterMemoryModel::PageSize()));
+    aux(AuxKey::Entry, image.entry_point);
+    aux(AuxKey::Random, random_start);
+    if (!args.empty()) {
+        aux(AuxKey::Execfn, strings_start);
+    }
+    aux(AuxKey::Null, 0u);
+
+    const uint32_t sp = static_cast<uint32_t>(random_start - words.size() * sizeof(uint32_t)) & ~0xFu;
+    memory->LoadBytes(sp, Bytes(words));
+    DLOG_F(INFO, "Initial stack at %x: %zu args, %zu environment strings", sp, args.size(), env.size());
+    return sp;
+}
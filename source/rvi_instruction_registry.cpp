@@ -1,114 +1,118 @@
 #include "rvi_instruction_registry.hpp"
 
+#include "rvi_instruction_list.hpp"
+
+#include <array>
 #include <cassert>
 #include <cstddef>
+#include <iterator>
 
 #define LOGURU_WITH_STREAMS 1
 #include "loguru.hpp"
 
 using namespace rvi;
 
-PerOpcodeGroup::PerOpcodeGroup()
-    : get_key_(nullptr),
-      decode_instruction_(nullptr),
-      lookup_table_() {
-}
+namespace {
+
+template <class Group>
+struct GroupTable {
+    std::array<uint16_t, Group::kKeySpace> handlers{};
+    bool has_conflicts = false;
+};
+
+// Places every instruction of the group at the key of its canonical encoding.
+template <class Group>
+constexpr GroupTable<Group> BuildGroupTable() {
+    GroupTable<Group> table{};
+    table.handlers.fill(kNoHandler);
+
+#define RVI_ADD_TO_GROUP(name, type)                                          \
+    if constexpr (type::kOpcode == Group::kOpcode) {                          \
+        const auto key = Group::GetKey(type::kDecodedInfo);                   \
+        if (key >= Group::kKeySpace || table.handlers[key] != kNoHandler) {   \
+            table.has_conflicts = true;                                       \
+        } else {                                                              \
+            table.handlers[key] = static_cast<uint16_t>(OpId::name);          \
+        }                                                                     \
+    }
+    RVI_INSTRUCTION_LIST(RVI_ADD_TO_GROUP)
+#undef RVI_ADD_TO_GROUP
 
-PerOpcodeGroup::PerOpcodeGroup(size_t size,
-                               GetOpcodeGroupUniqueKeyFuncPtr get_key,
-                               DecodeInstructionToCommonTypeFuncPtr decode_instruction)
-    : get_key_(get_key),
-      decode_instruction_(decode_instruction),
-      lookup_table_(size) {
+    return table;
 }
 
-bool PerOpcodeGroup::AddInstruction(std::unique_ptr<IInstruction> instr) {
-    auto key = get_key_(instr->GetDecodedInfo());
-
-    auto& entry = lookup_table_.at(key);
-
-    if (entry.get() != nullptr)
-        return false;
+template <class Group>
+constexpr GroupTable<Group> kGroupTable = BuildGroupTable<Group>();
 
-    entry = std::move(instr);
-    DLOG_F(INFO, "+--- " "Add instruction %6s to opcode group with key %x",
-          entry->GetName(),
-          key);
+template <class Group>
+MicroOp DecodeGroup(uint32_t instr) {
+    static_assert(!kGroupTable<Group>.has_conflicts,
+                  "Instructions of an opcode group must have distinct keys");
 
-    return true;
-}
-
-bool PerOpcodeGroup::IsInit() const {
-    if (get_key_ == nullptr || decode_instruction_ == nullptr) {
-        assert(lookup_table_.size() == 0);
-
-        return false;
+    auto info = Group::Decode(instr);
+    const auto key = Group::GetKey(info);
+    if (key < Group::kKeySpace) {
+        info.handler = kGroupTable<Group>.handlers[key];
     }
 
-    assert(lookup_table_.size() > 0);
-
-    return true;
-}
-
-static uint8_t get_opcode(uint32_t instruction) {
-    return (uint8_t)(instruction & 0x7F);
+    return info;
 }
 
-InstructionLookupResult PerOpcodeGroup::GetInstruction(uint32_t instr) const {
-    assert(IsInit());
-    auto info = decode_instruction_(instr);
-    auto key = get_key_(info);
-
-    auto& entry = lookup_table_.at(key);
+#define RVI_DEFINE_INSTANCE(name, type) const type kInstance##name{};
+RVI_INSTRUCTION_LIST(RVI_DEFINE_INSTANCE)
+#undef RVI_DEFINE_INSTANCE
 
-    if (entry.get() == nullptr) {
-        DLOG_F(WARNING, "No instruction %x for key %x in opcode group", instr, key);
-        return {nullptr, info};
-    }
+const IInstruction* const kHandlers[] = {
+#define RVI_HANDLER_ENTRY(name, type) &kInstance##name,
+    RVI_INSTRUCTION_LIST(RVI_HANDLER_ENTRY)
+#undef RVI_HANDLER_ENTRY
+};
 
-    DLOG_F(INFO, "Fetch instruction %s(%x) with opcode %x, key %x, while real opcode is %x", entry->GetName(), instr, entry->GetOpcode(), key, get_opcode(instr));
-
-    return {entry.get(), info};
-}
+static_assert(std::size(kHandlers) == static_cast<size_t>(OpId::kCount));
 
-InstructionRegistry::InstructionRegistry()
-    : lookup_table_() {
-}
+} // namespace
 
-bool InstructionRegistry::RegisterInstruction(std::unique_ptr<IInstruction> instr) {
-    auto opcode = instr->GetOpcode();
+MicroOp rvi::DecodeInstruction(uint32_t instr) {
+    MicroOp info{};
 
-    if (!lookup_table_.at(opcode).IsInit()) {
-        DLOG_F(WARNING, "Opcode group is not registered");
-        return false;
+    switch (instr & 0x7Fu) {
+#define RVI_DECODE_GROUP(group) \
+        case group::kOpcode: info = DecodeGroup<group>(instr); break;
+        RVI_OPCODE_GROUP_LIST(RVI_DECODE_GROUP)
+#undef RVI_DECODE_GROUP
+        default:
+            break;
     }
 
-    return lookup_table_.at(opcode).AddInstruction(std::move(instr));
-}
-
-bool InstructionRegistry::RegisterGroup(PerOpcodeGroup group,
-                                        uint32_t opcode) {
-    if (lookup_table_.at(opcode).IsInit()) {
-        DLOG_F(WARNING, "Opcode group is already registered");
-        return false;
+    if (info.handler == kNoHandler) {
+        DLOG_F(WARNING, "No instruction for %x", instr);
+        return info;
     }
 
-    lookup_table_[opcode] = std::move(group);
-    DLOG_F(INFO, " ");
-    DLOG_F(INFO, "+ Add group with opcode %x", opcode);
+    DLOG_F(INFO, "Fetch instruction %x with handler %s", instr, kHandlers[info.handler]->GetName());
 
-    return true;
+    return info;
 }
 
-InstructionLookupResult InstructionRegistry::GetInstruction(uint32_t instr) const {
-    auto opcode = get_opcode(instr);
-
-    auto& per_opcode_group = lookup_table_[opcode];
-    if (!per_opcode_group.IsInit()) {
-        DLOG_F(WARNING, "PerOpcodeGroup for instruction %x with opcode %x is not registered", instr, opcode);
-        assert(0);
+const IInstruction* rvi::GetInstructionHandler(uint16_t handler) {
+    assert(handler < std::size(kHandlers));
+    return kHandlers[handler];
+}
 
-        return {nullptr, InstructionDecodedCommonType{}};
+void rvi::ExecuteOps(InterpreterState* state, const MicroOp* ops, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const auto& op = ops[i];
+        DLOG_F(INFO, "[pc = %x]", state->pc);
+
+        switch (static_cast<OpId>(op.handler)) {
+#define RVI_EXECUTE_CASE(name, type) \
+            case OpId::name: type::Exec(state, op); break;
+            RVI_INSTRUCTION_LIST(RVI_EXECUTE_CASE)
+#undef RVI_EXECUTE_CASE
+            case OpId::kCount:
+            default:
+                assert(0);
+                break;
+        }
     }
-    return per_opcode_group.GetInstruction(instr);
 }
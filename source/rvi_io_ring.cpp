@@ -0,0 +1,199 @@
+#include "rvi_io_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define RVI_HAS_IO_URING 1
+#endif
+
+using namespace rvi;
+
+#ifdef RVI_HAS_IO_URING
+
+namespace {
+
+template <typename T>
+T* At(void* ring, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+void* MapRing(int fd, size_t size, off_t offset) {
+    void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ring == MAP_FAILED ? nullptr : ring;
+}
+
+long Enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    long result = 0;
+    do {
+        result = syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+} // namespace
+
+IoRing::~IoRing() {
+    Release();
+}
+
+void IoRing::Release() noexcept {
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    fd_ = -1;
+    sq_ring_ = cq_ring_ = nullptr;
+    sqes_ = nullptr;
+}
+
+bool IoRing::Init(uint32_t entries) {
+    io_uring_params params{};
+    const long fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return false;
+    }
+    fd_ = static_cast<int>(fd);
+
+    // Reads and writes at offset -1 must use the file position.
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        Release();
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = MapRing(fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_ : MapRing(fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(MapRing(fd_, sqes_size_, IORING_OFF_SQES));
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+        Release();
+        return false;
+    }
+
+    sq_head_    = At<uint32_t>(sq_ring_, params.sq_off.head);
+    sq_tail_    = At<uint32_t>(sq_ring_, params.sq_off.tail);
+    sq_array_   = At<uint32_t>(sq_ring_, params.sq_off.array);
+    sq_mask_    = *At<uint32_t>(sq_ring_, params.sq_off.ring_mask);
+    sq_entries_ = *At<uint32_t>(sq_ring_, params.sq_off.ring_entries);
+    cq_head_    = At<uint32_t>(cq_ring_, params.cq_off.head);
+    cq_tail_    = At<uint32_t>(cq_ring_, params.cq_off.tail);
+    cqes_       = At<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+    cq_mask_    = *At<uint32_t>(cq_ring_, params.cq_off.ring_mask);
+    return true;
+}
+
+// Only this thread writes the tail, the kernel moves the head.
+io_uring_sqe* IoRing::NextSqe() {
+    const uint32_t tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        throw std::runtime_error("io_uring submission queue is full");
+    }
+
+    io_uring_sqe* sqe = &sqes_[tail & sq_mask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void IoRing::Submit() {
+    const uint32_t tail = *sq_tail_;
+    const uint32_t index = tail & sq_mask_;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1u, __ATOMIC_RELEASE);
+
+    if (Enter(fd_, 1u, 0u, 0u) != 1) {
+        throw std::runtime_error("io_uring submission failed");
+    }
+}
+
+void IoRing::Read(int fd, void* data, uint32_t size, uint64_t tag) {
+    io_uring_sqe* sqe = NextSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = ~0ull;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = size;
+    sqe->user_data = tag;
+    Submit();
+}
+
+void IoRing::Write(int fd, const void* data, uint32_t size, uint64_t tag) {
+    io_uring_sqe* sqe = NextSqe();
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->off = ~0ull;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = size;
+    sqe->user_data = tag;
+    Submit();
+}
+
+void IoRing::Cancel(uint64_t tag, uint64_t cancel_tag) {
+    io_uring_sqe* sqe = NextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = tag;
+    sqe->user_data = cancel_tag;
+    Submit();
+}
+
+IoRing::Completion IoRing::Wait() {
+    while (true) {
+        const uint32_t head = *cq_head_;
+        if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            const Completion completion{cqe.user_data, cqe.res};
+            __atomic_store_n(cq_head_, head + 1u, __ATOMIC_RELEASE);
+            return completion;
+        }
+        if (Enter(fd_, 0u, 1u, IORING_ENTER_GETEVENTS) < 0) {
+            throw std::runtime_error("io_uring wait failed");
+        }
+    }
+}
+
+#else
+
+IoRing::~IoRing() = default;
+
+void IoRing::Release() noexcept {}
+
+bool IoRing::Init(uint32_t /*entries*/) {
+    return false;
+}
+
+void IoRing::Read(int /*fd*/, void* /*data*/, uint32_t /*size*/, uint64_t /*tag*/) {}
+void IoRing::Write(int /*fd*/, const void* /*data*/, uint32_t /*size*/, uint64_t /*tag*/) {}
+void IoRing::Cancel(uint64_t /*tag*/, uint64_t /*cancel_tag*/) {}
+
+IoRing::Completion IoRing::Wait() {
+    throw std::runtime_error("io_uring is not available");
+}
+
+io_uring_sqe* IoRing::NextSqe() {
+    return nullptr;
+}
+
+void IoRing::Submit() {}
+
+#endif
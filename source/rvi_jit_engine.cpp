@@ -0,0 +1,220 @@
+#include "rvi_jit_engine.hpp"
+
+#include "rvi_instruction_registry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+JitEngine::JitEngine(BlockCache* block_cache)
+    : block_cache_(block_cache),
+      code_cache_(),
+      runtime_(std::make_unique<JitRuntime>()),
+      entries_(),
+      code_entries_(),
+      pending_links_(),
+      return_slots_(),
+      code_buffer_(),
+      links_() {
+}
+
+JitEngine::Entry& JitEngine::GetEntry(InterpreterState* state) {
+    auto it = entries_.find(state->pc);
+    if (it == entries_.end()) {
+        // Decoding may fault, which must not leave an entry without a block.
+        const BasicBlock& block = block_cache_->GetBlock(state->memory, state->pc);
+        it = entries_.try_emplace(state->pc).first;
+        it->second.block = &block;
+    }
+    return it->second;
+}
+
+void JitEngine::FlushCode() {
+    DLOG_F(INFO, "Code cache is full, dropping all translations");
+    code_cache_.Reset();
+    runtime_->Reset();
+    pending_links_.clear();
+    return_slots_.clear();
+    code_entries_.clear();
+    for (auto& [pc, entry] : entries_) {
+        entry.code = nullptr;
+        entry.body = nullptr;
+        entry.pcs.clear();
+        entry.return_slots.clear();
+        entry.exec_count = 0u;
+    }
+}
+
+// Stale code stays reachable through linked exits, return slots and the
+// indirect cache, all of which enter at its body. The body is overwritten
+// with an exit to the engine, which then finds the fresh entry.
+void JitEngine::InvalidateWrittenCode(InterpreterMemoryModel* memory) {
+    for (uint32_t pc : block_cache_->InvalidateWrittenCode(memory)) {
+        auto it = entries_.find(pc);
+        if (it == entries_.end()) {
+            continue;
+        }
+
+        const auto& entry = it->second;
+        if (entry.body != nullptr) {
+            DropLinksOf(entry);
+            code_buffer_.clear();
+            EmitExitStubX86_64(pc, &code_buffer_);
+            code_cache_.Patch(entry.body, code_buffer_);
+            code_entries_.erase(reinterpret_cast<const uint8_t*>(entry.code));
+        }
+        entries_.erase(it);
+    }
+}
+
+// Links still waiting in invalidated code would be patched into the exit
+// stub written over it.
+void JitEngine::DropLinksOf(const Entry& entry) {
+    const auto* begin = reinterpret_cast<const uint8_t*>(entry.code);
+    const uint8_t* end = begin + entry.code_size;
+    auto is_dead = [&](const PendingLink& link) {
+        return (link.jump >= begin && link.jump < end) ||
+               std::find(entry.return_slots.begin(), entry.return_slots.end(), link.slot) !=
+                   entry.return_slots.end();
+    };
+
+    for (auto it = pending_links_.begin(); it != pending_links_.end();) {
+        std::erase_if(it->second, is_dead);
+        it = it->second.empty() ? pending_links_.erase(it) : std::next(it);
+    }
+}
+
+void JitEngine::ResolveLink(const PendingLink& link, const uint8_t* body) {
+    if (link.slot != nullptr) {
+        *link.slot = body;
+        return;
+    }
+
+    const auto rel = static_cast<int32_t>(body - (link.jump + sizeof(int32_t)));
+    code_cache_.Patch(link.jump, {reinterpret_cast<const uint8_t*>(&rel), sizeof(rel)});
+}
+
+void JitEngine::AddLink(uint32_t target_pc, const PendingLink& link) {
+    const auto it = entries_.find(target_pc);
+    if (it != entries_.end() && it->second.body != nullptr) {
+        ResolveLink(link, it->second.body);
+    } else {
+        pending_links_[target_pc].push_back(link);
+    }
+}
+
+void JitEngine::Translate(Entry* entry) {
+    const auto& block = *entry->block;
+    entry->ops = block.ops;
+
+    code_buffer_.clear();
+    links_ = JitLinks{};
+    const size_t translated = TranslateBlockX86_64(entry->ops.data(), entry->ops.size(),
+                                                   block.start_pc, runtime_.get(),
+                                                   &code_buffer_, &links_);
+    if (translated == 0u) {
+        entry->not_translatable = true;
+        entry->ops.clear();
+        return;
+    }
+
+    // Flushing drops the return slots, so make room before the code refers to new ones.
+    if (!code_cache_.Fits(code_buffer_.size())) {
+        FlushCode();
+    }
+    if (!code_cache_.Fits(code_buffer_.size())) {
+        entry->not_translatable = true;
+        return;
+    }
+
+    std::vector<const void**> slots;
+    slots.reserve(links_.return_sites.size());
+    for (const auto& site : links_.return_sites) {
+        const void** slot = &return_slots_.emplace_back(nullptr);
+        const auto address = reinterpret_cast<uint64_t>(slot);
+        std::memcpy(code_buffer_.data() + site.offset, &address, sizeof(address));
+        slots.push_back(slot);
+    }
+
+    const uint8_t* code = code_cache_.Add(code_buffer_);
+    entry->code = reinterpret_cast<JitFunction>(code);
+    entry->body = code + links_.body_offset;
+    entry->code_size = code_buffer_.size();
+    entry->pcs = std::move(links_.pcs);
+    entry->return_slots = slots;
+    code_entries_[code] = entry;
+    runtime_->Remember(block.start_pc, entry->body);
+
+    if (auto it = pending_links_.find(block.start_pc); it != pending_links_.end()) {
+        for (const auto& link : it->second) {
+            ResolveLink(link, entry->body);
+        }
+        pending_links_.erase(it);
+    }
+
+    for (const auto& exit : links_.exits) {
+        AddLink(exit.target_pc, {.jump = code + exit.offset});
+    }
+    for (size_t i = 0; i < slots.size(); ++i) {
+        AddLink(links_.return_sites[i].return_pc, {.slot = slots[i]});
+    }
+
+    DLOG_F(INFO, "Translated block %x: %zu/%zu ops, %zu bytes",
+           block.start_pc, translated, block.ops.size(), code_buffer_.size());
+}
+
+bool JitEngine::LookupGuestPc(const void* engine, uintptr_t host_pc, uint32_t* guest_pc) {
+    const auto& code_entries = static_cast<const JitEngine*>(engine)->code_entries_;
+    const auto* host = reinterpret_cast<const uint8_t*>(host_pc);
+
+    auto it = code_entries.upper_bound(host);
+    if (it == code_entries.begin()) {
+        return false;
+    }
+    --it;
+    const auto& [code, entry] = *it;
+    const auto offset = static_cast<size_t>(host - code);
+    if (offset >= entry->code_size) {
+        return false;
+    }
+
+    const auto mark = std::upper_bound(entry->pcs.begin(), entry->pcs.end(), offset,
+                                       [](size_t value, const JitLinks::PcMark& m) { return value < m.offset; });
+    if (mark == entry->pcs.begin()) {
+        return false; // prologue
+    }
+    *guest_pc = std::prev(mark)->pc;
+    return true;
+}
+
+ExecutionStatus JitEngine::Run(InterpreterState* state) {
+    uint32_t* regs = state->regs.Data();
+    uint8_t* memory = state->memory.Data(); // nullptr unless memory is flat
+
+    while (state->status == ExecutionStatus::Success) {
+        if (state->memory.HasCodeWrites()) [[unlikely]] {
+            InvalidateWrittenCode(&state->memory);
+        }
+
+        auto& entry = GetEntry(state);
+
+        if (entry.code != nullptr) {
+            // Refill the slot in case a colliding block took it.
+            runtime_->Remember(state->pc, entry.body);
+            state->pc = entry.code(state, regs, memory);
+            continue;
+        }
+
+        ExecuteOps(state, entry.block->ops.data(), entry.block->ops.size());
+
+        if (!entry.not_translatable && ++entry.exec_count >= kHotThreshold) {
+            Translate(&entry);
+        }
+    }
+
+    return state->status;
+}
@@ -0,0 +1,673 @@
+#include "rvi_jit_x86_64.hpp"
+
+#include "rvi_instruction_list.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+using namespace rvi;
+
+#if defined(__x86_64__)
+
+namespace {
+
+// While a block runs: rbx = guest registers, r12 = guest memory base,
+// r13 = InterpreterState*. eax, ecx and edx are scratch.
+enum HostReg : uint8_t {
+    kRax = 0,
+    kRcx = 1,
+    kRdx = 2,
+    kRbx = 3,
+};
+
+// x86 condition codes, the low nibble of setcc/cmovcc.
+enum Cond : uint8_t {
+    kBelow        = 0x2,
+    kAboveOrEqual = 0x3,
+    kEqual        = 0x4,
+    kNotEqual     = 0x5,
+    kLess         = 0xC,
+    kGreaterEqual = 0xD,
+};
+
+using ExecTrampoline = void (*)(InterpreterState* state, const MicroOp* info, uint32_t pc);
+
+template <class Instr>
+void ExecAt(InterpreterState* state, const MicroOp* info, uint32_t pc) {
+    state->pc = pc;
+    Instr::Exec(state, *info);
+}
+
+const ExecTrampoline kTrampolines[] = {
+#define RVI_TRAMPOLINE_ENTRY(name, type) &ExecAt<type>,
+    RVI_INSTRUCTION_LIST(RVI_TRAMPOLINE_ENTRY)
+#undef RVI_TRAMPOLINE_ENTRY
+};
+
+using StoreTrampoline = uint32_t (*)(InterpreterState* state, const MicroOp* info, uint32_t pc);
+
+// Runs a store, returns non-zero if it wrote cached code.
+template <class Instr>
+uint32_t StoreAt(InterpreterState* state, const MicroOp* info, uint32_t pc) {
+    ExecAt<Instr>(state, info, pc);
+    return state->memory.HasCodeWrites() ? 1u : 0u;
+}
+
+class X86Emitter {
+private:
+    std::vector<uint8_t>* code_;
+    size_t start_;
+
+    static uint8_t ModRm(uint32_t mod, uint32_t reg, uint32_t rm) {
+        return static_cast<uint8_t>((mod << 6) | ((reg & 7u) << 3) | (rm & 7u));
+    }
+
+    // [rbx + 4 * guest]
+    void GuestOperand(uint32_t host, uint32_t guest) {
+        Byte(ModRm(1u, host, kRbx));
+        Byte(static_cast<uint8_t>(guest * 4u));
+    }
+
+    // [base + disp32], base is rax, rcx or rdx
+    void MemOperand(uint32_t reg, HostReg base, uint32_t disp) {
+        Byte(ModRm(2u, reg, base));
+        Imm32(disp);
+    }
+
+public:
+    explicit X86Emitter(std::vector<uint8_t>* code) : code_(code), start_(code->size()) {}
+
+    // Offsets are relative to the start of the block.
+    size_t Offset() const { return code_->size() - start_; }
+
+    void Byte(uint8_t byte) { code_->push_back(byte); }
+    template <class... T>
+    void Bytes(T... bytes) { (Byte(static_cast<uint8_t>(bytes)), ...); }
+
+    void Imm32(uint32_t value) {
+        for (uint32_t i = 0; i < 4u; ++i) {
+            Byte(static_cast<uint8_t>(value >> (8u * i)));
+        }
+    }
+
+    void Imm64(uint64_t value) {
+        Imm32(static_cast<uint32_t>(value));
+        Imm32(static_cast<uint32_t>(value >> 32u));
+    }
+
+    void Prologue() {
+        Bytes(0x53);             // push rbx
+        Bytes(0x41, 0x54);       // push r12
+        Bytes(0x41, 0x55);       // push r13, rsp is 16-byte aligned again
+        Bytes(0x49, 0x89, 0xFD); // mov r13, rdi
+        Bytes(0x48, 0x89, 0xF3); // mov rbx, rsi
+        Bytes(0x49, 0x89, 0xD4); // mov r12, rdx
+    }
+
+    // Returns eax as the next guest pc.
+    void Epilogue() {
+        Bytes(0x41, 0x5D); // pop r13
+        Bytes(0x41, 0x5C); // pop r12
+        Bytes(0x5B);       // pop rbx
+        Bytes(0xC3);       // ret
+    }
+
+    void LoadGuest(HostReg dst, uint32_t guest)  { Byte(0x8B); GuestOperand(dst, guest); }
+    void StoreGuest(uint32_t guest, HostReg src) { Byte(0x89); GuestOperand(src, guest); }
+
+    void StoreGuestImm(uint32_t guest, uint32_t imm) {
+        Byte(0xC7);
+        GuestOperand(0u, guest);
+        Imm32(imm);
+    }
+
+    // opcode dst, dword [guest]
+    void AluGuest(uint8_t opcode, HostReg dst, uint32_t guest) { Byte(opcode); GuestOperand(dst, guest); }
+    void ImulGuest(HostReg dst, uint32_t guest) { Bytes(0x0F, 0xAF); GuestOperand(dst, guest); }
+    void MovsxdGuest(HostReg dst, uint32_t guest) { Bytes(0x48, 0x63); GuestOperand(dst, guest); }
+
+    // 81 /ext: add 0, or 1, and 4, xor 6, cmp 7
+    void AluImm(uint8_t ext, HostReg reg, uint32_t imm) {
+        Byte(0x81);
+        Byte(ModRm(3u, ext, reg));
+        Imm32(imm);
+    }
+
+    // shl 4, shr 5, sar 7
+    void ShiftCl(uint8_t ext, HostReg reg) { Bytes(0xD3, ModRm(3u, ext, reg)); }
+    void ShiftImm(uint8_t ext, HostReg reg, uint8_t amount) { Bytes(0xC1, ModRm(3u, ext, reg), amount); }
+
+    void MovImm(HostReg reg, uint32_t imm) {
+        Byte(static_cast<uint8_t>(0xB8u + reg));
+        Imm32(imm);
+    }
+
+    // setcc al; movzx eax, al
+    void SetccEax(Cond cond) {
+        Bytes(0x0F, static_cast<uint8_t>(0x90u | cond), 0xC0);
+        Bytes(0x0F, 0xB6, 0xC0);
+    }
+
+    // rax = rax * rcx >> 32
+    void MulHigh64() {
+        Bytes(0x48, 0x0F, 0xAF, 0xC1); // imul rax, rcx
+        Bytes(0x48, 0xC1, 0xE8, 0x20); // shr rax, 32
+    }
+
+    // Returns the offset of imm.
+    size_t MovImm64(HostReg reg, uint64_t imm) {
+        Bytes(0x48, 0xB8u + reg);
+        Imm64(imm);
+        return Offset() - 8u;
+    }
+
+    void Load32(HostReg dst, HostReg base, uint32_t disp)  { Byte(0x8B); MemOperand(dst, base, disp); }
+    void Store32(HostReg base, uint32_t disp, HostReg src) { Byte(0x89); MemOperand(src, base, disp); }
+    void Load64(HostReg dst, HostReg base, uint32_t disp)  { Bytes(0x48, 0x8B); MemOperand(dst, base, disp); }
+    void Store64(HostReg base, uint32_t disp, HostReg src) { Bytes(0x48, 0x89); MemOperand(src, base, disp); }
+    void Cmp32(HostReg reg, HostReg base, uint32_t disp)   { Byte(0x3B); MemOperand(reg, base, disp); }
+
+    void StoreImm32(HostReg base, uint32_t disp, uint32_t imm) {
+        Byte(0xC7);
+        MemOperand(0u, base, disp);
+        Imm32(imm);
+    }
+
+    // 81 /ext dword [base + disp], imm
+    void AluMemImm(uint8_t ext, HostReg base, uint32_t disp, uint32_t imm) {
+        Byte(0x81);
+        MemOperand(ext, base, disp);
+        Imm32(imm);
+    }
+
+    void Mov32(HostReg dst, HostReg src) { Bytes(0x89, ModRm(3u, src, dst)); }
+    void Add64(HostReg dst, HostReg src) { Bytes(0x48, 0x01, ModRm(3u, src, dst)); }
+    void Test64(HostReg reg) { Bytes(0x48, 0x85, ModRm(3u, reg, reg)); }
+    void JmpReg(HostReg reg) { Bytes(0xFF, ModRm(3u, 4u, reg)); }
+    void JmpMem(HostReg base, uint32_t disp) { Byte(0xFF); MemOperand(4u, base, disp); }
+
+    // Jumps with a zero displacement, returning the offset of the displacement
+    // for PatchRel8/PatchRel32 or for the engine to link.
+    size_t Jmp32() { Byte(0xE9); Imm32(0u); return Offset() - 4u; }
+    size_t Jcc32(Cond cond) { Bytes(0x0F, 0x80u | cond); Imm32(0u); return Offset() - 4u; }
+    size_t Jcc8(Cond cond) { Bytes(0x70u | cond, 0x00); return Offset() - 1u; }
+
+    // Points the jump at offset to the current position.
+    void PatchRel8(size_t offset) {
+        (*code_)[start_ + offset] = static_cast<uint8_t>(Offset() - offset - 1u);
+    }
+    void PatchRel32(size_t offset) {
+        const auto rel = static_cast<uint32_t>(Offset() - offset - 4u);
+        std::memcpy(code_->data() + start_ + offset, &rel, sizeof(rel));
+    }
+
+    // opcode reg, [r12 + rax]
+    template <class... Opcode>
+    void GuestMemory(HostReg reg, Opcode... opcode) {
+        Byte(0x41); // REX.B selects r12 as the SIB base
+        Bytes(opcode...);
+        Byte(ModRm(0u, reg, 4u));
+        Byte(0x04); // SIB: index rax, base r12
+    }
+
+    // opcode reg, byte [r12 + rdx + kCodeMapOffset], rdx is a code granule
+    template <class... Opcode>
+    void CodeMap(HostReg reg, Opcode... opcode) {
+        Byte(0x41);
+        Bytes(opcode...);
+        Byte(ModRm(2u, reg, 4u));
+        Byte(0x14); // SIB: index rdx, base r12
+        Imm32(static_cast<uint32_t>(FlatMemory::kCodeMapOffset));
+    }
+
+    // lea dst, [src + disp8]
+    void Lea32(HostReg dst, HostReg src, uint8_t disp) { Bytes(0x8D, ModRm(1u, dst, src), disp); }
+    void Test32(HostReg reg) { Bytes(0x85, ModRm(3u, reg, reg)); }
+
+    template <class Trampoline>
+    void CallExec(Trampoline trampoline, const MicroOp* info, uint32_t pc) {
+        Bytes(0x4C, 0x89, 0xEF); // mov rdi, r13
+        Bytes(0x48, 0xBE);       // mov rsi, info
+        Imm64(reinterpret_cast<uint64_t>(info));
+        Byte(0xBA);                // mov edx, pc
+        Imm32(pc);
+        Bytes(0x48, 0xB8);       // mov rax, trampoline
+        Imm64(reinterpret_cast<uint64_t>(trampoline));
+        Bytes(0xFF, 0xD0);       // call rax
+    }
+};
+
+struct Context {
+    JitRuntime* runtime;
+    JitLinks*   links;
+};
+
+constexpr uint32_t kIndirectCacheOffset = offsetof(JitRuntime, indirect_cache);
+constexpr uint32_t kReturnStackOffset   = offsetof(JitRuntime, return_stack);
+constexpr uint32_t kReturnTopOffset     = offsetof(JitRuntime, return_top);
+constexpr uint32_t kTargetCodeOffset    = offsetof(JitTarget, code);
+constexpr uint32_t kReturnTopMask  = (JitRuntime::kReturnStackSize - 1u) * sizeof(JitTarget);
+constexpr uint32_t kIndirectMask   = (JitRuntime::kIndirectCacheSize - 1u) * sizeof(JitTarget);
+
+// ra and t0 are the link registers of the calling convention.
+bool IsLinkRegister(uint32_t reg) {
+    return reg == 1u || reg == 5u;
+}
+
+// Leaves the block for target_pc through a jump the engine links to the
+// target block once it is translated.
+void EmitDirectExit(X86Emitter* emit, const Context& ctx, uint32_t target_pc) {
+    ctx.links->exits.push_back({emit->Jmp32(), target_pc});
+    emit->MovImm(kRax, target_pc);
+    emit->Epilogue();
+}
+
+// Pushes return_pc with the body of its block, if translated, to the return
+// stack. Preserves eax.
+void EmitPushReturn(X86Emitter* emit, const Context& ctx, uint32_t return_pc) {
+    emit->MovImm64(kRdx, reinterpret_cast<uint64_t>(ctx.runtime));
+    emit->Load32(kRcx, kRdx, kReturnTopOffset);
+    emit->AluImm(0u, kRcx, sizeof(JitTarget));
+    emit->AluImm(4u, kRcx, kReturnTopMask);
+    emit->Store32(kRdx, kReturnTopOffset, kRcx);
+    emit->Add64(kRcx, kRdx);
+    emit->StoreImm32(kRcx, kReturnStackOffset, return_pc);
+    ctx.links->return_sites.push_back({emit->MovImm64(kRdx, 0u), return_pc});
+    emit->Load64(kRdx, kRdx, 0u);
+    emit->Store64(kRcx, kReturnStackOffset + kTargetCodeOffset, kRdx);
+}
+
+// Pops the return stack and jumps to the predicted block if it matches the
+// target in eax, otherwise continues with eax intact.
+void EmitPopReturn(X86Emitter* emit, const Context& ctx) {
+    emit->MovImm64(kRdx, reinterpret_cast<uint64_t>(ctx.runtime));
+    emit->Load32(kRcx, kRdx, kReturnTopOffset);
+    emit->AluMemImm(5u, kRdx, kReturnTopOffset, sizeof(JitTarget)); // sub
+    emit->AluMemImm(4u, kRdx, kReturnTopOffset, kReturnTopMask);    // and
+    emit->Add64(kRcx, kRdx);
+    emit->Cmp32(kRax, kRcx, kReturnStackOffset);
+    const size_t other_pc = emit->Jcc8(kNotEqual);
+    emit->Load64(kRcx, kRcx, kReturnStackOffset + kTargetCodeOffset);
+    emit->Test64(kRcx);
+    const size_t no_code = emit->Jcc8(kEqual);
+    emit->JmpReg(kRcx);
+    emit->PatchRel8(other_pc);
+    emit->PatchRel8(no_code);
+}
+
+// Jumps to the block at eax if it is in the indirect cache, otherwise
+// returns eax to the engine.
+void EmitIndirectExit(X86Emitter* emit, const Context& ctx) {
+    emit->Mov32(kRcx, kRax);
+    emit->ShiftImm(4u, kRcx, 2u); // pc / 4 * sizeof(JitTarget)
+    emit->AluImm(4u, kRcx, kIndirectMask);
+    emit->MovImm64(kRdx, reinterpret_cast<uint64_t>(ctx.runtime));
+    emit->Add64(kRcx, kRdx);
+    emit->Cmp32(kRax, kRcx, kIndirectCacheOffset);
+    const size_t miss = emit->Jcc8(kNotEqual);
+    emit->JmpMem(kRcx, kIndirectCacheOffset + kTargetCodeOffset);
+    emit->PatchRel8(miss);
+    emit->Epilogue();
+}
+
+// Stores that write cached code leave the block right after the store, so
+// the engine drops the stale blocks before any of them runs.
+void EmitStoreCall(X86Emitter* emit, StoreTrampoline trampoline, const MicroOp& op, uint32_t pc) {
+    emit->CallExec(trampoline, &op, pc);
+    emit->Test32(kRax);
+    const size_t no_code = emit->Jcc8(kEqual);
+    emit->MovImm(kRax, pc + 4u);
+    emit->Epilogue();
+    emit->PatchRel8(no_code);
+}
+
+// Skips the jump at the returned offset if neither the first nor the last
+// byte of the store at eax is in a code granule.
+size_t EmitCodeMapCheck(X86Emitter* emit, uint8_t size) {
+    emit->Mov32(kRdx, kRax);
+    emit->ShiftImm(5u, kRdx, static_cast<uint8_t>(kCodeGranuleBits));
+    emit->CodeMap(kRcx, 0x0F, 0xB6); // movzx
+    if (size > 1u) {
+        emit->Lea32(kRdx, kRax, static_cast<uint8_t>(size - 1u));
+        emit->ShiftImm(5u, kRdx, static_cast<uint8_t>(kCodeGranuleBits));
+        emit->CodeMap(kRcx, 0x0A); // or cl
+    }
+    emit->Test32(kRcx);
+    return emit->Jcc8(kEqual);
+}
+
+enum class EmitResult {
+    Next,
+    Exit,
+    Unsupported,
+};
+
+// Only the listed instructions are emitted inline, the rest call Exec.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-enum"
+
+StoreTrampoline GetStoreTrampoline(OpId id) {
+    switch (id) {
+        case OpId::Sb:  return &StoreAt<rv32i::Sb>;
+        case OpId::Sh:  return &StoreAt<rv32i::Sh>;
+        case OpId::Sw:  return &StoreAt<rv32i::Sw>;
+        case OpId::Fsw: return &StoreAt<rv32f::Fsw>;
+        default:        return nullptr;
+    }
+}
+
+EmitResult EmitOp(X86Emitter* emit, const Context& ctx, const MicroOp& op, uint32_t pc) {
+    const auto imm = static_cast<uint32_t>(op.imm);
+
+    auto reg_reg = [&](uint8_t opcode) {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->AluGuest(opcode, kRax, op.rs2);
+    };
+    auto shift_reg = [&](uint8_t ext) {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->LoadGuest(kRcx, op.rs2);
+        emit->ShiftCl(ext, kRax);
+    };
+    auto reg_imm = [&](uint8_t ext) {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->AluImm(ext, kRax, imm);
+    };
+    auto shift_imm = [&](uint8_t ext) {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->ShiftImm(ext, kRax, static_cast<uint8_t>(imm & 0x1Fu));
+    };
+    auto address = [&]() {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->AluImm(0u, kRax, imm);
+    };
+    auto branch = [&](Cond cond) {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->AluGuest(0x3B, kRax, op.rs2); // cmp
+        const size_t taken = emit->Jcc32(cond);
+        EmitDirectExit(emit, ctx, pc + 4u);
+        emit->PatchRel32(taken);
+        EmitDirectExit(emit, ctx, pc + imm);
+        return EmitResult::Exit;
+    };
+    auto set_branch = [&](Cond cond, bool branch_if_set) {
+        emit->LoadGuest(kRax, op.rs1);
+        emit->AluGuest(0x3B, kRax, op.rs2); // cmp
+        emit->SetccEax(cond);               // keeps the flags
+        if (op.rd != 0u) {
+            emit->StoreGuest(op.rd, kRax);
+        }
+        const size_t taken = emit->Jcc32(branch_if_set ? cond : static_cast<Cond>(cond ^ 1u));
+        EmitDirectExit(emit, ctx, pc + 8u);
+        emit->PatchRel32(taken);
+        EmitDirectExit(emit, ctx, pc + imm);
+        return EmitResult::Exit;
+    };
+
+    const auto id = static_cast<OpId>(op.handler);
+
+    if (const StoreTrampoline store = GetStoreTrampoline(id);
+        store != nullptr && (!InterpreterMemoryModel::kIsFlat || id == OpId::Fsw)) {
+        EmitStoreCall(emit, store, op, pc);
+        return EmitResult::Next;
+    }
+
+    if constexpr (!InterpreterMemoryModel::kIsFlat) {
+        // Without one flat mapping accesses go through the page tables in Exec.
+        switch (id) {
+            case OpId::Lb:
+            case OpId::Lbu:
+            case OpId::Lh:
+            case OpId::Lhu:
+            case OpId::Lw:
+            case OpId::AuipcLw:
+                emit->CallExec(kTrampolines[op.handler], &op, pc);
+                return EmitResult::Next;
+            default:
+                break;
+        }
+    }
+
+    switch (id) {
+        case OpId::Jal:
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, pc + 4u);
+            }
+            if (IsLinkRegister(op.rd)) {
+                EmitPushReturn(emit, ctx, pc + 4u);
+            }
+            EmitDirectExit(emit, ctx, pc + imm);
+            return EmitResult::Exit;
+
+        case OpId::Jalr:
+            address();
+            emit->AluImm(4u, kRax, ~1u);
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, pc + 4u);
+            }
+            if (IsLinkRegister(op.rd)) {
+                EmitPushReturn(emit, ctx, pc + 4u);
+            } else if (IsLinkRegister(op.rs1)) {
+                EmitPopReturn(emit, ctx);
+            }
+            EmitIndirectExit(emit, ctx);
+            return EmitResult::Exit;
+
+        case OpId::Beq:  return branch(kEqual);
+        case OpId::Bne:  return branch(kNotEqual);
+        case OpId::Blt:  return branch(kLess);
+        case OpId::Bge:  return branch(kGreaterEqual);
+        case OpId::Bltu: return branch(kBelow);
+        case OpId::Bgeu: return branch(kAboveOrEqual);
+
+        case OpId::AuipcJalr:
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, pc + fused::HiPart(op.imm));
+            }
+            if (op.rs3 != 0u) {
+                emit->StoreGuestImm(op.rs3, pc + 8u);
+            }
+            if (IsLinkRegister(op.rs3)) {
+                EmitPushReturn(emit, ctx, pc + 8u);
+            }
+            EmitDirectExit(emit, ctx, (pc + imm) & ~1u);
+            return EmitResult::Exit;
+
+        case OpId::SltBnez:  return set_branch(kLess, true);
+        case OpId::SltBeqz:  return set_branch(kLess, false);
+        case OpId::SltuBnez: return set_branch(kBelow, true);
+        case OpId::SltuBeqz: return set_branch(kBelow, false);
+
+        case OpId::LuiAddi:
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, imm);
+            }
+            return EmitResult::Next;
+
+        case OpId::AuipcLw:
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, pc + fused::HiPart(op.imm));
+            }
+            // A fault in the load is the lw's.
+            ctx.links->pcs.push_back({emit->Offset(), pc + 4u});
+            emit->MovImm(kRax, pc + imm);
+            emit->GuestMemory(kRax, 0x8B);
+            if (op.rs3 != 0u) {
+                emit->StoreGuest(op.rs3, kRax);
+            }
+            return EmitResult::Next;
+
+        case OpId::SlliAdd:
+            emit->LoadGuest(kRax, op.rs1);
+            emit->ShiftImm(4u, kRax, static_cast<uint8_t>(imm & 0x1Fu));
+            if (op.rd != 0u) {
+                emit->StoreGuest(op.rd, kRax);
+            }
+            emit->AluGuest(0x03, kRax, op.rs2); // add, rs2 may be rd
+            if (op.rs3 != 0u) {
+                emit->StoreGuest(op.rs3, kRax);
+            }
+            return EmitResult::Next;
+
+        case OpId::Sb:
+        case OpId::Sh:
+        case OpId::Sw: {
+            address();
+            const uint8_t size = id == OpId::Sb ? 1u : id == OpId::Sh ? 2u : 4u;
+            const size_t no_code = EmitCodeMapCheck(emit, size);
+            EmitStoreCall(emit, GetStoreTrampoline(id), op, pc);
+            emit->PatchRel8(no_code);
+
+            emit->LoadGuest(kRcx, op.rs2);
+            if (id == OpId::Sb) {
+                emit->GuestMemory(kRcx, 0x88);
+            } else {
+                if (id == OpId::Sh) {
+                    emit->Byte(0x66); // operand-size prefix
+                }
+                emit->GuestMemory(kRcx, 0x89);
+            }
+            return EmitResult::Next;
+        }
+
+        case OpId::Fence:
+            return EmitResult::Next;
+
+        case OpId::Ecall:
+        case OpId::Ebreak:
+            return EmitResult::Unsupported;
+
+        default:
+            break;
+    }
+
+    switch (id) {
+        case OpId::Add:  reg_reg(0x03); break;
+        case OpId::Sub:  reg_reg(0x2B); break;
+        case OpId::Xor:  reg_reg(0x33); break;
+        case OpId::Or:   reg_reg(0x0B); break;
+        case OpId::And:  reg_reg(0x23); break;
+        case OpId::Slt:  reg_reg(0x3B); emit->SetccEax(kLess);  break;
+        case OpId::Sltu: reg_reg(0x3B); emit->SetccEax(kBelow); break;
+        case OpId::Sll:  shift_reg(4u); break;
+        case OpId::Srl:  shift_reg(5u); break;
+        case OpId::Sra:  shift_reg(7u); break;
+
+        case OpId::Addi:  reg_imm(0u); break;
+        case OpId::Ori:   reg_imm(1u); break;
+        case OpId::Andi:  reg_imm(4u); break;
+        case OpId::Xori:  reg_imm(6u); break;
+        case OpId::Stli:  reg_imm(7u); emit->SetccEax(kLess);  break;
+        case OpId::Stliu: reg_imm(7u); emit->SetccEax(kBelow); break;
+        case OpId::Slli:  shift_imm(4u); break;
+        case OpId::Srli:  shift_imm(5u); break;
+        case OpId::Srai:  shift_imm(7u); break;
+
+        case OpId::Lb:  address(); emit->GuestMemory(kRax, 0x0F, 0xBE); break;
+        case OpId::Lbu: address(); emit->GuestMemory(kRax, 0x0F, 0xB6); break;
+        case OpId::Lh:  address(); emit->GuestMemory(kRax, 0x0F, 0xBF); break;
+        case OpId::Lhu: address(); emit->GuestMemory(kRax, 0x0F, 0xB7); break;
+        case OpId::Lw:  address(); emit->GuestMemory(kRax, 0x8B); break;
+
+        case OpId::Lui:
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, imm);
+            }
+            return EmitResult::Next;
+        case OpId::Auipc:
+            if (op.rd != 0u) {
+                emit->StoreGuestImm(op.rd, pc + imm);
+            }
+            return EmitResult::Next;
+
+        case OpId::Mul:
+            emit->LoadGuest(kRax, op.rs1);
+            emit->ImulGuest(kRax, op.rs2);
+            break;
+        case OpId::Mulh:
+            emit->MovsxdGuest(kRax, op.rs1);
+            emit->MovsxdGuest(kRcx, op.rs2);
+            emit->MulHigh64();
+            break;
+        case OpId::Mulhsu:
+            emit->MovsxdGuest(kRax, op.rs1);
+            emit->LoadGuest(kRcx, op.rs2);
+            emit->MulHigh64();
+            break;
+        case OpId::Mulhu:
+            emit->LoadGuest(kRax, op.rs1);
+            emit->LoadGuest(kRcx, op.rs2);
+            emit->MulHigh64();
+            break;
+
+        default:
+            // Division, F and Zbb run their interpreter implementation.
+            emit->CallExec(kTrampolines[op.handler], &op, pc);
+            return EmitResult::Next;
+    }
+
+    if (op.rd != 0u) {
+        emit->StoreGuest(op.rd, kRax);
+    }
+    return EmitResult::Next;
+}
+
+#pragma GCC diagnostic pop
+
+} // namespace
+
+size_t rvi::TranslateBlockX86_64(const MicroOp* ops, size_t count, uint32_t start_pc,
+                                 JitRuntime* runtime, std::vector<uint8_t>* code, JitLinks* links) {
+    if (count == 0u) {
+        return 0u;
+    }
+
+    const size_t code_start = code->size();
+    X86Emitter emit(code);
+    const Context ctx{runtime, links};
+
+    emit.Prologue();
+    links->body_offset = emit.Offset();
+
+    uint32_t pc = start_pc;
+    for (size_t i = 0; i < count; pc += OpLength(ops[i].handler), ++i) {
+        links->pcs.push_back({emit.Offset(), pc});
+        switch (EmitOp(&emit, ctx, ops[i], pc)) {
+            case EmitResult::Next:
+            default:
+                break;
+
+            case EmitResult::Exit:
+                return i + 1u;
+
+            case EmitResult::Unsupported:
+                if (i == 0u) {
+                    code->resize(code_start);
+                    return 0u;
+                }
+                EmitDirectExit(&emit, ctx, pc);
+                return i;
+        }
+    }
+
+    EmitDirectExit(&emit, ctx, pc);
+    return count;
+}
+
+void rvi::EmitExitStubX86_64(uint32_t pc, std::vector<uint8_t>* code) {
+    X86Emitter emit(code);
+    emit.MovImm(kRax, pc);
+    emit.Epilogue();
+}
+
+#else
+
+size_t rvi::TranslateBlockX86_64(const MicroOp* /*ops*/, size_t /*count*/, uint32_t /*start_pc*/,
+                                 JitRuntime* /*runtime*/, std::vector<uint8_t>* /*code*/,
+                                 JitLinks* /*links*/) {
+    return 0u;
+}
+
+void rvi::EmitExitStubX86_64(uint32_t /*pc*/, std::vector<uint8_t>* /*code*/) {
+}
+
+#endif
@@ -0,0 +1,226 @@
+#include "rvi_json.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace rvi;
+
+namespace {
+
+// Nesting deeper than this is rejected instead of overflowing the stack.
+constexpr size_t kMaxDepth = 256u;
+
+class Parser {
+    std::string_view text_;
+    size_t pos_ = 0u;
+    size_t depth_ = 0u;
+
+    [[noreturn]] void Fail(const char* what) const {
+        throw std::runtime_error("Invalid JSON at offset " + std::to_string(pos_) + ": " + what);
+    }
+
+    void SkipSpace() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+                                       text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool Consume(std::string_view token) {
+        if (text_.substr(pos_).starts_with(token)) {
+            pos_ += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c) {
+        SkipSpace();
+        if (pos_ >= text_.size() || text_[pos_] != c) {
+            Fail("unexpected character");
+        }
+        ++pos_;
+    }
+
+    uint32_t Hex4() {
+        if (pos_ + 4u > text_.size()) {
+            Fail("truncated escape");
+        }
+        uint32_t value = 0u;
+        for (size_t end = pos_ + 4u; pos_ < end; ++pos_) {
+            const char c = text_[pos_];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                Fail("invalid escape");
+            }
+        }
+        return value;
+    }
+
+    static void AppendUtf8(std::string* out, uint32_t code) {
+        if (code < 0x80u) {
+            out->push_back(static_cast<char>(code));
+        } else if (code < 0x800u) {
+            out->push_back(static_cast<char>(0xC0u | (code >> 6)));
+            out->push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+        } else if (code < 0x10000u) {
+            out->push_back(static_cast<char>(0xE0u | (code >> 12)));
+            out->push_back(static_cast<char>(0x80u | ((code >> 6) & 0x3Fu)));
+            out->push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+        } else {
+            out->push_back(static_cast<char>(0xF0u | (code >> 18)));
+            out->push_back(static_cast<char>(0x80u | ((code >> 12) & 0x3Fu)));
+            out->push_back(static_cast<char>(0x80u | ((code >> 6) & 0x3Fu)));
+            out->push_back(static_cast<char>(0x80u | (code & 0x3Fu)));
+        }
+    }
+
+    std::string String() {
+        Expect('"');
+        std::string out;
+        while (true) {
+            if (pos_ >= text_.size()) {
+                Fail("unterminated string");
+            }
+            const char c = text_[pos_++];
+            if (c == '"') {
+                return out;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                Fail("unterminated string");
+            }
+            switch (text_[pos_++]) {
+                case '"':  out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/':  out.push_back('/'); break;
+                case 'b':  out.push_back('\b'); break;
+                case 'f':  out.push_back('\f'); break;
+                case 'n':  out.push_back('\n'); break;
+                case 'r':  out.push_back('\r'); break;
+                case 't':  out.push_back('\t'); break;
+                case 'u': {
+                    uint32_t code = Hex4();
+                    if (code >= 0xD800u && code < 0xDC00u && Consume("\\u")) {
+                        const uint32_t low = Hex4();
+                        code = 0x10000u + ((code - 0xD800u) << 10) + (low - 0xDC00u);
+                    }
+                    AppendUtf8(&out, code);
+                    break;
+                }
+                default:
+                    Fail("invalid escape");
+            }
+        }
+    }
+
+    double Number() {
+        const size_t start = pos_;
+        while (pos_ < text_.size() && std::string_view("+-0123456789.eE").find(text_[pos_]) != std::string_view::npos) {
+            ++pos_;
+        }
+        const std::string number(text_.substr(start, pos_ - start));
+        char* end = nullptr;
+        const double value = std::strtod(number.c_str(), &end);
+        if (number.empty() || end != number.c_str() + number.size()) {
+            pos_ = start;
+            Fail("invalid number");
+        }
+        return value;
+    }
+
+public:
+    explicit Parser(std::string_view text) : text_(text) {}
+
+    Json Value() {
+        SkipSpace();
+        if (pos_ >= text_.size()) {
+            Fail("unexpected end");
+        }
+        if (++depth_ > kMaxDepth) {
+            Fail("nested too deeply");
+        }
+
+        Json value;
+        const char c = text_[pos_];
+        if (c == '{') {
+            ++pos_;
+            Json::Object object;
+            SkipSpace();
+            if (!Consume("}")) {
+                do {
+                    std::string key = String();
+                    Expect(':');
+                    object.emplace_back(std::move(key), Value());
+                    SkipSpace();
+                } while (Consume(","));
+                Expect('}');
+            }
+            value = Json(std::move(object));
+        } else if (c == '[') {
+            ++pos_;
+            Json::Array array;
+            SkipSpace();
+            if (!Consume("]")) {
+                do {
+                    array.push_back(Value());
+                    SkipSpace();
+                } while (Consume(","));
+                Expect(']');
+            }
+            value = Json(std::move(array));
+        } else if (c == '"') {
+            value = Json(String());
+        } else if (Consume("true")) {
+            value = Json(true);
+        } else if (Consume("false")) {
+            value = Json(false);
+        } else if (Consume("null")) {
+            value = Json(nullptr);
+        } else {
+            value = Json(Number());
+        }
+
+        --depth_;
+        return value;
+    }
+
+    void End() {
+        SkipSpace();
+        if (pos_ != text_.size()) {
+            Fail("trailing characters");
+        }
+    }
+};
+
+} // namespace
+
+Json Json::Parse(std::string_view text) {
+    Parser parser(text);
+    Json value = parser.Value();
+    parser.End();
+    return value;
+}
+
+const Json* Json::Find(std::string_view key) const noexcept {
+    const Object* object = AsObject();
+    if (object == nullptr) {
+        return nullptr;
+    }
+    for (const auto& [name, value] : *object) {
+        if (name == key) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
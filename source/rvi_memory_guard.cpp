@@ -0,0 +1,124 @@
+#include "rvi_memory_guard.hpp"
+
+#include <cstddef>
+#include <csignal>
+#include <mutex>
+#include <stdexcept>
+#include <ucontext.h>
+#include <utility>
+
+using namespace rvi;
+
+namespace {
+
+// Synchronous SIGSEGVs are delivered to the faulting thread.
+thread_local MemoryGuard* tls_armed_guard = nullptr;
+
+// The handler is process-wide: it is installed while any thread has a guard
+// armed, and threads only differ in tls_armed_guard.
+std::mutex handler_mutex;
+size_t armed_guards = 0u;
+struct sigaction previous_handler{};
+
+uintptr_t HostPc([[maybe_unused]] const void* context) {
+#if defined(__x86_64__) && defined(__linux__)
+    return static_cast<uintptr_t>(static_cast<const ucontext_t*>(context)->uc_mcontext.gregs[REG_RIP]);
+#else
+    return 0u;
+#endif
+}
+
+// Hands a fault that is no guest's to the handler installed before the
+// guards, without uninstalling the guards of other threads.
+void ForwardFault(int signal, siginfo_t* info, void* context) {
+    if (previous_handler.sa_flags & SA_SIGINFO) {
+        previous_handler.sa_sigaction(signal, info, context);
+    } else if (previous_handler.sa_handler != SIG_DFL && previous_handler.sa_handler != SIG_IGN) {
+        previous_handler.sa_handler(signal);
+    } else {
+        // The default action ends the process on the refault anyway.
+        std::signal(SIGSEGV, SIG_DFL);
+    }
+}
+
+} // namespace
+
+MemoryGuard::MemoryGuard(InterpreterState* state)
+    : state_(state) {
+}
+
+void MemoryGuard::Arm() {
+    // Paged memory checks every access, the handler is for guards only.
+    handles_signals_ = state_->memory.IsGuarded();
+    if (handles_signals_) {
+        const std::lock_guard lock(handler_mutex);
+        if (armed_guards == 0u) {
+            struct sigaction action{};
+            action.sa_sigaction = &MemoryGuard::Handler;
+            action.sa_flags = SA_SIGINFO;
+            sigemptyset(&action.sa_mask);
+
+            if (sigaction(SIGSEGV, &action, &previous_handler) != 0) {
+                throw std::runtime_error("Failed to install the SIGSEGV handler");
+            }
+        }
+        ++armed_guards;
+    }
+    tls_armed_guard = this;
+}
+
+void MemoryGuard::Disarm() noexcept {
+    tls_armed_guard = nullptr;
+    if (!handles_signals_) {
+        return;
+    }
+
+    const std::lock_guard lock(handler_mutex);
+    if (--armed_guards == 0u) {
+        sigaction(SIGSEGV, &previous_handler, nullptr);
+    }
+}
+
+void MemoryGuard::Handler(int signal, siginfo_t* info, void* context) {
+    MemoryGuard* guard = tls_armed_guard;
+
+    uint32_t address = 0u;
+    if (guard == nullptr || !guard->state_->memory.ToGuest(info->si_addr, &address)) {
+        // A host bug, also in a HostCodeScope.
+        ForwardFault(signal, info, context);
+        return;
+    }
+
+    // Interpreters advance pc after the access, generated code never stores it.
+    uint32_t pc = guard->state_->pc;
+    if (guard->lookup_ != nullptr) {
+        guard->lookup_(guard->lookup_context_, HostPc(context), &pc);
+    }
+
+    guard->fault_ = {address, pc};
+    siglongjmp(guard->jump_, 1);
+}
+
+void MemoryGuard::RaiseFault(uint32_t address) {
+    if (MemoryGuard* guard = tls_armed_guard; guard != nullptr) {
+        // Generated code calls Exec for checked accesses, which sets pc.
+        RaiseFault(address, guard->state_->pc);
+    }
+}
+
+void MemoryGuard::RaiseFault(uint32_t address, uint32_t pc) {
+    MemoryGuard* guard = tls_armed_guard;
+    if (guard == nullptr) {
+        return;
+    }
+    guard->fault_ = {address, pc};
+    siglongjmp(guard->jump_, 1);
+}
+
+HostCodeScope::HostCodeScope() noexcept
+    : guard_(std::exchange(tls_armed_guard, nullptr)) {
+}
+
+HostCodeScope::~HostCodeScope() {
+    tls_armed_guard = guard_;
+}
@@ -1,7 +1,353 @@
 #include "rvi_memory_state.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
 using namespace rvi;
 
-InterpreterMemoryModel::InterpreterMemoryModel()
-    : memory_(kMemorySize) 
-{}
\ No newline at end of file
+size_t SharedCodeWrites::AddView() {
+    const std::lock_guard lock(mutex_);
+    inboxes_.emplace_back();
+    return inboxes_.size() - 1u;
+}
+
+void SharedCodeWrites::Exchange(size_t view, std::vector<CodeWrite>* writes) {
+    const std::lock_guard lock(mutex_);
+    if (!writes->empty()) {
+        for (size_t other = 0u; other < inboxes_.size(); ++other) {
+            if (other == view) {
+                continue;
+            }
+            // A store looping over data next to code repeats its write.
+            auto& inbox = inboxes_[other].writes;
+            for (const auto& write : *writes) {
+                if (inbox.empty() || inbox.back().address != write.address || inbox.back().size != write.size) {
+                    inbox.push_back(write);
+                }
+            }
+            inboxes_[other].pending.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    Inbox& own = inboxes_[view];
+    if (own.pending.load(std::memory_order_relaxed)) {
+        writes->insert(writes->end(), own.writes.begin(), own.writes.end());
+        own.writes.clear();
+        own.pending.store(false, std::memory_order_relaxed);
+    }
+}
+
+FlatMemory::FlatMemory() {
+    void* addr = mmap(nullptr, kReservationSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Guest memory map failed");
+    }
+
+    reservation_ = static_cast<uint8_t*>(addr);
+    const auto base = reinterpret_cast<uintptr_t>(reservation_) + kPageMapSize + kCodeMapSize;
+    memory_ = reservation_ + ((kHugePageSize - base % kHugePageSize) % kHugePageSize) + kPageMapSize + kCodeMapSize;
+}
+
+FlatMemory::FlatMemory(FlatMemory* owner, SharedCodeWrites* shared)
+    : memory_(owner->memory_),
+      guarded_(owner->guarded_),
+      huge_pages_(owner->huge_pages_),
+      shared_code_writes_(shared),
+      view_(shared->AddView()) {
+}
+
+FlatMemory::~FlatMemory() {
+    if (reservation_) {
+        munmap(reservation_, kReservationSize);
+    }
+}
+
+size_t FlatMemory::PageSize() noexcept {
+    static const size_t kPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return kPageSize;
+}
+
+void FlatMemory::MapFile(uint32_t address, int fd, size_t file_offset, size_t size) {
+    assert(address % PageSize() == 0u && file_offset % PageSize() == 0u && size % PageSize() == 0u);
+    assert(address + size <= kMemorySize);
+
+    void* addr = mmap(memory_ + address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                      fd, static_cast<off_t>(file_offset));
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Segment map failed");
+    }
+    if (guarded_) {
+        SetPageMap(address, address + size, kPermRead | kPermWrite);
+    }
+}
+
+void FlatMemory::EnableGuards() {
+    if (mprotect(memory_, kMemorySize + kTailSlack, PROT_NONE) != 0) {
+        throw std::runtime_error("Guest memory protect failed");
+    }
+    guarded_ = true;
+}
+
+bool FlatMemory::ToGuest(const void* host, uint32_t* address) const noexcept {
+    const auto* byte = static_cast<const uint8_t*>(host);
+    if (byte < memory_ || byte >= memory_ + kMemorySize + kTailSlack) {
+        return false;
+    }
+    // Slack addresses are where the access wrapped around to.
+    *address = static_cast<uint32_t>(byte - memory_);
+    return true;
+}
+
+void FlatMemory::Protect(uint32_t address, size_t size, uint8_t permissions) {
+    if (!guarded_ || size == 0u) {
+        return;
+    }
+
+    const uintptr_t page = PageSize();
+    const uintptr_t start = address & ~(page - 1u);
+    const uintptr_t end = (static_cast<uintptr_t>(address) + size + page - 1u) & ~(page - 1u);
+
+    int prot = PROT_NONE;
+    if (permissions != 0u) {
+        // Fetches are plain reads, so execute-only pages stay readable.
+        prot |= PROT_READ;
+    }
+    if (permissions & kPermWrite) {
+        prot |= PROT_WRITE;
+    }
+
+    if (mprotect(memory_ + start, end - start, prot) != 0) {
+        throw std::runtime_error("Guest memory protect failed");
+    }
+    const auto host_permissions = static_cast<uint8_t>(prot == PROT_NONE ? 0u : kPermRead | (permissions & kPermWrite));
+    SetPageMap(start, std::min<uintptr_t>(end, kMemorySize), host_permissions);
+}
+
+void FlatMemory::Discard(uint32_t address, size_t size) {
+    assert(address % PageSize() == 0u && size % PageSize() == 0u);
+    assert(address + size <= kMemorySize);
+    if (size == 0u) {
+        return;
+    }
+
+    // Unlike MADV_DONTNEED this also drops pages mapped from a file.
+    void* addr = mmap(memory_ + address, size, guarded_ ? PROT_NONE : PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Guest memory discard failed");
+    }
+    if (huge_pages_) {
+        madvise(addr, size, MADV_HUGEPAGE);
+    }
+    if (guarded_) {
+        SetPageMap(address, address + size, 0u);
+    }
+
+    const uint8_t* code_map = memory_ + kCodeMapOffset;
+    const uint32_t first = address >> kCodeGranuleBits;
+    const auto last = static_cast<uint32_t>((address + size - 1u) >> kCodeGranuleBits);
+    if (std::any_of(code_map + first, code_map + last + 1u, [](uint8_t b) { return b != 0u; })) {
+        code_writes_.push_back({address, static_cast<uint32_t>(size)});
+    }
+}
+
+void FlatMemory::SetPageMap(uintptr_t start, uintptr_t end, uint8_t permissions) noexcept {
+    const uintptr_t page = PageSize();
+    const uintptr_t first = start / page;
+    const uintptr_t last = (end + page - 1u) / page;
+    std::memset(PageMap() + first, permissions, last - first);
+}
+
+bool FlatMemory::IsAccessible(uint32_t address, uint32_t size, uint8_t permission) const noexcept {
+    if (!guarded_ || size == 0u) {
+        return true;
+    }
+    const uintptr_t page = PageSize();
+    const uint8_t* page_map = PageMap();
+    const uintptr_t last = (static_cast<uintptr_t>(address) + size - 1u) / page;
+    for (uintptr_t i = address / page; i <= last; ++i) {
+        if (!(page_map[i] & permission)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FlatMemory::Unguard(uint32_t address, size_t size) {
+    Protect(address, size, kPermRead | kPermWrite);
+}
+
+std::vector<CodeWrite> FlatMemory::TakeCodeWrites() {
+    std::vector<CodeWrite> writes = std::exchange(code_writes_, {});
+    if (shared_code_writes_ != nullptr) {
+        shared_code_writes_->Exchange(view_, &writes);
+    }
+    return writes;
+}
+
+void FlatMemory::MarkCode(uint32_t begin, uint32_t end) {
+    if (end <= begin) {
+        return;
+    }
+    const uint32_t first = begin >> kCodeGranuleBits;
+    const uint32_t last  = (end - 1u) >> kCodeGranuleBits;
+    std::memset(memory_ + kCodeMapOffset + first, 1, last - first + 1u);
+}
+
+bool FlatMemory::EnableHugePages() noexcept {
+    huge_pages_ = madvise(memory_, kMemorySize, MADV_HUGEPAGE) == 0;
+    return huge_pages_;
+}
+
+MemoryUsage FlatMemory::Usage() const {
+    MemoryUsage usage;
+
+    FILE* smaps = std::fopen("/proc/self/smaps", "r");
+    if (smaps == nullptr) {
+        return usage;
+    }
+
+    const auto guest_begin = reinterpret_cast<uintptr_t>(memory_);
+    const uintptr_t guest_end = guest_begin + kMemorySize + kTailSlack;
+    bool in_guest = false;
+
+    char line[512];
+    while (std::fgets(line, sizeof(line), smaps) != nullptr) {
+        uintptr_t begin = 0u;
+        uintptr_t end = 0u;
+        size_t kib = 0u;
+        // Mappings start with their range, their fields follow.
+        if (std::sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &begin, &end) == 2) {
+            in_guest = begin >= guest_begin && end <= guest_end;
+        } else if (in_guest && std::sscanf(line, "Rss: %zu kB", &kib) == 1) {
+            usage.resident_bytes += kib << 10;
+        } else if (in_guest && std::sscanf(line, "AnonHugePages: %zu kB", &kib) == 1) {
+            usage.huge_page_bytes += kib << 10;
+        }
+    }
+
+    std::fclose(smaps);
+    return usage;
+}
+
+std::vector<MemoryRegion> FlatMemory::Regions() const {
+    std::vector<MemoryRegion> regions;
+
+    FILE* maps = std::fopen("/proc/self/maps", "r");
+    const int pagemap = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (maps == nullptr || pagemap < 0) {
+        if (maps != nullptr) {
+            std::fclose(maps);
+        }
+        throw std::runtime_error("Guest memory map is not readable");
+    }
+
+    const auto guest_begin = reinterpret_cast<uintptr_t>(memory_);
+    const uintptr_t guest_end = guest_begin + kMemorySize;
+    const uintptr_t page = PageSize();
+
+    // pagemap has one entry per page; bit 63 is set for present pages, bit
+    // 62 for swapped ones. Neither means the guest never touched the page.
+    constexpr uint64_t kTouched = (1ull << 63) | (1ull << 62);
+    constexpr size_t kBatch = 4096u;
+    std::vector<uint64_t> entries(kBatch);
+
+    auto add = [&](uintptr_t begin, uintptr_t end, uint8_t permissions, bool touched) {
+        const auto address = static_cast<uint32_t>(begin - guest_begin);
+        const uint8_t* data = touched ? memory_ + address : nullptr;
+        if (!regions.empty()) {
+            auto& last = regions.back();
+            if (last.address + last.size == address && last.permissions == permissions &&
+                (last.data != nullptr) == touched) {
+                last.size += end - begin;
+                return;
+            }
+        }
+        regions.push_back({address, end - begin, permissions, data});
+    };
+
+    char line[512];
+    while (std::fgets(line, sizeof(line), maps) != nullptr) {
+        uintptr_t begin = 0u;
+        uintptr_t end = 0u;
+        char prot[5] = {};
+        unsigned long inode = 0u;
+        if (std::sscanf(line, "%" SCNxPTR "-%" SCNxPTR " %4s %*x %*x:%*x %lu", &begin, &end, prot, &inode) != 4) {
+            continue;
+        }
+        begin = std::max(begin, guest_begin);
+        end = std::min(end, guest_end);
+        if (begin >= end || prot[0] != 'r') {
+            continue;
+        }
+
+        // Fetches are plain reads, so readable memory is executable.
+        const auto permissions = static_cast<uint8_t>(kPermRead | kPermExec | (prot[1] == 'w' ? kPermWrite : 0));
+        if (inode != 0u) {
+            add(begin, end, permissions, true);
+            continue;
+        }
+
+        for (uintptr_t batch = begin; batch < end; batch += kBatch * page) {
+            const size_t count = std::min<size_t>(kBatch, (end - batch) / page);
+            const auto bytes = static_cast<ssize_t>(count * sizeof(uint64_t));
+            if (pread(pagemap, entries.data(), static_cast<size_t>(bytes),
+                      static_cast<off_t>(batch / page * sizeof(uint64_t))) != bytes) {
+                std::fclose(maps);
+                close(pagemap);
+                throw std::runtime_error("Guest memory map is not readable");
+            }
+            for (size_t i = 0u; i < count; ++i) {
+                add(batch + i * page, batch + (i + 1u) * page, permissions, (entries[i] & kTouched) != 0u);
+            }
+        }
+    }
+
+    std::fclose(maps);
+    close(pagemap);
+    return regions;
+}
+
+bool FlatMemory::ReadSpans(uint32_t address, uint32_t size,
+                           std::vector<std::span<const uint8_t>>* spans) const {
+    const auto head = static_cast<uint32_t>(std::min<uint64_t>(size, kMemorySize - address));
+    if (!IsAccessible(address, head, kPermRead) || !IsAccessible(0u, size - head, kPermRead)) {
+        return false;
+    }
+    spans->emplace_back(memory_ + address, head);
+    if (head < size) {
+        spans->emplace_back(memory_, size - head);
+    }
+    return true;
+}
+
+bool FlatMemory::WriteSpans(uint32_t address, uint32_t size, std::vector<std::span<uint8_t>>* spans) {
+    const auto head = static_cast<uint32_t>(std::min<uint64_t>(size, kMemorySize - address));
+    if (!IsAccessible(address, head, kPermWrite) || !IsAccessible(0u, size - head, kPermWrite)) {
+        return false;
+    }
+    spans->emplace_back(memory_ + address, head);
+    if (head < size) {
+        spans->emplace_back(memory_, size - head);
+    }
+
+    for (const auto& span : *spans) {
+        const auto begin = static_cast<uint32_t>(span.data() - memory_);
+        const uint8_t* code_map = memory_ + kCodeMapOffset;
+        const uint32_t first = begin >> kCodeGranuleBits;
+        const uint32_t last  = static_cast<uint32_t>((begin + span.size() - 1u) >> kCodeGranuleBits);
+        if (!span.empty() && std::any_of(code_map + first, code_map + last + 1u, [](uint8_t b) { return b != 0u; })) {
+            code_writes_.push_back({begin, static_cast<uint32_t>(span.size())});
+        }
+    }
+    return true;
+}
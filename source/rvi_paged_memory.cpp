@@ -0,0 +1,283 @@
+#include "rvi_paged_memory.hpp"
+
+#include "rvi_memory_guard.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <sys/types.h>
+#include <unistd.h>
+
+using namespace rvi;
+
+namespace {
+
+// Backs read TLB entries of pages that were never written.
+alignas(4096) const std::array<uint8_t, PagedMemory::kPageSize> kZeroPage{};
+
+// A guest fault if the engine runs under a MemoryGuard, which never throws
+// across generated code. Only host code outside one gets the exception.
+[[noreturn]] void Fault(const char* access, uint32_t address, bool fetch = false) {
+    LOG_F(ERROR, "Memory %s fault at %x", access, address);
+    if (fetch) {
+        MemoryGuard::RaiseFault(address, address);
+    } else {
+        MemoryGuard::RaiseFault(address);
+    }
+    throw std::runtime_error("Memory access fault");
+}
+
+} // namespace
+
+PagedMemory::PagedMemory(size_t page_limit)
+    : page_limit_(page_limit) {
+}
+
+PagedMemory::Page* PagedMemory::FindPage(uint32_t address) const noexcept {
+    const auto& table = directory_[address >> (kPageBits + kLevelBits)];
+    if (!table) {
+        return nullptr;
+    }
+    return (*table)[(address >> kPageBits) & (kLevelSize - 1u)].get();
+}
+
+PagedMemory::Page& PagedMemory::GetOrCreatePage(uint32_t address) {
+    auto& table = directory_[address >> (kPageBits + kLevelBits)];
+    if (!table) {
+        table = std::make_unique<PageTable>();
+    }
+
+    auto& page = (*table)[(address >> kPageBits) & (kLevelSize - 1u)];
+    if (!page) {
+        if (page_count_ >= page_limit_) {
+            throw std::runtime_error("Guest memory limit exceeded");
+        }
+        page = std::make_unique<Page>();
+        ++page_count_;
+        // The read TLB may still point at the zero page.
+        read_tlb_[TlbIndex(address)] = TlbEntry{};
+    }
+    return *page;
+}
+
+void PagedMemory::FlushTlb() noexcept {
+    read_tlb_.fill(TlbEntry{});
+    write_tlb_.fill(TlbEntry{});
+}
+
+const uint8_t* PagedMemory::TranslateRead(uint32_t address) const {
+    const Page* page = FindPage(address);
+    const uint8_t permissions = page != nullptr ? page->permissions : kDefaultPermissions;
+    if (!(permissions & kPermRead)) {
+        Fault("read", address);
+    }
+
+    const uint8_t* base = page != nullptr ? page->data.data() : kZeroPage.data();
+    const uint32_t page_address = address & ~kPageMask;
+    read_tlb_[TlbIndex(address)] = {page_address, reinterpret_cast<uintptr_t>(base) - page_address};
+
+    return base + (address & kPageMask);
+}
+
+uint8_t* PagedMemory::TranslateWrite(uint32_t address) {
+    Page* page = FindPage(address);
+    if (!((page != nullptr ? page->permissions : kDefaultPermissions) & kPermWrite)) {
+        Fault("write", address);
+    }
+    if (page == nullptr) {
+        page = &GetOrCreatePage(address);
+    }
+    page->dirty = true;
+
+    // Stores to pages with code take the slow path, which records them.
+    if (page->code.none()) {
+        const uint32_t page_address = address & ~kPageMask;
+        write_tlb_[TlbIndex(address)] = {page_address, reinterpret_cast<uintptr_t>(page->data.data()) - page_address};
+    }
+
+    return page->data.data() + (address & kPageMask);
+}
+
+void PagedMemory::ReadSlow(uint32_t address, void* dst, size_t size) const {
+    auto* bytes = static_cast<uint8_t*>(dst);
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = *TranslateRead(address + static_cast<uint32_t>(i));
+    }
+}
+
+void PagedMemory::WriteSlow(uint32_t address, const void* src, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < size; ++i) {
+        *TranslateWrite(address + static_cast<uint32_t>(i)) = bytes[i];
+    }
+
+    if (IsCode(address) || IsCode(address + static_cast<uint32_t>(size - 1u))) {
+        code_writes_.push_back({address, static_cast<uint32_t>(size)});
+    }
+}
+
+bool PagedMemory::IsCode(uint32_t address) const noexcept {
+    const Page* page = FindPage(address);
+    return page != nullptr && page->code.test((address & kPageMask) >> kCodeGranuleBits);
+}
+
+bool PagedMemory::CanFetch(uint32_t address) const noexcept {
+    for (uint32_t i = 0; i < sizeof(uint32_t); ++i) {
+        const Page* page = FindPage(address + i);
+        if (!((page != nullptr ? page->permissions : kDefaultPermissions) & kPermExec)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t PagedMemory::Fetch(uint32_t address) const {
+    if (!CanFetch(address)) {
+        Fault("execute", address, true);
+    }
+    return Read<uint32_t>(address);
+}
+
+bool PagedMemory::ReadSpans(uint32_t address, uint32_t size,
+                            std::vector<std::span<const uint8_t>>* spans) const {
+    while (size > 0u) {
+        const Page* page = FindPage(address);
+        if (!((page != nullptr ? page->permissions : kDefaultPermissions) & kPermRead)) {
+            return false;
+        }
+
+        const uint32_t offset = address & kPageMask;
+        const uint32_t chunk = std::min(size, kPageSize - offset);
+        const uint8_t* base = page != nullptr ? page->data.data() : kZeroPage.data();
+        spans->emplace_back(base + offset, chunk);
+
+        address += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool PagedMemory::WriteSpans(uint32_t address, uint32_t size, std::vector<std::span<uint8_t>>* spans) {
+    while (size > 0u) {
+        const Page* existing = FindPage(address);
+        if (!((existing != nullptr ? existing->permissions : kDefaultPermissions) & kPermWrite)) {
+            return false;
+        }
+
+        Page& page = GetOrCreatePage(address);
+        page.dirty = true;
+
+        const uint32_t offset = address & kPageMask;
+        const uint32_t chunk = std::min(size, kPageSize - offset);
+        spans->emplace_back(page.data.data() + offset, chunk);
+        if (page.code.any()) {
+            code_writes_.push_back({address, chunk});
+        }
+
+        address += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+void PagedMemory::LoadBytes(uint32_t address, std::span<const uint8_t> data) {
+    while (!data.empty()) {
+        Page& page = GetOrCreatePage(address);
+        const uint32_t offset = address & kPageMask;
+        const size_t chunk = std::min<size_t>(data.size(), kPageSize - offset);
+
+        std::memcpy(page.data.data() + offset, data.data(), chunk);
+        page.dirty = true;
+
+        data = data.subspan(chunk);
+        address += static_cast<uint32_t>(chunk);
+    }
+}
+
+// Pages are private copies anyway, so the file is simply read in.
+void PagedMemory::MapFile(uint32_t address, int fd, size_t file_offset, size_t size) {
+    for (size_t done = 0; done < size; done += kPageSize) {
+        Page& page = GetOrCreatePage(address + static_cast<uint32_t>(done));
+        const ssize_t got = pread(fd, page.data.data(), kPageSize,
+                                  static_cast<off_t>(file_offset + done));
+        if (got != static_cast<ssize_t>(kPageSize)) {
+            throw std::runtime_error("Segment read failed");
+        }
+        page.dirty = true;
+    }
+}
+
+void PagedMemory::Protect(uint32_t address, size_t size, uint8_t permissions) {
+    const uint64_t end = static_cast<uint64_t>(address) + size;
+    for (uint64_t page_address = address & ~kPageMask; page_address < end; page_address += kPageSize) {
+        const auto page_address32 = static_cast<uint32_t>(page_address);
+        // Untouched pages already have the default permissions.
+        if (permissions == kDefaultPermissions && FindPage(page_address32) == nullptr) {
+            continue;
+        }
+        GetOrCreatePage(page_address32).permissions = permissions;
+    }
+    FlushTlb();
+}
+
+void PagedMemory::Discard(uint32_t address, size_t size) {
+    const uint64_t end = static_cast<uint64_t>(address) + size;
+    for (uint64_t page_address = address & ~kPageMask; page_address < end; page_address += kPageSize) {
+        auto& table = directory_[page_address >> (kPageBits + kLevelBits)];
+        if (!table) {
+            continue;
+        }
+        auto& page = (*table)[(page_address >> kPageBits) & (kLevelSize - 1u)];
+        if (!page) {
+            continue;
+        }
+        if (page->code.any()) {
+            code_writes_.push_back({static_cast<uint32_t>(page_address), kPageSize});
+        }
+        page.reset();
+        --page_count_;
+    }
+    FlushTlb();
+}
+
+void PagedMemory::MarkCode(uint32_t begin, uint32_t end) {
+    if (end <= begin) {
+        return;
+    }
+    for (uint32_t granule = begin >> kCodeGranuleBits; granule <= (end - 1u) >> kCodeGranuleBits; ++granule) {
+        const uint32_t address = granule << kCodeGranuleBits;
+        GetOrCreatePage(address).code.set((address & kPageMask) >> kCodeGranuleBits);
+        write_tlb_[TlbIndex(address)] = TlbEntry{};
+    }
+}
+
+std::vector<MemoryRegion> PagedMemory::Regions() const {
+    std::vector<MemoryRegion> regions;
+    for (uint32_t i = 0; i < kLevelSize; ++i) {
+        if (!directory_[i]) {
+            continue;
+        }
+        for (uint32_t j = 0; j < kLevelSize; ++j) {
+            const Page* page = (*directory_[i])[j].get();
+            if (page != nullptr) {
+                const uint32_t page_address = ((i << kLevelBits) | j) << kPageBits;
+                regions.push_back({page_address, kPageSize, page->permissions, page->data.data()});
+            }
+        }
+    }
+    return regions;
+}
+
+void PagedMemory::ClearDirty() noexcept {
+    for (auto& table : directory_) {
+        if (!table) {
+            continue;
+        }
+        for (auto& page : *table) {
+            if (page) {
+                page->dirty = false;
+            }
+        }
+    }
+    // Write hits skip the dirty bit, so they must miss again.
+    write_tlb_.fill(TlbEntry{});
+}
@@ -1,12 +1,36 @@
 #include "rvi_read_binary.hpp"
 
 #include "rvi_parse_elf.hpp"
+#include <algorithm>
 #include <exception>
 #include <cstring>
+#include <fcntl.h>
+#include <map>
 #include <stdexcept>
+#include <unistd.h>
+
+#include "loguru.hpp"
 
 using namespace rvi;
 
+namespace {
+
+uint8_t SegmentPermissions(Elf32_Word flags) {
+    uint8_t permissions = 0u;
+    if (flags & PF_R) {
+        permissions |= kPermRead;
+    }
+    if (flags & PF_W) {
+        permissions |= kPermWrite;
+    }
+    if (flags & PF_X) {
+        permissions |= kPermExec;
+    }
+    return permissions;
+}
+
+} // namespace
+
 ReadBinary::ReadBinary(std::string_view path)
     : path_(path),
       mmap_(path) {
@@ -23,7 +47,34 @@ ReadBinary::SectionInfo ReadBinary::GetTextSectionView() const {
     return {mmap_.GetView().subspan(text_offset, text_size), start_offset};
 }
 
-void ReadBinary::LoadIntoMemory(InterpreterMemoryModel* memory, uint32_t* entry_point) const {
+// Full pages are mapped copy-on-write from the file. The partial pages at
+// either end are copied instead: mapping them would expose neighbouring file
+// bytes, and they may share a guest page with another segment.
+void ReadBinary::LoadSegment(InterpreterMemoryModel* memory, int fd, uint32_t vaddr,
+                             std::size_t file_off, std::size_t file_sz) const {
+    auto data = mmap_.GetView().subspan(file_off, file_sz);
+
+    const std::size_t page = InterpreterMemoryModel::PageSize();
+    const uint64_t start = vaddr;
+    const uint64_t end   = start + file_sz;
+    const uint64_t map_start = (start + page - 1u) & ~static_cast<uint64_t>(page - 1u);
+    const uint64_t map_end   = end & ~static_cast<uint64_t>(page - 1u);
+
+    if (file_off % page != vaddr % page || map_start >= map_end) {
+        memory->LoadBytes(vaddr, data);
+        return;
+    }
+
+    const std::size_t head = static_cast<std::size_t>(map_start - start);
+    const std::size_t body = static_cast<std::size_t>(map_end - map_start);
+
+    memory->LoadBytes(vaddr, data.first(head));
+    memory->MapFile(static_cast<uint32_t>(map_start), fd, file_off + head, body);
+    DLOG_F(INFO, "Mapped segment pages [%lx, %lx) from file", map_start, map_end);
+    memory->LoadBytes(static_cast<uint32_t>(map_end), data.subspan(head + body));
+}
+
+void ReadBinary::LoadIntoMemory(InterpreterMemoryModel* memory, ImageInfo* image) const {
     auto view = mmap_.GetView();
     if (view.size() < sizeof(Elf32_Ehdr)) {
         throw std::runtime_error("ELF header is truncated");
@@ -54,28 +105,70 @@ void ReadBinary::LoadIntoMemory(InterpreterMemoryModel* memory, uint32_t* entry_
     );
     const auto* phdrs = reinterpret_cast<const Elf32_Phdr*>(phdr_span.data());
 
+    // Whole pages of segments are mapped from the file, see LoadSegment.
+    int fd = open(path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Open failed");
+    }
+
+    std::map<uint32_t, uint8_t> page_permissions;
+    uint64_t end = 0u;
+    uint32_t phdr = 0u;
+
     for (uint16_t i = 0; i < eh->e_phnum; ++i) {
         const Elf32_Phdr& ph = phdrs[i];
+        if (ph.p_type == PT_PHDR) {
+            phdr = ph.p_vaddr;
+        }
         if (ph.p_type != PT_LOAD || ph.p_memsz == 0) {
             continue;
         }
 
+        // Without PT_PHDR, the headers are found in the segment loading them.
+        if (phdr == 0u && eh->e_phoff >= ph.p_offset &&
+            eh->e_phoff + phdr_span.size() <= static_cast<uint64_t>(ph.p_offset) + ph.p_filesz) {
+            phdr = ph.p_vaddr + (eh->e_phoff - ph.p_offset);
+        }
+
         const std::size_t file_off = static_cast<std::size_t>(ph.p_offset);
         const std::size_t file_sz  = static_cast<std::size_t>(ph.p_filesz);
 
         if (file_off + file_sz > view.size()) {
+            close(fd);
             throw std::runtime_error("Segment exceeds file size");
         }
         const uint64_t mem_end = static_cast<uint64_t>(ph.p_vaddr) + ph.p_memsz;
         if (mem_end > memory->Size()) {
+            close(fd);
             throw std::runtime_error("Segment does not fit into memory");
         }
+        end = std::max(end, mem_end);
+
+        try {
+            LoadSegment(memory, fd, static_cast<uint32_t>(ph.p_vaddr), file_off, file_sz);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        // Remaining p_memsz - p_filesz stays zeroed: it lies in fresh anonymous memory.
 
-        memory->LoadBytes(static_cast<uint32_t>(ph.p_vaddr), view.subspan(file_off, file_sz));
-        // Remaining p_memsz - p_filesz stays zeroed in the pre-cleared memory buffer.
+        // A page shared by two segments gets the permissions of both.
+        const uint8_t permissions = SegmentPermissions(ph.p_flags);
+        const uint64_t page = InterpreterMemoryModel::PageSize();
+        for (uint64_t addr = ph.p_vaddr & ~(page - 1u); addr < mem_end; addr += page) {
+            page_permissions[static_cast<uint32_t>(addr)] |= permissions;
+        }
     }
 
-    if (entry_point) {
-        *entry_point = eh->e_entry;
+    close(fd);
+
+    for (const auto& [addr, permissions] : page_permissions) {
+        memory->Protect(addr, InterpreterMemoryModel::PageSize(), permissions);
     }
+
+    image->entry_point = eh->e_entry;
+    image->end   = static_cast<uint32_t>(end);
+    image->phdr  = phdr;
+    image->phent = eh->e_phentsize;
+    image->phnum = eh->e_phnum;
 }
@@ -0,0 +1,388 @@
+#include "rvi_session.hpp"
+
+#include "rvi_checkpoint.hpp"
+#include "rvi_initial_stack.hpp"
+#include "rvi_instruction_list.hpp"
+#include "rvi_instruction_registry.hpp"
+#include "rvi_read_binary.hpp"
+#include "rvi_syscalls.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+// Instructions a hart runs between checks whether the guest ended.
+constexpr int64_t kHartSlice = 1 << 16;
+
+// Registers and pc of its own on the memory of process.
+template <class Memory>
+std::unique_ptr<InterpreterState> NewHartState(Memory* memory, HartGroup* group) {
+    if constexpr (Memory::kIsFlat) {
+        return std::unique_ptr<InterpreterState>(
+            new InterpreterState{.memory = Memory(memory, &group->code_writes), .harts = group});
+    } else {
+        // Session rejects several harts on paged memory.
+        return nullptr;
+    }
+}
+
+} // namespace
+
+Session::Session() : Session(Options{}) {
+}
+
+Session::Session(Options options)
+    : options_(std::move(options)),
+      state_(new InterpreterState{}) {
+    if (options_.harts == 0u || options_.harts > kMaxHarts) {
+        throw std::runtime_error("A session runs 1 to " + std::to_string(kMaxHarts) + " harts");
+    }
+    if (options_.harts > 1u && !InterpreterMemoryModel::kIsFlat) {
+        throw std::runtime_error("Several harts need flat guest memory");
+    }
+    if (options_.harts > 1u && options_.engine == Engine::Jit) {
+        throw std::runtime_error("The jit engine runs a single hart");
+    }
+
+    if (options_.safe) {
+        state_->memory.EnableGuards();
+    }
+    if (options_.huge_pages && !state_->memory.EnableHugePages()) {
+        LOG_F(WARNING, "Huge pages are not available, using normal pages");
+    }
+
+    state_->io.SetOutputBuffer(options_.output_buffer);
+    if (options_.io_uring && !state_->io.EnableIoUring()) {
+        LOG_F(WARNING, "io_uring is not available, using synchronous I/O");
+    }
+    if (options_.fs) {
+        state_->vfs.Mount(options_.fs);
+    }
+    if (!options_.directory.empty()) {
+        state_->io.SetDirectory(options_.directory);
+    }
+
+    if (options_.engine == Engine::Threaded) {
+        threaded_engine_ = std::make_unique<ThreadedEngine>(&block_cache_);
+    } else if (options_.engine == Engine::Jit) {
+        jit_engine_ = std::make_unique<JitEngine>(&block_cache_);
+    }
+}
+
+void Session::Load(const std::string& path, std::span<const std::string> args) {
+    if (loaded_) {
+        throw std::runtime_error("A session runs a single program");
+    }
+
+    InterpreterState& state = *state_;
+    ImageInfo image{};
+    ReadBinary(path).LoadIntoMemory(&state.memory, &image);
+
+    state.pc = image.entry_point;
+    constexpr uint32_t kStackPadding = 0x10000u;
+    const uint32_t stack_top = static_cast<uint32_t>(state.memory.Size() - kStackPadding) & ~0xFu;
+
+    // With guards, overflowing the stack faults.
+    constexpr uint32_t kStackSize = 8u << 20;
+    const uint32_t stack_limit = stack_top - kStackSize;
+    state.memory.Protect(stack_limit, static_cast<uint32_t>(state.memory.Size() - stack_limit),
+                         kPermRead | kPermWrite);
+
+    std::vector<std::string> argv{path};
+    argv.insert(argv.end(), args.begin(), args.end());
+    const uint32_t sp = BuildInitialStack(&state.memory, stack_top, image, argv, options_.env);
+    state.regs.Set(2u, sp); // x2 = sp
+
+    // Other harts get stacks of the same size further down. Gaps below the
+    // stacks keep overflows faulting.
+    constexpr uint32_t kStackGap = 1u << 20;
+    std::vector<uint32_t> hart_stacks;
+    uint32_t lowest_stack = stack_limit;
+    for (uint32_t hart = 1u; hart < options_.harts; ++hart) {
+        const uint32_t top = lowest_stack - kStackGap;
+        lowest_stack = top - kStackSize;
+        state.memory.Protect(lowest_stack, kStackSize, kPermRead | kPermWrite);
+        hart_stacks.push_back(top);
+    }
+
+    // The heap lies between the image and the stacks.
+    const auto page_mask = static_cast<uint32_t>(InterpreterMemoryModel::PageSize() - 1u);
+    const uint32_t heap_start = (image.end + page_mask) & ~page_mask;
+    state.heap = {heap_start, heap_start, lowest_stack - kStackGap, lowest_stack - kStackGap};
+
+    if (options_.harts > 1u) {
+        AddHarts(hart_stacks);
+    }
+    loaded_ = true;
+}
+
+void Session::AddHarts(std::span<const uint32_t> stacks) {
+    hart_group_.process = state_.get();
+    for (uint32_t id = 0u; id <= stacks.size(); ++id) {
+        auto hart = std::make_unique<Hart>();
+        hart->state = NewHartState(&state_->memory, &hart_group_);
+        if (options_.engine == Engine::Threaded) {
+            hart->threaded_engine = std::make_unique<ThreadedEngine>(&hart->block_cache);
+        }
+
+        // Hart 0 takes its registers from state_ when it runs.
+        if (id > 0u) {
+            hart->state->pc = state_->pc;
+            hart->state->regs.Set(2u, stacks[id - 1u]); // x2 = sp
+            hart->state->regs.Set(10u, id);             // x10 = a0
+        }
+        harts_.push_back(std::move(hart));
+    }
+    hart_group_.main = harts_[0]->state.get();
+}
+
+void Session::Restore(const std::string& path) {
+    if (loaded_) {
+        throw std::runtime_error("A session runs a single program");
+    }
+    if (options_.harts > 1u) {
+        throw std::runtime_error("A checkpoint holds a single hart");
+    }
+    RestoreCheckpoint(path, state_.get());
+    loaded_ = true;
+}
+
+void Session::Save(const std::string& path) {
+    if (!loaded_) {
+        throw std::runtime_error("No program is loaded");
+    }
+    if (!harts_.empty()) {
+        throw std::runtime_error("A checkpoint holds a single hart");
+    }
+    // Output of the saved run belongs to it, not to the restored one.
+    state_->io.Flush();
+    SaveCheckpoint(*state_, path);
+}
+
+void Session::RunBlocks(InterpreterState* state, BlockCache* block_cache, int64_t* budget) {
+    // Only block terminators can stop execution, so the status is checked per block.
+    const BasicBlock* block = &block_cache->GetBlock(state->memory, state->pc);
+    while (true) {
+        ExecuteOps(state, block->ops.data(), block->ops.size());
+        *budget -= (block->end_pc - block->start_pc) / 4u;
+        if (state->status != ExecutionStatus::Success || *budget <= 0) {
+            break;
+        }
+        if (state->memory.HasCodeWrites()) [[unlikely]] {
+            // block itself may be dropped, so it is not asked for links.
+            block_cache->InvalidateWrittenCode(&state->memory);
+            block = &block_cache->GetBlock(state->memory, state->pc);
+            continue;
+        }
+        block = &block_cache->GetNextBlock(state->memory, *block, state->pc);
+    }
+}
+
+void Session::RunBlocksTo(const Marker& marker) {
+    InterpreterState* state = state_.get();
+
+    while (state->status == ExecutionStatus::Success && !(marker.at_pc && state->pc == marker.pc)) {
+        if (state->memory.HasCodeWrites()) [[unlikely]] {
+            block_cache_.InvalidateWrittenCode(&state->memory);
+        }
+        const BasicBlock& block = block_cache_.GetBlock(state->memory, state->pc);
+        const size_t count = block.ops.size();
+
+        // An ecall ends its block, so the syscall number is known once the
+        // rest of the block has run.
+        if (marker.at_read && static_cast<OpId>(block.ops[count - 1u].handler) == OpId::Ecall) {
+            ExecuteOps(state, block.ops.data(), count - 1u);
+            const auto number = static_cast<Syscall>(state->regs.Get(17u)); // a7
+            if (number == Syscall::Read || number == Syscall::Readv) {
+                instructions_ += (block.end_pc - block.start_pc) / 4u - 1u;
+                return;
+            }
+            ExecuteOps(state, &block.ops[count - 1u], 1u);
+        } else {
+            ExecuteOps(state, block.ops.data(), count);
+        }
+        instructions_ += (block.end_pc - block.start_pc) / 4u;
+    }
+}
+
+Session::Status Session::Run(uint64_t max_instructions) {
+    if (!loaded_) {
+        throw std::runtime_error("No program is loaded");
+    }
+    if (options_.engine == Engine::Jit && max_instructions < kNoLimit) {
+        throw std::runtime_error("The jit engine cannot stop after a number of instructions");
+    }
+    ran_ = true;
+    if (!harts_.empty()) {
+        return RunHarts(max_instructions);
+    }
+
+    InterpreterState* state = state_.get();
+    if (state->status == ExecutionStatus::Success && max_instructions > 0u) {
+        const auto limit = static_cast<int64_t>(std::min<uint64_t>(max_instructions, kNoLimit));
+        int64_t budget = limit;
+
+        MemoryGuard guard(state);
+        bool completed = true;
+        switch (options_.engine) {
+            case Engine::Threaded:
+                completed = guard.Run([&] { threaded_engine_->Run(state, &budget); });
+                break;
+
+            case Engine::Jit:
+                guard.SetGuestPcLookup(jit_engine_.get(), &JitEngine::LookupGuestPc);
+                completed = guard.Run([&] { jit_engine_->Run(state); });
+                budget = limit;
+                break;
+
+            case Engine::Block:
+            default:
+                completed = guard.Run([&] { RunBlocks(state, &block_cache_, &budget); });
+                break;
+        }
+        instructions_ += static_cast<uint64_t>(limit - budget);
+
+        if (!completed) {
+            RecordFault(guard);
+        }
+    }
+    return CurrentStatus();
+}
+
+Session::Status Session::RunHarts(uint64_t max_instructions) {
+    InterpreterState* process = state_.get();
+    if (process->status != ExecutionStatus::Success || max_instructions == 0u) {
+        return CurrentStatus();
+    }
+
+    InterpreterState* main = harts_[0]->state.get();
+    main->regs = process->regs;
+    main->f_regs = process->f_regs;
+    main->pc = process->pc;
+
+    const auto limit = static_cast<int64_t>(std::min<uint64_t>(max_instructions, kNoLimit));
+    std::vector<uint64_t> instructions(harts_.size());
+    std::vector<std::exception_ptr> errors(harts_.size());
+    {
+        // Hart 0 runs on the calling thread.
+        std::vector<std::jthread> threads;
+        threads.reserve(harts_.size() - 1u);
+        try {
+            for (size_t i = 1u; i < harts_.size(); ++i) {
+                threads.emplace_back([&, i] { instructions[i] = RunHart(harts_[i].get(), limit, &errors[i]); });
+            }
+        } catch (...) {
+            hart_group_.stopped.store(true, std::memory_order_relaxed);
+            throw;
+        }
+        instructions[0] = RunHart(harts_[0].get(), limit, &errors[0]);
+    }
+
+    process->regs = main->regs;
+    process->f_regs = main->f_regs;
+    process->pc = main->pc;
+    for (const uint64_t count : instructions) {
+        instructions_ += count;
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return CurrentStatus();
+}
+
+// Runs in slices, between which the hart checks whether the guest ended.
+// Returns the instructions run.
+uint64_t Session::RunHart(Hart* hart, int64_t limit, std::exception_ptr* error) {
+    InterpreterState* state = hart->state.get();
+    int64_t budget = limit;
+    try {
+        MemoryGuard guard(state);
+        const bool completed = guard.Run([&] {
+            while (state->status == ExecutionStatus::Success && budget > 0 &&
+                   !hart_group_.stopped.load(std::memory_order_relaxed)) {
+                int64_t slice = std::min(budget, kHartSlice);
+                budget -= slice;
+                if (hart->threaded_engine) {
+                    hart->threaded_engine->Run(state, &slice);
+                } else {
+                    RunBlocks(state, &hart->block_cache, &slice);
+                }
+                budget += slice;
+            }
+        });
+
+        // A fault ends the guest unless it already ended.
+        if (!completed) {
+            const std::lock_guard lock(hart_group_.mutex);
+            if (!hart_group_.stopped.exchange(true, std::memory_order_relaxed)) {
+                RecordFault(guard);
+            }
+        }
+    } catch (...) {
+        *error = std::current_exception();
+        hart_group_.stopped.store(true, std::memory_order_relaxed);
+    }
+    return static_cast<uint64_t>(limit - budget);
+}
+
+Session::Status Session::RunToRead() {
+    return RunToMarker({.at_read = true});
+}
+
+Session::Status Session::RunToPc(uint32_t pc) {
+    return RunToMarker({.at_pc = true, .pc = pc});
+}
+
+Session::Status Session::RunToMarker(const Marker& marker) {
+    if (!loaded_) {
+        throw std::runtime_error("No program is loaded");
+    }
+    if (ran_) {
+        throw std::runtime_error("A session runs to a marker only before Run");
+    }
+    if (!harts_.empty()) {
+        throw std::runtime_error("A session with several harts cannot run to a marker");
+    }
+
+    // No engine has derived code from the blocks yet, so they can be
+    // decoded again, split at the marker.
+    if (marker.at_pc) {
+        block_cache_.AddBlockStart(marker.pc);
+        block_cache_.Clear();
+    }
+
+    InterpreterState* state = state_.get();
+    if (state->status == ExecutionStatus::Success) {
+        MemoryGuard guard(state);
+        if (!guard.Run([&] { RunBlocksTo(marker); })) {
+            RecordFault(guard);
+        }
+    }
+    return CurrentStatus();
+}
+
+void Session::RecordFault(const MemoryGuard& guard) {
+    fault_ = guard.GetFault();
+    state_->status = ExecutionStatus::Fault;
+    state_->return_code = kFaultExitCode;
+}
+
+Session::Status Session::CurrentStatus() const noexcept {
+    switch (state_->status) {
+        case ExecutionStatus::Exit:    return Status::Exited;
+        case ExecutionStatus::Fault:   return Status::Faulted;
+        case ExecutionStatus::Success:
+        default:                       return Status::Paused;
+    }
+}
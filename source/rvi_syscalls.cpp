@@ -0,0 +1,605 @@
+#include "rvi_syscalls.hpp"
+
+#include "rvi_memory_guard.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+using SyscallArgs = std::array<uint32_t, 6>;
+using SyscallHandler = uint32_t (*)(InterpreterState* state, const SyscallArgs& args);
+
+// Guest values of the Linux asm-generic ABI.
+constexpr int32_t  kGuestAtFdcwd      = -100;
+constexpr uint32_t kGuestProtRead     = 0x1u;
+constexpr uint32_t kGuestProtWrite    = 0x2u;
+constexpr uint32_t kGuestProtExec     = 0x4u;
+constexpr uint32_t kGuestMapShared    = 0x01u;
+constexpr uint32_t kGuestMapFixed     = 0x10u;
+constexpr uint32_t kGuestMapAnonymous = 0x20u;
+// mmap offsets are given in these units on 32-bit targets.
+constexpr uint64_t kGuestMmapUnit     = 4096u;
+constexpr uint32_t kGuestMaxIov       = 1024u;
+constexpr uint32_t kGuestMaxClock     = 11u; // CLOCK_TAI
+
+struct OpenFlag {
+    uint32_t guest;
+    int      host;
+};
+
+// The access mode in the low two bits is the same everywhere.
+constexpr OpenFlag kOpenFlags[] = {
+    {00000100u, O_CREAT},
+    {00000200u, O_EXCL},
+    {00000400u, O_NOCTTY},
+    {00001000u, O_TRUNC},
+    {00002000u, O_APPEND},
+    {00004000u, O_NONBLOCK},
+    {00010000u, O_DSYNC},
+    {00200000u, O_DIRECTORY},
+    {00400000u, O_NOFOLLOW},
+    {02000000u, O_CLOEXEC},
+    {04000000u, O_SYNC},
+};
+
+// timespec and timeval with 64-bit time_t: seconds, then nano- or
+// microseconds.
+struct GuestTime {
+    int64_t seconds  = 0;
+    int32_t fraction = 0;
+    int32_t padding  = 0;
+};
+static_assert(sizeof(GuestTime) == 16u);
+
+// struct kernel_stat of newlib's libgloss.
+struct GuestStat {
+    uint64_t  dev      = 0u;
+    uint64_t  ino      = 0u;
+    uint32_t  mode     = 0u;
+    uint32_t  nlink    = 0u;
+    uint32_t  uid      = 0u;
+    uint32_t  gid      = 0u;
+    uint64_t  rdev     = 0u;
+    uint64_t  padding1 = 0u;
+    int64_t   size     = 0;
+    int32_t   blksize  = 0;
+    int32_t   padding2 = 0;
+    int64_t   blocks   = 0;
+    GuestTime atime{};
+    GuestTime mtime{};
+    GuestTime ctime{};
+    int32_t   reserved[2]{};
+};
+static_assert(sizeof(GuestStat) == 128u);
+
+// Guest iovecs are read straight into ranges.
+static_assert(sizeof(GuestRange) == 8u);
+
+constexpr uint32_t Error(int error) {
+    return static_cast<uint32_t>(-error);
+}
+
+uint64_t PageAlign(uint64_t value) {
+    const uint64_t page = InterpreterMemoryModel::PageSize();
+    return (value + page - 1u) & ~(page - 1u);
+}
+
+bool CopyToGuest(InterpreterMemoryModel* memory, uint32_t address, const void* data, uint32_t size) {
+    std::vector<std::span<uint8_t>> spans;
+    if (!memory->WriteSpans(address, size, &spans)) {
+        return false;
+    }
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (const auto& span : spans) {
+        std::memcpy(span.data(), bytes, span.size());
+        bytes += span.size();
+    }
+    return true;
+}
+
+template <typename T>
+bool CopyToGuest(InterpreterMemoryModel* memory, uint32_t address, const T& value) {
+    return CopyToGuest(memory, address, &value, sizeof(T));
+}
+
+bool CopyFromGuest(const InterpreterMemoryModel& memory, uint32_t address, void* data, uint32_t size) {
+    std::vector<std::span<const uint8_t>> spans;
+    if (!memory.ReadSpans(address, size, &spans)) {
+        return false;
+    }
+
+    auto* bytes = static_cast<uint8_t*>(data);
+    for (const auto& span : spans) {
+        std::memcpy(bytes, span.data(), span.size());
+        bytes += span.size();
+    }
+    return true;
+}
+
+// Reads a NUL-terminated path. Returns 0 or -errno.
+uint32_t ReadPath(const InterpreterMemoryModel& memory, uint32_t address, std::string* path) {
+    // Reads stop at page ends: with guards, the next page may be inaccessible.
+    constexpr uint32_t kChunk = 4096u;
+
+    std::vector<std::span<const uint8_t>> spans;
+    while (path->size() < PATH_MAX) {
+        const uint32_t chunk = kChunk - address % kChunk;
+        spans.clear();
+        if (!memory.ReadSpans(address, chunk, &spans)) {
+            return Error(EFAULT);
+        }
+        for (const auto& span : spans) {
+            const auto nul = std::find(span.begin(), span.end(), uint8_t{0});
+            path->append(reinterpret_cast<const char*>(span.data()), static_cast<size_t>(nul - span.begin()));
+            if (nul != span.end()) {
+                return path->size() < PATH_MAX ? 0u : Error(ENAMETOOLONG);
+            }
+        }
+        address += chunk;
+    }
+    return Error(ENAMETOOLONG);
+}
+
+// Reads an iovec array. Returns 0 or -errno.
+uint32_t ReadIov(const InterpreterMemoryModel& memory, uint32_t address, uint32_t count,
+                 std::vector<GuestRange>* ranges) {
+    if (count > kGuestMaxIov) {
+        return Error(EINVAL);
+    }
+    ranges->resize(count);
+    if (!CopyFromGuest(memory, address, ranges->data(), count * static_cast<uint32_t>(sizeof(GuestRange)))) {
+        return Error(EFAULT);
+    }
+    return 0u;
+}
+
+int HostOpenFlags(uint32_t flags) {
+    int host = static_cast<int>(flags & 3u);
+    for (const auto& flag : kOpenFlags) {
+        if (flags & flag.guest) {
+            host |= flag.host;
+        }
+    }
+    return host;
+}
+
+uint8_t Permissions(uint32_t prot) {
+    uint8_t permissions = 0u;
+    if (prot & kGuestProtRead) {
+        permissions |= kPermRead;
+    }
+    if (prot & kGuestProtWrite) {
+        permissions |= kPermWrite;
+    }
+    if (prot & kGuestProtExec) {
+        permissions |= kPermExec;
+    }
+    return permissions;
+}
+
+GuestTime ToGuestTime(const timespec& time) {
+    return {static_cast<int64_t>(time.tv_sec), static_cast<int32_t>(time.tv_nsec)};
+}
+
+// A host fd whose file position the guest may look at: buffered output must
+// be written first.
+int SyncedHostFd(InterpreterState* state, uint32_t fd) {
+    const int host_fd = state->io.HostFd(fd);
+    if (host_fd == STDOUT_FILENO) {
+        state->io.Flush();
+    }
+    return host_fd;
+}
+
+// Fills [address, address + size) from the file until its end. Returns 0 or
+// -errno.
+uint32_t ReadFile(InterpreterMemoryModel* memory, uint32_t address, uint32_t size, int host_fd, uint64_t offset) {
+    std::vector<std::span<uint8_t>> spans;
+    if (!memory->WriteSpans(address, size, &spans)) {
+        return Error(EFAULT);
+    }
+
+    for (auto span : spans) {
+        while (!span.empty()) {
+            const ssize_t got = pread(host_fd, span.data(), span.size(), static_cast<off_t>(offset));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got < 0) {
+                return Error(errno);
+            }
+            if (got == 0) {
+                return 0u;
+            }
+            span = span.subspan(static_cast<size_t>(got));
+            offset += static_cast<uint64_t>(got);
+        }
+    }
+    return 0u;
+}
+
+// The same for a VFS file.
+uint32_t ReadFile(InterpreterMemoryModel* memory, uint32_t address, uint32_t size, const VfsFile& file,
+                  uint64_t offset) {
+    std::vector<std::span<uint8_t>> spans;
+    if (!memory->WriteSpans(address, size, &spans)) {
+        return Error(EFAULT);
+    }
+
+    for (const auto& span : spans) {
+        const size_t got = file.ReadAt(offset, span);
+        if (got < span.size()) {
+            break;
+        }
+        offset += got;
+    }
+    return 0u;
+}
+
+// With a mounted VFS, paths resolve in it and the host is never asked.
+uint32_t OpenVfs(InterpreterState* state, uint32_t dirfd, const std::string& path, int flags, uint32_t mode) {
+    std::string base = "/";
+    if (static_cast<int32_t>(dirfd) != kGuestAtFdcwd) {
+        const VfsFile* dir = state->io.File(dirfd);
+        if (dir == nullptr) {
+            return Error(state->io.HostFd(dirfd) < 0 ? EBADF : ENOTDIR);
+        }
+        if (!dir->IsDirectory()) {
+            return Error(ENOTDIR);
+        }
+        base = dir->Path();
+    }
+    if (path.empty()) {
+        return Error(ENOENT);
+    }
+
+    std::unique_ptr<VfsFile> file;
+    if (const int32_t error = state->vfs.Open(Vfs::Resolve(base, path), flags, mode, &file); error != 0) {
+        return static_cast<uint32_t>(error);
+    }
+    return state->io.Adopt(std::move(file));
+}
+
+uint32_t SysOpenat(InterpreterState* state, const SyscallArgs& args) {
+    std::string path;
+    if (const uint32_t error = ReadPath(state->memory, args[1], &path); error != 0u) {
+        return error;
+    }
+    if (state->vfs.IsMounted()) {
+        return OpenVfs(state, args[0], path, HostOpenFlags(args[2]), args[3]);
+    }
+
+    int dirfd = state->io.Directory();
+    if (static_cast<int32_t>(args[0]) != kGuestAtFdcwd) {
+        dirfd = state->io.HostFd(args[0]);
+        if (dirfd < 0) {
+            return Error(EBADF);
+        }
+    }
+
+    const int host_fd = openat(dirfd, path.c_str(), HostOpenFlags(args[2]), static_cast<mode_t>(args[3] & 07777u));
+    if (host_fd < 0) {
+        return Error(errno);
+    }
+    return state->io.Adopt(host_fd);
+}
+
+uint32_t SysClose(InterpreterState* state, const SyscallArgs& args) {
+    return static_cast<uint32_t>(state->io.Close(args[0]));
+}
+
+uint32_t SysLseek(InterpreterState* state, const SyscallArgs& args) {
+    int64_t offset = 0;
+    if (VfsFile* file = state->io.File(args[0]); file != nullptr) {
+        offset = file->Seek(static_cast<int32_t>(args[1]), static_cast<int>(args[2]));
+    } else {
+        const int host_fd = SyncedHostFd(state, args[0]);
+        if (host_fd < 0) {
+            return Error(state->io.IsOpen(args[0]) ? ESPIPE : EBADF);
+        }
+        offset = lseek(host_fd, static_cast<int32_t>(args[1]), static_cast<int>(args[2]));
+        if (offset < 0) {
+            offset = -errno;
+        }
+    }
+
+    if (offset < 0) {
+        return static_cast<uint32_t>(offset);
+    }
+    if (offset > INT32_MAX) {
+        return Error(EOVERFLOW);
+    }
+    return static_cast<uint32_t>(offset);
+}
+
+uint32_t SysRead(InterpreterState* state, const SyscallArgs& args) {
+    return static_cast<uint32_t>(state->io.Read(args[0], &state->memory, args[1], args[2]));
+}
+
+uint32_t SysWrite(InterpreterState* state, const SyscallArgs& args) {
+    return static_cast<uint32_t>(state->io.Write(args[0], state->memory, args[1], args[2]));
+}
+
+uint32_t SysReadv(InterpreterState* state, const SyscallArgs& args) {
+    std::vector<GuestRange> ranges;
+    if (const uint32_t error = ReadIov(state->memory, args[1], args[2], &ranges); error != 0u) {
+        return error;
+    }
+    return static_cast<uint32_t>(state->io.Read(args[0], &state->memory, ranges));
+}
+
+uint32_t SysWritev(InterpreterState* state, const SyscallArgs& args) {
+    std::vector<GuestRange> ranges;
+    if (const uint32_t error = ReadIov(state->memory, args[1], args[2], &ranges); error != 0u) {
+        return error;
+    }
+    return static_cast<uint32_t>(state->io.Write(args[0], state->memory, ranges));
+}
+
+uint32_t SysFstat(InterpreterState* state, const SyscallArgs& args) {
+    struct stat host{};
+    if (const VfsFile* file = state->io.File(args[0]); file != nullptr) {
+        file->Stat(&host);
+    } else if (const int host_fd = SyncedHostFd(state, args[0]); host_fd >= 0) {
+        if (fstat(host_fd, &host) != 0) {
+            return Error(errno);
+        }
+    } else if (state->io.IsOpen(args[0])) {
+        host.st_mode = S_IFIFO | 0200u; // an output sink
+    } else {
+        return Error(EBADF);
+    }
+
+    GuestStat guest{};
+    guest.dev     = static_cast<uint64_t>(host.st_dev);
+    guest.ino     = static_cast<uint64_t>(host.st_ino);
+    guest.mode    = static_cast<uint32_t>(host.st_mode);
+    guest.nlink   = static_cast<uint32_t>(host.st_nlink);
+    guest.uid     = static_cast<uint32_t>(host.st_uid);
+    guest.gid     = static_cast<uint32_t>(host.st_gid);
+    guest.rdev    = static_cast<uint64_t>(host.st_rdev);
+    guest.size    = static_cast<int64_t>(host.st_size);
+    guest.blksize = static_cast<int32_t>(host.st_blksize);
+    guest.blocks  = static_cast<int64_t>(host.st_blocks);
+    guest.atime   = ToGuestTime(host.st_atim);
+    guest.mtime   = ToGuestTime(host.st_mtim);
+    guest.ctime   = ToGuestTime(host.st_ctim);
+
+    return CopyToGuest(&state->memory, args[1], guest) ? 0u : Error(EFAULT);
+}
+
+uint32_t SysExit(InterpreterState* state, const SyscallArgs& args) {
+    state->io.Flush();
+    state->return_code = static_cast<int32_t>(args[0]);
+    state->status = ExecutionStatus::Exit;
+    return args[0];
+}
+
+// Clock ids are the same on every Linux architecture.
+uint32_t SysClockGettime(InterpreterState* state, const SyscallArgs& args) {
+    if (args[0] > kGuestMaxClock) {
+        return Error(EINVAL);
+    }
+
+    timespec now{};
+    if (clock_gettime(static_cast<clockid_t>(args[0]), &now) != 0) {
+        return Error(errno);
+    }
+    return CopyToGuest(&state->memory, args[1], ToGuestTime(now)) ? 0u : Error(EFAULT);
+}
+
+uint32_t SysGettimeofday(InterpreterState* state, const SyscallArgs& args) {
+    timeval now{};
+    gettimeofday(&now, nullptr);
+
+    const GuestTime time{static_cast<int64_t>(now.tv_sec), static_cast<int32_t>(now.tv_usec)};
+    if (args[0] != 0u && !CopyToGuest(&state->memory, args[0], time)) {
+        return Error(EFAULT);
+    }
+    // The obsolete timezone is always UTC.
+    const std::array<int32_t, 2> timezone{};
+    if (args[1] != 0u && !CopyToGuest(&state->memory, args[1], timezone)) {
+        return Error(EFAULT);
+    }
+    return 0u;
+}
+
+// Like the kernel, returns the new break, or the old one if it cannot move.
+uint32_t SysBrk(InterpreterState* state, const SyscallArgs& args) {
+    auto& heap = state->heap;
+    const uint32_t brk = args[0];
+    if (brk < heap.brk_start || brk > heap.mmap_start) {
+        return heap.brk;
+    }
+
+    const auto old_end = static_cast<uint32_t>(PageAlign(heap.brk));
+    const auto new_end = static_cast<uint32_t>(PageAlign(brk));
+    if (new_end > old_end) {
+        state->memory.Protect(old_end, new_end - old_end, kPermRead | kPermWrite);
+    } else if (new_end < old_end) {
+        state->memory.Discard(new_end, old_end - new_end);
+    }
+
+    heap.brk = brk;
+    return brk;
+}
+
+// Mappings are private copies of fresh or file memory. Without MAP_FIXED
+// they are placed below the previous ones.
+uint32_t SysMmap(InterpreterState* state, const SyscallArgs& args) {
+    const uint32_t address = args[0];
+    const uint64_t size    = PageAlign(args[1]);
+    const uint32_t prot    = args[2];
+    const uint32_t flags   = args[3];
+    auto& memory = state->memory;
+    auto& heap   = state->heap;
+
+    if (size == 0u || ((flags & kGuestMapFixed) && address != PageAlign(address))) {
+        return Error(EINVAL);
+    }
+
+    int host_fd = -1;
+    const VfsFile* file = nullptr;
+    if (!(flags & kGuestMapAnonymous)) {
+        host_fd = state->io.HostFd(args[4]);
+        file = state->io.File(args[4]);
+        if (host_fd < 0 && file == nullptr) {
+            return Error(state->io.IsOpen(args[4]) ? ENODEV : EBADF);
+        }
+        if (file != nullptr && file->IsDirectory()) {
+            return Error(ENODEV);
+        }
+        // Guest writes could not reach the file.
+        if ((flags & kGuestMapShared) && (prot & kGuestProtWrite)) {
+            return Error(ENODEV);
+        }
+    }
+
+    uint32_t start = address;
+    if (flags & kGuestMapFixed) {
+        if (address + size > memory.Size()) {
+            return Error(ENOMEM);
+        }
+    } else {
+        if (size > heap.mmap_start - PageAlign(heap.brk)) {
+            return Error(ENOMEM);
+        }
+        start = static_cast<uint32_t>(heap.mmap_start - size);
+        heap.mmap_start = start;
+    }
+
+    memory.Discard(start, size);
+    if (host_fd >= 0 || file != nullptr) {
+        memory.Protect(start, size, kPermRead | kPermWrite);
+        const uint64_t offset = args[5] * kGuestMmapUnit;
+        const uint32_t error = file != nullptr
+            ? ReadFile(&memory, start, static_cast<uint32_t>(size), *file, offset)
+            : ReadFile(&memory, start, static_cast<uint32_t>(size), host_fd, offset);
+        if (error != 0u) {
+            memory.Discard(start, size);
+            if (start == heap.mmap_start && !(flags & kGuestMapFixed)) {
+                heap.mmap_start = static_cast<uint32_t>(start + size);
+            }
+            return error;
+        }
+    }
+    memory.Protect(start, size, Permissions(prot));
+    return start;
+}
+
+uint32_t SysMunmap(InterpreterState* state, const SyscallArgs& args) {
+    const uint32_t address = args[0];
+    const uint64_t size    = PageAlign(args[1]);
+    auto& heap = state->heap;
+
+    if (size == 0u || address != PageAlign(address) || address + size > state->memory.Size()) {
+        return Error(EINVAL);
+    }
+
+    state->memory.Discard(address, size);
+    if (address == heap.mmap_start) {
+        heap.mmap_start = static_cast<uint32_t>(std::min<uint64_t>(address + size, heap.mmap_end));
+    }
+    return 0u;
+}
+
+constexpr std::pair<Syscall, SyscallHandler> kHandlers[] = {
+    {Syscall::Openat,         &SysOpenat},
+    {Syscall::Close,          &SysClose},
+    {Syscall::Lseek,          &SysLseek},
+    {Syscall::Read,           &SysRead},
+    {Syscall::Write,          &SysWrite},
+    {Syscall::Readv,          &SysReadv},
+    {Syscall::Writev,         &SysWritev},
+    {Syscall::Fstat,          &SysFstat},
+    {Syscall::Exit,           &SysExit},
+    {Syscall::ExitGroup,      &SysExit},
+    {Syscall::ClockGettime,   &SysClockGettime},
+    {Syscall::Gettimeofday,   &SysGettimeofday},
+    {Syscall::Brk,            &SysBrk},
+    {Syscall::Munmap,         &SysMunmap},
+    {Syscall::Mmap,           &SysMmap},
+    {Syscall::ClockGettime64, &SysClockGettime},
+};
+
+constexpr auto kSyscallTable = [] {
+    std::array<SyscallHandler, 512> table{};
+    for (const auto& [number, handler] : kHandlers) {
+        table[static_cast<size_t>(number)] = handler;
+    }
+    return table;
+}();
+
+// Harts take turns using the files and heap of their process; memory the
+// syscall writes counts as written by the calling hart.
+uint32_t ExecHartSyscall(InterpreterState* hart, Syscall number, SyscallHandler handler, const SyscallArgs& args) {
+    HartGroup* harts = hart->harts;
+    InterpreterState* process = harts->process;
+    const std::lock_guard lock(harts->mutex);
+
+    // The guest ended while the hart ran its slice.
+    if (harts->stopped.load(std::memory_order_relaxed)) {
+        hart->status = ExecutionStatus::Exit;
+        return Error(EINTR);
+    }
+
+    if (number == Syscall::Exit || number == Syscall::ExitGroup) {
+        hart->return_code = static_cast<int32_t>(args[0]);
+        hart->status = ExecutionStatus::Exit;
+        if (number == Syscall::Exit && hart != harts->main) {
+            return args[0];
+        }
+        harts->stopped.store(true, std::memory_order_relaxed);
+    }
+
+    const uint32_t result = handler(process, args);
+    if (process->memory.HasCodeWrites()) [[unlikely]] {
+        hart->memory.AddCodeWrites(process->memory.TakeCodeWrites());
+    }
+    return result;
+}
+
+} // namespace
+
+void rvi::ExecSyscall(InterpreterState* state) {
+    const uint32_t number = state->regs.Get(17u); // a7
+
+    SyscallArgs args{};
+    for (uint32_t i = 0; i < args.size(); ++i) {
+        args[i] = state->regs.Get(10u + i); // a0-a5
+    }
+
+    const SyscallHandler handler = number < kSyscallTable.size() ? kSyscallTable[number] : nullptr;
+    if (handler == nullptr) {
+        LOG_F(WARNING, "Syscall %u is not implemented", number);
+        state->regs.Set(10u, Error(ENOSYS));
+        return;
+    }
+
+    const HostCodeScope host_code;
+    const uint32_t result = state->harts == nullptr
+                                ? handler(state, args)
+                                : ExecHartSyscall(state, static_cast<Syscall>(number), handler, args);
+    DLOG_F(INFO, "Syscall %u(%x, %x, %x) = %x", number, args[0], args[1], args[2], result);
+    state->regs.Set(10u, result);
+}
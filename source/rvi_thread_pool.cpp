@@ -0,0 +1,96 @@
+#include "rvi_thread_pool.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace rvi;
+
+namespace {
+
+struct WorkQueue {
+    std::mutex mutex{};
+    std::deque<size_t> tasks{};
+
+    std::optional<size_t> PopBack() {
+        std::lock_guard lock(mutex);
+        if (tasks.empty()) {
+            return std::nullopt;
+        }
+        const size_t task = tasks.back();
+        tasks.pop_back();
+        return task;
+    }
+
+    std::optional<size_t> StealFront() {
+        std::lock_guard lock(mutex);
+        if (tasks.empty()) {
+            return std::nullopt;
+        }
+        const size_t task = tasks.front();
+        tasks.pop_front();
+        return task;
+    }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads)
+    : threads_(threads != 0u ? threads : std::max(std::thread::hardware_concurrency(), 1u)) {
+}
+
+void ThreadPool::Run(size_t count, const std::function<void(size_t)>& task) {
+    const size_t workers = std::min(threads_, count);
+    if (workers == 0u) {
+        return;
+    }
+
+    std::vector<WorkQueue> queues(workers);
+    for (size_t i = 0u; i < count; ++i) {
+        queues[i % workers].tasks.push_back(i);
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr error{};
+
+    // Tasks are only taken, never added, so a worker whose own queue and
+    // every other queue are empty is done.
+    auto work = [&](size_t self) {
+        while (true) {
+            std::optional<size_t> next = queues[self].PopBack();
+            for (size_t i = 1u; !next && i < workers; ++i) {
+                next = queues[(self + i) % workers].StealFront();
+            }
+            if (!next) {
+                return;
+            }
+
+            try {
+                task(*next);
+            } catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1u);
+    for (size_t i = 1u; i < workers; ++i) {
+        threads.emplace_back(work, i);
+    }
+    work(0u);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
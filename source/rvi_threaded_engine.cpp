@@ -0,0 +1,71 @@
+#include "rvi_threaded_engine.hpp"
+
+#include "rvi_instruction_list.hpp"
+
+using namespace rvi;
+
+// Handlers are dispatched with the labels-as-values extension.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+ThreadedEngine::ThreadedEngine(BlockCache* block_cache)
+    : block_cache_(block_cache),
+      blocks_() {
+}
+
+ExecutionStatus ThreadedEngine::Run(InterpreterState* state, int64_t* budget) {
+    static const void* const kHandlers[] = {
+#define RVI_HANDLER_ADDRESS(name, type) &&handler_##name,
+        RVI_INSTRUCTION_LIST(RVI_HANDLER_ADDRESS)
+#undef RVI_HANDLER_ADDRESS
+    };
+    const void* const block_exit = &&handler_block_exit;
+
+    auto get_block = [&](uint32_t pc) -> const Block* {
+        auto it = blocks_.find(pc);
+        if (it != blocks_.end()) {
+            return it->second.get();
+        }
+
+        const auto& basic_block = block_cache_->GetBlock(state->memory, pc);
+
+        auto block = std::make_unique<Block>();
+        block->ops.reserve(basic_block.ops.size() + 1u);
+        for (const auto& micro_op : basic_block.ops) {
+            block->ops.push_back({kHandlers[micro_op.handler], micro_op});
+        }
+        block->ops.push_back({block_exit, MicroOp{}});
+        block->instructions = (basic_block.end_pc - basic_block.start_pc) / 4u;
+
+        return blocks_.emplace(pc, std::move(block)).first->second.get();
+    };
+
+    const Block* block = get_block(state->pc);
+    const Op* op = block->ops.data();
+    goto *op->handler;
+
+#define RVI_THREADED_HANDLER(name, type)                                     \
+    handler_##name:                                                          \
+        type::Exec(state, op->info);                                         \
+        ++op;                                                                \
+        goto *op->handler;
+
+    RVI_INSTRUCTION_LIST(RVI_THREADED_HANDLER)
+#undef RVI_THREADED_HANDLER
+
+handler_block_exit:
+    *budget -= block->instructions;
+    if (state->status != ExecutionStatus::Success || *budget <= 0) {
+        return state->status;
+    }
+    if (state->memory.HasCodeWrites()) [[unlikely]] {
+        for (uint32_t pc : block_cache_->InvalidateWrittenCode(&state->memory)) {
+            blocks_.erase(pc);
+        }
+    }
+    block = get_block(state->pc);
+    op = block->ops.data();
+    goto *op->handler;
+}
+
+#pragma GCC diagnostic pop
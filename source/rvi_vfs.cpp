@@ -0,0 +1,416 @@
+#include "rvi_vfs.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "loguru.hpp"
+
+using namespace rvi;
+
+namespace {
+
+constexpr size_t kTarBlock = 512u;
+constexpr uint32_t kDirectoryMode = S_IFDIR | 0755u;
+// Guest offsets and sizes are 32-bit.
+constexpr uint64_t kMaxFileSize = 0xFFFFFFFFu;
+
+std::string_view Field(std::span<const uint8_t> header, size_t offset, size_t size) {
+    const auto* begin = reinterpret_cast<const char*>(header.data() + offset);
+    return {begin, static_cast<size_t>(std::find(begin, begin + size, '\0') - begin)};
+}
+
+// Numeric fields are octal, padded with spaces or NULs.
+uint64_t Octal(std::span<const uint8_t> header, size_t offset, size_t size) {
+    if (header[offset] & 0x80u) {
+        throw std::runtime_error("Tar entries over 8 GiB are not supported");
+    }
+
+    uint64_t value = 0u;
+    size_t i = 0;
+    while (i < size && header[offset + i] == ' ') {
+        ++i;
+    }
+    for (; i < size && header[offset + i] >= '0' && header[offset + i] <= '7'; ++i) {
+        value = value * 8u + (header[offset + i] - '0');
+    }
+    return value;
+}
+
+// The checksum is the byte sum of the header with its own field as spaces.
+bool ChecksumMatches(std::span<const uint8_t> header) {
+    constexpr size_t kChecksumOffset = 148u;
+    constexpr size_t kChecksumSize   = 8u;
+
+    uint64_t sum = 0u;
+    for (size_t i = 0; i < kTarBlock; ++i) {
+        const bool in_field = i >= kChecksumOffset && i < kChecksumOffset + kChecksumSize;
+        sum += in_field ? uint8_t{' '} : header[i];
+    }
+    return sum == Octal(header, kChecksumOffset, kChecksumSize);
+}
+
+std::string HeaderName(std::span<const uint8_t> header) {
+    std::string name(Field(header, 0u, 100u));
+    if (Field(header, 257u, 6u).starts_with("ustar")) {
+        const auto prefix = Field(header, 345u, 155u);
+        if (!prefix.empty()) {
+            name = std::string(prefix) + "/" + name;
+        }
+    }
+    return name;
+}
+
+// The path record of a pax extended header, "<length> path=<value>\n".
+std::string PaxPath(std::span<const uint8_t> data) {
+    std::string_view records(reinterpret_cast<const char*>(data.data()), data.size());
+    while (!records.empty()) {
+        const size_t space = records.find(' ');
+        if (space == std::string_view::npos) {
+            break;
+        }
+        size_t length = 0u;
+        for (char c : records.substr(0, space)) {
+            length = length * 10u + static_cast<size_t>(c - '0');
+        }
+        if (length <= space + 1u || length > records.size()) {
+            break;
+        }
+
+        const auto record = records.substr(space + 1u, length - space - 2u);
+        if (record.starts_with("path=")) {
+            return std::string(record.substr(5u));
+        }
+        records.remove_prefix(length);
+    }
+    return {};
+}
+
+int64_t Now() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+} // namespace
+
+std::shared_ptr<const FsImage> FsImage::Load(const std::string& path) {
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("Cannot read file system image " + path);
+    }
+
+    auto image = std::make_shared<FsImage>();
+    image->Add("/", {.mode = kDirectoryMode, .mtime = static_cast<int64_t>(st.st_mtime)});
+    if (S_ISDIR(st.st_mode)) {
+        image->LoadDirectory(path);
+    } else {
+        image->archive_.emplace(path);
+        image->LoadTar();
+    }
+
+    DLOG_F(INFO, "Loaded %zu files and directories from %s", image->nodes_.size(), path.c_str());
+    return image;
+}
+
+// Archives need not list parent directories. Later entries replace earlier
+// ones, as when extracting.
+void FsImage::Add(const std::string& path, Node node) {
+    for (size_t slash = path.find('/', 1u); slash != std::string::npos; slash = path.find('/', slash + 1u)) {
+        const uint64_t ino = nodes_.size() + 1u;
+        nodes_.try_emplace(path.substr(0, slash), Node{.mode = kDirectoryMode, .mtime = node.mtime, .ino = ino});
+    }
+    node.ino = nodes_.size() + 1u;
+    nodes_[path] = node;
+}
+
+void FsImage::LoadTar() {
+    const auto view = archive_->GetView();
+    if (view.size() % kTarBlock != 0u) {
+        throw std::runtime_error("Invalid tar archive");
+    }
+
+    // Set by GNU long name and pax headers for the entry that follows.
+    std::string next_name;
+    size_t offset = 0u;
+    while (offset + kTarBlock <= view.size()) {
+        const auto header = view.subspan(offset, kTarBlock);
+        if (std::all_of(header.begin(), header.end(), [](uint8_t b) { return b == 0u; })) {
+            break; // end of archive
+        }
+        if (!ChecksumMatches(header)) {
+            throw std::runtime_error("Invalid tar archive");
+        }
+
+        const uint64_t size = Octal(header, 124u, 12u);
+        const size_t data_offset = offset + kTarBlock;
+        if (size > view.size() - data_offset) {
+            throw std::runtime_error("Tar archive is truncated");
+        }
+        const auto data = view.subspan(data_offset, size);
+        offset = data_offset + (size + kTarBlock - 1u) / kTarBlock * kTarBlock;
+
+        const char type = static_cast<char>(header[156]);
+        if (type == 'L') {
+            next_name = std::string(Field(data, 0u, data.size()));
+            continue;
+        }
+        if (type == 'x') {
+            next_name = PaxPath(data);
+            continue;
+        }
+
+        const std::string path = Vfs::Resolve("/", next_name.empty() ? HeaderName(header) : next_name);
+        next_name.clear();
+
+        const auto mode = static_cast<uint32_t>(Octal(header, 100u, 8u) & 07777u);
+        const auto mtime = static_cast<int64_t>(Octal(header, 136u, 12u));
+        switch (type) {
+            case '\0':
+            case '0':
+            case '7':
+                Add(path, {.data = data, .mode = S_IFREG | mode, .mtime = mtime});
+                break;
+
+            case '5':
+                Add(path, {.mode = S_IFDIR | mode, .mtime = mtime});
+                break;
+
+            default:
+                DLOG_F(WARNING, "Skipping tar entry %s of type %c", path.c_str(), type);
+                break;
+        }
+    }
+}
+
+// Symbolic links are followed.
+void FsImage::LoadDirectory(const std::string& root) {
+    namespace fs = std::filesystem;
+
+    for (const auto& entry : fs::recursive_directory_iterator(root, fs::directory_options::follow_directory_symlink)) {
+        const std::string path = Vfs::Resolve("/", fs::relative(entry.path(), root).generic_string());
+
+        struct stat st{};
+        if (stat(entry.path().c_str(), &st) != 0) {
+            continue;
+        }
+        const auto mtime = static_cast<int64_t>(st.st_mtime);
+        const auto mode = static_cast<uint32_t>(st.st_mode);
+
+        if (S_ISDIR(st.st_mode)) {
+            Add(path, {.mode = mode, .mtime = mtime});
+        } else if (S_ISREG(st.st_mode)) {
+            auto& contents = contents_.emplace_back(static_cast<size_t>(st.st_size));
+            std::ifstream file(entry.path(), std::ios::binary);
+            if (!file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size()))) {
+                throw std::runtime_error("Cannot read " + entry.path().string());
+            }
+            Add(path, {.data = contents, .mode = mode, .mtime = mtime});
+        }
+    }
+}
+
+const FsImage::Node* FsImage::Find(const std::string& path) const {
+    const auto it = nodes_.find(path);
+    return it != nodes_.end() ? &it->second : nullptr;
+}
+
+VfsFile::VfsFile(std::string path, const FsImage::Node* node, std::shared_ptr<OverlayFile> overlay,
+                 bool readable, bool writable, bool append)
+    : path_(std::move(path)),
+      node_(node),
+      overlay_(std::move(overlay)),
+      readable_(readable),
+      writable_(writable),
+      append_(append) {
+}
+
+bool VfsFile::IsDirectory() const noexcept {
+    return node_ != nullptr && S_ISDIR(node_->mode);
+}
+
+std::span<const uint8_t> VfsFile::Data() const noexcept {
+    return overlay_ ? std::span<const uint8_t>(overlay_->data) : node_->data;
+}
+
+size_t VfsFile::ReadAt(uint64_t offset, std::span<uint8_t> data) const noexcept {
+    const auto contents = Data();
+    if (offset >= contents.size()) {
+        return 0u;
+    }
+    const size_t size = std::min<size_t>(data.size(), contents.size() - offset);
+    std::memcpy(data.data(), contents.data() + offset, size);
+    return size;
+}
+
+int64_t VfsFile::Read(std::span<const std::span<uint8_t>> spans) {
+    if (IsDirectory()) {
+        return -EISDIR;
+    }
+    if (!readable_) {
+        return -EBADF;
+    }
+
+    int64_t total = 0;
+    for (const auto& span : spans) {
+        const size_t size = ReadAt(position_, span);
+        position_ += size;
+        total += static_cast<int64_t>(size);
+        if (size < span.size()) {
+            break;
+        }
+    }
+    return total;
+}
+
+int64_t VfsFile::Write(std::span<const std::span<const uint8_t>> spans) {
+    if (!writable_) {
+        return -EBADF;
+    }
+
+    auto& contents = overlay_->data;
+    if (append_) {
+        position_ = contents.size();
+    }
+
+    int64_t total = 0;
+    for (const auto& span : spans) {
+        // Like on Linux, empty writes do not extend the file.
+        if (span.empty()) {
+            continue;
+        }
+        const uint64_t end = position_ + span.size();
+        if (end > kMaxFileSize) {
+            return total > 0 ? total : -EFBIG;
+        }
+        if (end > contents.size()) {
+            contents.resize(end);
+        }
+        std::memcpy(contents.data() + position_, span.data(), span.size());
+        position_ = end;
+        total += static_cast<int64_t>(span.size());
+    }
+    overlay_->mtime = Now();
+    return total;
+}
+
+int64_t VfsFile::Seek(int64_t offset, int whence) {
+    int64_t base = 0;
+    switch (whence) {
+        case SEEK_SET: base = 0; break;
+        case SEEK_CUR: base = static_cast<int64_t>(position_); break;
+        case SEEK_END: base = static_cast<int64_t>(Data().size()); break;
+        default: return -EINVAL;
+    }
+
+    const int64_t position = base + offset;
+    if (position < 0) {
+        return -EINVAL;
+    }
+    position_ = static_cast<uint64_t>(position);
+    return position;
+}
+
+void VfsFile::Stat(struct stat* st) const noexcept {
+    *st = {};
+    const uint64_t size = Data().size();
+    st->st_mode    = overlay_ ? overlay_->mode : node_->mode;
+    st->st_ino     = overlay_ ? overlay_->ino : node_->ino;
+    st->st_nlink   = IsDirectory() ? 2u : 1u;
+    st->st_size    = static_cast<off_t>(size);
+    st->st_blksize = 4096;
+    st->st_blocks  = static_cast<blkcnt_t>((size + 511u) / 512u);
+    st->st_mtim.tv_sec = overlay_ ? overlay_->mtime : node_->mtime;
+    st->st_atim = st->st_ctim = st->st_mtim;
+}
+
+std::string Vfs::Resolve(std::string_view base, std::string_view path) {
+    std::vector<std::string_view> parts;
+    const auto split = [&parts](std::string_view names) {
+        while (!names.empty()) {
+            const size_t slash = names.find('/');
+            const auto name = names.substr(0, slash);
+            names = slash == std::string_view::npos ? std::string_view{} : names.substr(slash + 1u);
+
+            if (name == "..") {
+                if (!parts.empty()) {
+                    parts.pop_back();
+                }
+            } else if (!name.empty() && name != ".") {
+                parts.push_back(name);
+            }
+        }
+    };
+
+    if (!path.starts_with('/')) {
+        split(base);
+    }
+    split(path);
+
+    std::string resolved;
+    for (const auto& part : parts) {
+        resolved += '/';
+        resolved += part;
+    }
+    return resolved.empty() ? "/" : resolved;
+}
+
+bool Vfs::IsDirectory(const std::string& path) const {
+    const FsImage::Node* node = image_->Find(path);
+    return node != nullptr && S_ISDIR(node->mode);
+}
+
+int32_t Vfs::Open(const std::string& path, int flags, uint32_t mode, std::unique_ptr<VfsFile>* file) {
+    const int access = flags & O_ACCMODE;
+    const bool readable = access == O_RDONLY || access == O_RDWR;
+    const bool writable = access == O_WRONLY || access == O_RDWR;
+
+    std::shared_ptr<OverlayFile> overlay;
+    if (const auto it = overlay_.find(path); it != overlay_.end()) {
+        overlay = it->second;
+    }
+    const FsImage::Node* node = overlay ? nullptr : image_->Find(path);
+
+    if (overlay == nullptr && node == nullptr) {
+        if (!(flags & O_CREAT)) {
+            return -ENOENT;
+        }
+        const size_t slash = path.rfind('/');
+        if (!IsDirectory(slash == 0u ? "/" : path.substr(0, slash))) {
+            return -ENOENT;
+        }
+        overlay = std::make_shared<OverlayFile>(OverlayFile{{}, S_IFREG | (mode & 07777u), Now(), next_ino_++});
+        overlay_[path] = overlay;
+    } else if ((flags & O_CREAT) && (flags & O_EXCL)) {
+        return -EEXIST;
+    }
+
+    if (node != nullptr && S_ISDIR(node->mode)) {
+        if (writable) {
+            return -EISDIR;
+        }
+        *file = std::make_unique<VfsFile>(path, node, nullptr, readable, false, false);
+        return 0;
+    }
+    if (flags & O_DIRECTORY) {
+        return -ENOTDIR;
+    }
+
+    // The image is shared, so writes go to a private copy.
+    if (node != nullptr && (writable || (flags & O_TRUNC))) {
+        overlay = std::make_shared<OverlayFile>(
+            OverlayFile{{node->data.begin(), node->data.end()}, node->mode, node->mtime, node->ino});
+        overlay_[path] = overlay;
+        node = nullptr;
+    }
+    if (overlay != nullptr && (flags & O_TRUNC)) {
+        overlay->data.clear();
+    }
+
+    *file = std::make_unique<VfsFile>(path, node, std::move(overlay), readable, writable, (flags & O_APPEND) != 0);
+    return 0;
+}
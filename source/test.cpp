@@ -0,0 +1,712 @@
+#include "rvi_json.hpp"
+#include "rvi_session.hpp"
+#include "rvi_thread_pool.hpp"
+#include "rvi_vfs.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace rvi;
+
+namespace {
+
+constexpr size_t kTarBlock = 512u;
+
+// A file or directory in the system temporary directory, removed with it.
+class TempPath {
+    std::filesystem::path path_;
+
+public:
+    TempPath() {
+        std::string pattern = (std::filesystem::temp_directory_path() / "rvi-test-XXXXXX").string();
+        const int fd = mkstemp(pattern.data());
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create a temporary file");
+        }
+        close(fd);
+        path_ = pattern;
+    }
+    ~TempPath() {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+    }
+
+    TempPath(const TempPath&) = delete;
+    TempPath& operator=(const TempPath&) = delete;
+
+    const std::filesystem::path& Path() const noexcept { return path_; }
+    std::string String() const { return path_.string(); }
+
+    void Write(std::span<const uint8_t> data) const {
+        std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+};
+
+std::vector<uint8_t> Bytes(std::string_view text) {
+    return {text.begin(), text.end()};
+}
+
+// Builds tar archives entry by entry, with ustar headers.
+class TarWriter {
+    std::vector<uint8_t> archive_;
+
+    static void Put(std::vector<uint8_t>* header, size_t offset, std::string_view value) {
+        std::copy(value.begin(), value.end(), header->begin() + static_cast<std::ptrdiff_t>(offset));
+    }
+
+    static std::string Octal(uint64_t value, int digits) {
+        char field[24];
+        std::snprintf(field, sizeof(field), "%0*llo", digits, static_cast<unsigned long long>(value));
+        return field;
+    }
+
+public:
+    // size overrides the size in the header, e.g. to truncate the archive.
+    TarWriter& Add(std::string_view name, char type, std::string_view data = {},
+                   std::string_view prefix = {}, int64_t size = -1) {
+        std::vector<uint8_t> header(kTarBlock, 0u);
+        Put(&header, 0u, name);
+        Put(&header, 100u, Octal(0644u, 7));
+        Put(&header, 124u, Octal(size < 0 ? data.size() : static_cast<uint64_t>(size), 11));
+        Put(&header, 136u, Octal(1700000000u, 11));
+        header[156] = static_cast<uint8_t>(type);
+        Put(&header, 257u, std::string_view("ustar\0" "00", 8u));
+        Put(&header, 345u, prefix);
+
+        uint64_t sum = 0u;
+        Put(&header, 148u, "        ");
+        for (const uint8_t byte : header) {
+            sum += byte;
+        }
+        Put(&header, 148u, Octal(sum, 6));
+        header[154] = 0u;
+
+        archive_.insert(archive_.end(), header.begin(), header.end());
+        archive_.insert(archive_.end(), data.begin(), data.end());
+        archive_.resize((archive_.size() + kTarBlock - 1u) / kTarBlock * kTarBlock);
+        return *this;
+    }
+
+    // A pax extended header naming the next entry.
+    TarWriter& AddPaxPath(std::string_view path) {
+        const std::string record = " path=" + std::string(path) + "\n";
+        size_t length = record.size() + 1u;
+        while (std::to_string(length).size() + record.size() != length) {
+            ++length;
+        }
+        return Add("PaxHeader", 'x', std::to_string(length) + record);
+    }
+
+    std::vector<uint8_t>& Archive() { return archive_; }
+
+    // Ends the archive and writes it to file.
+    void Finish(const TempPath& file) {
+        archive_.resize(archive_.size() + 2u * kTarBlock);
+        file.Write(archive_);
+    }
+};
+
+std::string Contents(VfsFile* file) {
+    std::vector<uint8_t> buffer(4096u);
+    const std::span<uint8_t> spans[] = {buffer};
+    const int64_t size = file->Read(spans);
+    return size < 0 ? "" : std::string(buffer.begin(), buffer.begin() + size);
+}
+
+int64_t WriteString(VfsFile* file, std::string_view text) {
+    const std::span<const uint8_t> spans[] = {{reinterpret_cast<const uint8_t*>(text.data()), text.size()}};
+    return file->Write(spans);
+}
+
+std::shared_ptr<const FsImage> LoadTar(TarWriter* tar, const TempPath& file) {
+    tar->Finish(file);
+    return FsImage::Load(file.String());
+}
+
+// /etc/motd holds "hello" and /data is an empty directory.
+std::shared_ptr<const FsImage> SmallImage(const TempPath& file) {
+    TarWriter tar;
+    tar.Add("etc/motd", '0', "hello").Add("data/", '5');
+    return LoadTar(&tar, file);
+}
+
+std::string ReadPath(Vfs* vfs, const std::string& path) {
+    std::unique_ptr<VfsFile> file;
+    if (vfs->Open(path, O_RDONLY, 0u, &file) != 0) {
+        return "<missing>";
+    }
+    return Contents(file.get());
+}
+
+// Writes "abcde" a byte per write(2), with a thousand-iteration loop
+// before each, and exits with 42.
+constexpr uint32_t kGuestCode[] = {
+    0x06100413u, // li s0, 'a'
+    0x06600493u, // li s1, 'f'
+    0x3e800293u, // loop: li t0, 1000
+    0xfff28293u, // spin: addi t0, t0, -1
+    0xfe029ee3u, // bnez t0, spin
+    0xff010113u, // addi sp, sp, -16
+    0x00810023u, // sb s0, 0(sp)
+    0x00100513u, // li a0, 1
+    0x00010593u, // mv a1, sp
+    0x00100613u, // li a2, 1
+    0x04000893u, // li a7, 64 (write)
+    0x00000073u, // ecall
+    0x01010113u, // addi sp, sp, 16
+    0x00140413u, // addi s0, s0, 1
+    0xfc9448e3u, // blt s0, s1, loop
+    0x02a00513u, // li a0, 42
+    0x05d00893u, // li a7, 93 (exit)
+    0x00000073u, // ecall
+};
+
+// mmaps a PROT_NONE page and loads from it.
+constexpr uint32_t kProtNoneLoadCode[] = {
+    0x00000513u, // li a0, 0
+    0x000015b7u, // lui a1, 1
+    0x00000613u, // li a2, 0 (PROT_NONE)
+    0x02200693u, // li a3, 0x22 (MAP_PRIVATE | MAP_ANONYMOUS)
+    0xfff00713u, // li a4, -1
+    0x00000793u, // li a5, 0
+    0x0de00893u, // li a7, 222 (mmap)
+    0x00000073u, // ecall
+    0x00052503u, // lw a0, 0(a0)
+    0x05d00893u, // li a7, 93 (exit)
+    0x00000073u, // ecall
+};
+constexpr uint32_t kProtNoneLoadPc = 0x10074u;
+
+// Loads from a page with a fused auipc+lw until the loop is hot, then
+// remaps the page without permissions and loads once more.
+constexpr uint32_t kFusedLoadCode[] = {
+    0x00020537u, // lui a0, 0x20
+    0x000015b7u, // lui a1, 1
+    0x00100613u, // li a2, 1 (PROT_READ)
+    0x03200693u, // li a3, 0x32 (MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS)
+    0xfff00713u, // li a4, -1
+    0x00000793u, // li a5, 0
+    0x0de00893u, // li a7, 222 (mmap)
+    0x00000073u, // ecall
+    0x02800413u, // li s0, 40
+    0x00010297u, // loop: auipc t0, 0x10
+    0xf882a503u, // lw a0, -0x78(t0), from 0x20000
+    0xfff40413u, // addi s0, s0, -1
+    0xfe041ae3u, // bnez s0, loop
+    0x00049e63u, // bnez s1, done
+    0x00100493u, // li s1, 1
+    0x00020537u, // lui a0, 0x20
+    0x00000613u, // li a2, 0 (PROT_NONE)
+    0x00000073u, // ecall
+    0x00100413u, // li s0, 1
+    0xfd9ff06fu, // j loop
+    0x05d00893u, // done: li a7, 93 (exit)
+    0x00000073u, // ecall
+};
+constexpr uint32_t kFusedLoadPc = 0x1007cu;
+
+// Jumps to the stack, which is not executable.
+constexpr uint32_t kStackJumpCode[] = {
+    0x00010067u, // jr sp
+};
+
+// A static executable of code in one segment with the ELF headers.
+void WriteGuest(const TempPath& path, std::span<const uint32_t> code = kGuestCode) {
+    constexpr uint32_t kBase = 0x10000u;
+    constexpr uint32_t kCodeOffset = sizeof(Elf32_Ehdr) + sizeof(Elf32_Phdr);
+
+    Elf32_Ehdr header{};
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS32;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_RISCV;
+    header.e_version = EV_CURRENT;
+    header.e_entry = kBase + kCodeOffset;
+    header.e_phoff = sizeof(Elf32_Ehdr);
+    header.e_ehsize = sizeof(Elf32_Ehdr);
+    header.e_phentsize = sizeof(Elf32_Phdr);
+    header.e_phnum = 1u;
+
+    Elf32_Phdr segment{};
+    segment.p_type = PT_LOAD;
+    segment.p_vaddr = kBase;
+    segment.p_paddr = kBase;
+    segment.p_filesz = kCodeOffset + static_cast<uint32_t>(code.size_bytes());
+    segment.p_memsz = segment.p_filesz;
+    segment.p_flags = PF_R | PF_X;
+    segment.p_align = 0x1000u;
+
+    std::vector<uint8_t> image(segment.p_filesz);
+    std::memcpy(image.data(), &header, sizeof(header));
+    std::memcpy(image.data() + sizeof(header), &segment, sizeof(segment));
+    std::memcpy(image.data() + kCodeOffset, code.data(), code.size_bytes());
+    path.Write(image);
+}
+
+// Sends the session's stdout to output.
+void Capture(Session* session, std::string* output) {
+    session->SetStdout([output](std::span<const uint8_t> data) { output->append(data.begin(), data.end()); });
+}
+
+// Runs the guest of WriteGuest for at most max_instructions, saves it to
+// checkpoint and returns what it wrote.
+std::string SaveGuest(const TempPath& guest, const TempPath& checkpoint, uint64_t max_instructions) {
+    std::string output;
+    Session session;
+    Capture(&session, &output);
+    session.Load(guest.String());
+    EXPECT_EQ(session.Run(max_instructions), Session::Status::Paused);
+    session.Save(checkpoint.String());
+    return output;
+}
+
+} // namespace
+
+TEST(FsImage, LoadsTarEntriesAndTheirParents) {
+    const TempPath file;
+    TarWriter tar;
+    tar.Add("motd", '0', "hello").Add("lib/", '5').Add("x.txt", '0', "prefixed", "usr/share");
+    const auto image = LoadTar(&tar, file);
+
+    const auto* motd = image->Find("/motd");
+    ASSERT_NE(motd, nullptr);
+    EXPECT_EQ(std::string(motd->data.begin(), motd->data.end()), "hello");
+    EXPECT_TRUE(S_ISREG(motd->mode));
+    EXPECT_EQ(motd->mode & 07777u, 0644u);
+    EXPECT_EQ(motd->mtime, 1700000000);
+
+    ASSERT_NE(image->Find("/lib"), nullptr);
+    EXPECT_TRUE(S_ISDIR(image->Find("/lib")->mode));
+
+    // The ustar prefix goes in front of the name, its directories are implied.
+    const auto* prefixed = image->Find("/usr/share/x.txt");
+    ASSERT_NE(prefixed, nullptr);
+    EXPECT_EQ(std::string(prefixed->data.begin(), prefixed->data.end()), "prefixed");
+    ASSERT_NE(image->Find("/usr"), nullptr);
+    EXPECT_TRUE(S_ISDIR(image->Find("/usr/share")->mode));
+    EXPECT_EQ(image->Find("/x.txt"), nullptr);
+}
+
+TEST(FsImage, GnuLongNameNamesTheNextEntry) {
+    const std::string name = "very/" + std::string(150u, 'n');
+    const TempPath file;
+    TarWriter tar;
+    tar.Add("././@LongLink", 'L', name + '\0').Add("short", '0', "long").Add("after", '0', "plain");
+    const auto image = LoadTar(&tar, file);
+
+    const auto* entry = image->Find("/" + name);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(std::string(entry->data.begin(), entry->data.end()), "long");
+    EXPECT_EQ(image->Find("/short"), nullptr);
+    EXPECT_NE(image->Find("/after"), nullptr);
+}
+
+TEST(FsImage, PaxPathNamesTheNextEntry) {
+    const TempPath file;
+    TarWriter tar;
+    tar.AddPaxPath("pax/dir/file.txt").Add("truncated-name", '0', "pax").Add("after", '0', "plain");
+    const auto image = LoadTar(&tar, file);
+
+    const auto* entry = image->Find("/pax/dir/file.txt");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(std::string(entry->data.begin(), entry->data.end()), "pax");
+    EXPECT_EQ(image->Find("/truncated-name"), nullptr);
+    EXPECT_NE(image->Find("/after"), nullptr);
+}
+
+TEST(FsImage, LaterEntriesReplaceEarlierOnes) {
+    const TempPath file;
+    TarWriter tar;
+    tar.Add("./a/../file", '0', "old").Add("file", '0', "new");
+    const auto image = LoadTar(&tar, file);
+
+    const auto* entry = image->Find("/file");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(std::string(entry->data.begin(), entry->data.end()), "new");
+}
+
+TEST(FsImage, RejectsBadChecksum) {
+    const TempPath file;
+    TarWriter tar;
+    tar.Add("file", '0', "data");
+    tar.Archive()[0] = 'g';
+    tar.Finish(file);
+    EXPECT_THROW(FsImage::Load(file.String()), std::runtime_error);
+}
+
+TEST(FsImage, RejectsTruncatedArchive) {
+    const TempPath file;
+    TarWriter tar;
+    tar.Add("file", '0', "data", {}, 100000);
+    tar.Finish(file);
+    EXPECT_THROW(FsImage::Load(file.String()), std::runtime_error);
+
+    // Archives are made of whole blocks.
+    TarWriter partial;
+    partial.Add("file", '0', "data");
+    partial.Archive().resize(kTarBlock + 100u);
+    file.Write(partial.Archive());
+    EXPECT_THROW(FsImage::Load(file.String()), std::runtime_error);
+}
+
+TEST(FsImage, LoadsDirectory) {
+    const TempPath root;
+    std::filesystem::remove(root.Path());
+    std::filesystem::create_directories(root.Path() / "sub");
+    std::ofstream(root.Path() / "sub" / "file") << "from disk";
+
+    const auto image = FsImage::Load(root.String());
+    ASSERT_NE(image->Find("/sub"), nullptr);
+    EXPECT_TRUE(S_ISDIR(image->Find("/sub")->mode));
+    const auto* entry = image->Find("/sub/file");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(std::string(entry->data.begin(), entry->data.end()), "from disk");
+
+    EXPECT_THROW(FsImage::Load((root.Path() / "missing").string()), std::runtime_error);
+}
+
+TEST(VfsResolve, NormalizesPaths) {
+    EXPECT_EQ(Vfs::Resolve("/", "a/b"), "/a/b");
+    EXPECT_EQ(Vfs::Resolve("/base/dir", "file"), "/base/dir/file");
+    EXPECT_EQ(Vfs::Resolve("/base/dir", "/abs//path/"), "/abs/path");
+    EXPECT_EQ(Vfs::Resolve("/base/dir", "./x/../../y"), "/base/y");
+    EXPECT_EQ(Vfs::Resolve("/", "../../.."), "/");
+    EXPECT_EQ(Vfs::Resolve("/a", ""), "/a");
+    EXPECT_EQ(Vfs::Resolve("/", "."), "/");
+}
+
+TEST(Vfs, WritesGoToAPrivateOverlay) {
+    const TempPath file;
+    const auto image = SmallImage(file);
+    Vfs writer;
+    Vfs reader;
+    writer.Mount(image);
+    reader.Mount(image);
+
+    std::unique_ptr<VfsFile> motd;
+    ASSERT_EQ(writer.Open("/etc/motd", O_RDWR, 0u, &motd), 0);
+    EXPECT_EQ(WriteString(motd.get(), "J"), 1);
+    EXPECT_EQ(ReadPath(&writer, "/etc/motd"), "Jello");
+
+    // Neither the image nor other instances see the copy.
+    EXPECT_EQ(ReadPath(&reader, "/etc/motd"), "hello");
+    const auto* node = image->Find("/etc/motd");
+    EXPECT_EQ(std::string(node->data.begin(), node->data.end()), "hello");
+
+    // Files opened for reading are served from the image.
+    std::unique_ptr<VfsFile> read_only;
+    ASSERT_EQ(reader.Open("/etc/motd", O_RDONLY, 0u, &read_only), 0);
+    EXPECT_EQ(read_only->Data().data(), node->data.data());
+    EXPECT_EQ(WriteString(read_only.get(), "x"), -EBADF);
+}
+
+TEST(Vfs, CreatesFilesInExistingDirectories) {
+    const TempPath file;
+    Vfs vfs;
+    vfs.Mount(SmallImage(file));
+
+    std::unique_ptr<VfsFile> created;
+    EXPECT_EQ(vfs.Open("/data/new", O_WRONLY, 0644u, &created), -ENOENT);
+    ASSERT_EQ(vfs.Open("/data/new", O_WRONLY | O_CREAT, 0640u, &created), 0);
+    EXPECT_EQ(WriteString(created.get(), "fresh"), 5);
+    EXPECT_EQ(ReadPath(&vfs, "/data/new"), "fresh");
+
+    struct stat st{};
+    created->Stat(&st);
+    EXPECT_EQ(st.st_mode, S_IFREG | 0640u);
+    EXPECT_EQ(st.st_size, 5);
+
+    EXPECT_EQ(vfs.Open("/missing/new", O_WRONLY | O_CREAT, 0644u, &created), -ENOENT);
+    EXPECT_EQ(vfs.Open("/etc/motd", O_WRONLY | O_CREAT | O_EXCL, 0644u, &created), -EEXIST);
+    EXPECT_EQ(vfs.Open("/data/new", O_WRONLY | O_CREAT | O_EXCL, 0644u, &created), -EEXIST);
+    EXPECT_EQ(vfs.Open("/data/other", O_WRONLY | O_CREAT | O_EXCL, 0644u, &created), 0);
+}
+
+TEST(Vfs, TruncatesAndAppends) {
+    const TempPath file;
+    Vfs vfs;
+    vfs.Mount(SmallImage(file));
+
+    std::unique_ptr<VfsFile> appended;
+    ASSERT_EQ(vfs.Open("/etc/motd", O_WRONLY | O_APPEND, 0u, &appended), 0);
+    EXPECT_EQ(appended->Seek(0, SEEK_SET), 0);
+    EXPECT_EQ(WriteString(appended.get(), " world"), 6);
+    EXPECT_EQ(ReadPath(&vfs, "/etc/motd"), "hello world");
+
+    std::unique_ptr<VfsFile> truncated;
+    ASSERT_EQ(vfs.Open("/etc/motd", O_RDWR | O_TRUNC, 0u, &truncated), 0);
+    EXPECT_EQ(truncated->Data().size(), 0u);
+    EXPECT_EQ(ReadPath(&vfs, "/etc/motd"), "");
+    EXPECT_EQ(WriteString(truncated.get(), "new"), 3);
+    EXPECT_EQ(truncated->Seek(0, SEEK_SET), 0);
+    EXPECT_EQ(Contents(truncated.get()), "new");
+}
+
+TEST(Vfs, EmptyWritesLeaveFilesAlone) {
+    const TempPath file;
+    Vfs vfs;
+    vfs.Mount(SmallImage(file));
+
+    std::unique_ptr<VfsFile> created;
+    ASSERT_EQ(vfs.Open("/data/empty", O_WRONLY | O_CREAT, 0644u, &created), 0);
+    EXPECT_EQ(WriteString(created.get(), ""), 0);
+    EXPECT_EQ(created->Seek(16, SEEK_SET), 16);
+    EXPECT_EQ(WriteString(created.get(), ""), 0);
+    EXPECT_EQ(created->Data().size(), 0u);
+    EXPECT_EQ(ReadPath(&vfs, "/data/empty"), "");
+}
+
+TEST(Vfs, RejectsMismatchedOpens) {
+    const TempPath file;
+    Vfs vfs;
+    vfs.Mount(SmallImage(file));
+
+    std::unique_ptr<VfsFile> opened;
+    EXPECT_EQ(vfs.Open("/missing", O_RDONLY, 0u, &opened), -ENOENT);
+    EXPECT_EQ(vfs.Open("/data", O_WRONLY, 0u, &opened), -EISDIR);
+    EXPECT_EQ(vfs.Open("/etc/motd", O_RDONLY | O_DIRECTORY, 0u, &opened), -ENOTDIR);
+
+    ASSERT_EQ(vfs.Open("/data", O_RDONLY | O_DIRECTORY, 0u, &opened), 0);
+    EXPECT_TRUE(opened->IsDirectory());
+    EXPECT_EQ(Contents(opened.get()), "");
+    const std::span<uint8_t> none[] = {std::span<uint8_t>{}};
+    EXPECT_EQ(opened->Read(none), -EISDIR);
+
+    std::unique_ptr<VfsFile> write_only;
+    ASSERT_EQ(vfs.Open("/etc/motd", O_WRONLY, 0u, &write_only), 0);
+    std::vector<uint8_t> buffer(8u);
+    const std::span<uint8_t> spans[] = {buffer};
+    EXPECT_EQ(write_only->Read(spans), -EBADF);
+}
+
+TEST(ThreadPool, RunsEveryTaskOnce) {
+    ThreadPool pool(4u);
+    EXPECT_EQ(pool.Threads(), 4u);
+
+    std::vector<std::atomic<int>> runs(1000u);
+    pool.Run(runs.size(), [&](size_t i) { ++runs[i]; });
+    for (const auto& count : runs) {
+        EXPECT_EQ(count.load(), 1);
+    }
+
+    pool.Run(0u, [](size_t) { FAIL() << "no tasks to run"; });
+    EXPECT_GE(ThreadPool(0u).Threads(), 1u);
+}
+
+TEST(ThreadPool, StealsFromBusyWorkers) {
+    // Task 0 blocks its worker until every other task ran, which only
+    // happens if the others take the tasks queued behind it.
+    ThreadPool pool(2u);
+    constexpr size_t kTasks = 64u;
+    std::atomic<size_t> done = 0u;
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    pool.Run(kTasks, [&](size_t i) {
+        {
+            std::lock_guard lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+        if (i == 0u) {
+            while (done.load() != kTasks - 1u) {
+                std::this_thread::yield();
+            }
+        }
+        ++done;
+    });
+    EXPECT_EQ(done.load(), kTasks);
+    EXPECT_EQ(threads.size(), 2u);
+}
+
+TEST(ThreadPool, RethrowsAfterRunningTheRest) {
+    ThreadPool pool(3u);
+    std::atomic<size_t> runs = 0u;
+    EXPECT_THROW(pool.Run(100u,
+                          [&](size_t i) {
+                              ++runs;
+                              if (i % 10u == 3u) {
+                                  throw std::runtime_error("task " + std::to_string(i));
+                              }
+                          }),
+                 std::runtime_error);
+    EXPECT_EQ(runs.load(), 100u);
+}
+
+TEST(Json, ParsesDocuments) {
+    const Json json = Json::Parse(R"( {"name": "case", "args": ["-v", ""], "exit_code": -1.5e1,
+                                       "flags": [true, false, null], "nested": {"empty": {}, "list": []}} )");
+    ASSERT_NE(json.AsObject(), nullptr);
+    EXPECT_EQ(*json.Find("name")->AsString(), "case");
+    const Json::Array& args = *json.Find("args")->AsArray();
+    ASSERT_EQ(args.size(), 2u);
+    EXPECT_EQ(*args[0].AsString(), "-v");
+    EXPECT_EQ(*args[1].AsString(), "");
+    EXPECT_EQ(*json.Find("exit_code")->AsNumber(), -15.0);
+
+    const Json::Array& flags = *json.Find("flags")->AsArray();
+    ASSERT_EQ(flags.size(), 3u);
+    EXPECT_TRUE(*flags[0].AsBool());
+    EXPECT_FALSE(*flags[1].AsBool());
+    EXPECT_EQ(flags[2].AsBool(), nullptr);
+    EXPECT_EQ(flags[2].AsObject(), nullptr);
+
+    const Json* nested = json.Find("nested");
+    EXPECT_TRUE(nested->Find("empty")->AsObject()->empty());
+    EXPECT_TRUE(nested->Find("list")->AsArray()->empty());
+    EXPECT_EQ(json.Find("missing"), nullptr);
+    EXPECT_EQ(args[0].Find("name"), nullptr);
+
+    // Members keep the document order.
+    EXPECT_EQ((*json.AsObject())[1].first, "args");
+}
+
+TEST(Json, DecodesEscapes) {
+    const Json json = Json::Parse(R"("a\"\\\/\b\f\n\r\t\u0041\u00e9\u20ac\ud83d\ude00")");
+    EXPECT_EQ(*json.AsString(), "a\"\\/\b\f\n\r\tA\u00e9\u20ac\U0001F600");
+}
+
+TEST(Json, RejectsMalformedText) {
+    for (const char* text : {"", "{", "[1,]", "{\"a\" 1}", "{a: 1}", "\"open", "\"\\x\"", "\"\\u12\"",
+                             "01x", "-", "tru", "[1] 2", "{\"a\": 1,}"}) {
+        EXPECT_THROW(Json::Parse(text), std::runtime_error) << text;
+    }
+
+    try {
+        Json::Parse("[1, 2, ?]");
+        FAIL() << "parsed";
+    } catch (const std::runtime_error& error) {
+        EXPECT_NE(std::string(error.what()).find("offset 7"), std::string::npos) << error.what();
+    }
+}
+
+TEST(Json, LimitsNesting) {
+    EXPECT_NO_THROW(Json::Parse(std::string(200u, '[') + std::string(200u, ']')));
+    EXPECT_THROW(Json::Parse(std::string(100000u, '[') + std::string(100000u, ']')), std::runtime_error);
+}
+
+TEST(Checkpoint, RestoredGuestContinuesWhereItStopped) {
+    const TempPath guest;
+    const TempPath checkpoint;
+    WriteGuest(guest);
+
+    for (const Engine engine : {Engine::Block, Engine::Threaded, Engine::Jit}) {
+        const std::string before = SaveGuest(guest, checkpoint, 5000u);
+        EXPECT_EQ(before, "ab");
+
+        Session::Options options{};
+        options.engine = engine;
+        std::string after;
+        Session session(options);
+        Capture(&session, &after);
+        session.Restore(checkpoint.String());
+        EXPECT_EQ(session.Run(), Session::Status::Exited);
+        EXPECT_EQ(session.ExitCode(), 42);
+        EXPECT_EQ(before + after, "abcde");
+    }
+}
+
+TEST(Checkpoint, RejectsCorruptFiles) {
+    const TempPath guest;
+    const TempPath checkpoint;
+    WriteGuest(guest);
+    SaveGuest(guest, checkpoint, 5000u);
+
+    std::ifstream file(checkpoint.Path(), std::ios::binary);
+    const std::vector<uint8_t> saved{std::istreambuf_iterator<char>(file), {}};
+    ASSERT_GT(saved.size(), 4096u);
+
+    auto restore = [&](const std::vector<uint8_t>& data) {
+        checkpoint.Write(data);
+        Session session;
+        session.Restore(checkpoint.String());
+    };
+    EXPECT_NO_THROW(restore(saved));
+
+    std::vector<uint8_t> bad_magic = saved;
+    bad_magic[0] = 'X';
+    EXPECT_THROW(restore(bad_magic), std::runtime_error);
+
+    // The header's status field follows the magic and five 32-bit fields.
+    std::vector<uint8_t> bad_status = saved;
+    bad_status[28] = 3u;
+    EXPECT_THROW(restore(bad_status), std::runtime_error);
+
+    for (const size_t size : {size_t{0u}, size_t{100u}, saved.size() - 4096u, saved.size() - 1u}) {
+        const std::vector<uint8_t> truncated(saved.begin(), saved.begin() + static_cast<std::ptrdiff_t>(size));
+        EXPECT_THROW(restore(truncated), std::runtime_error) << size;
+    }
+}
+
+TEST(Session, PermissionViolationsAreGuestFaults) {
+    const TempPath guest;
+    WriteGuest(guest, kProtNoneLoadCode);
+
+    for (const Engine engine : {Engine::Block, Engine::Threaded, Engine::Jit}) {
+        Session::Options options{};
+        options.engine = engine;
+        options.safe = true;
+        Session session(options);
+        session.Load(guest.String());
+        EXPECT_EQ(session.Run(), Session::Status::Faulted);
+        EXPECT_EQ(session.ExitCode(), Session::kFaultExitCode);
+        EXPECT_EQ(session.GetFault().pc, kProtNoneLoadPc);
+    }
+}
+
+TEST(Session, FusedLoadFaultsAtTheLoad) {
+    const TempPath guest;
+    WriteGuest(guest, kFusedLoadCode);
+
+    for (const Engine engine : {Engine::Block, Engine::Threaded, Engine::Jit}) {
+        Session::Options options{};
+        options.engine = engine;
+        options.safe = true;
+        Session session(options);
+        session.Load(guest.String());
+        EXPECT_EQ(session.Run(), Session::Status::Faulted);
+        EXPECT_EQ(session.GetFault().address, 0x20000u);
+        EXPECT_EQ(session.GetFault().pc, kFusedLoadPc);
+    }
+}
+
+#ifdef RVI_PAGED_MEMORY
+// Flat memory has no execute permission to check.
+TEST(Session, JumpsToDataAreGuestFaults) {
+    const TempPath guest;
+    WriteGuest(guest, kStackJumpCode);
+
+    for (const Engine engine : {Engine::Block, Engine::Threaded, Engine::Jit}) {
+        Session::Options options{};
+        options.engine = engine;
+        Session session(options);
+        session.Load(guest.String());
+        EXPECT_EQ(session.Run(), Session::Status::Faulted);
+        EXPECT_EQ(session.ExitCode(), Session::kFaultExitCode);
+        EXPECT_EQ(session.GetFault().pc, session.GetFault().address);
+    }
+}
+#endif
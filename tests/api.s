@@ -1,6 +1,7 @@
 .global read
 .global write
 .global exit
+.global syscall
 .global _start
 .section .text
 
@@ -18,6 +19,12 @@ exit:
 li a7, 93
 ecall
 
+# syscall(a0, ..., a5, number)
+syscall:
+mv a7, a6
+ecall
+ret
+
 _start:
      # passing argc, argv[]
 lw a0, 0(sp)
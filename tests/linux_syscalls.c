@@ -0,0 +1,119 @@
+#include "test_io.h"
+
+extern long syscall(long a0, long a1, long a2, long a3, long a4, long a5, long number);
+
+#define SYS_OPENAT          56
+#define SYS_CLOSE           57
+#define SYS_LSEEK           62
+#define SYS_READV           65
+#define SYS_WRITEV          66
+#define SYS_FSTAT           80
+#define SYS_EXIT_GROUP      94
+#define SYS_CLOCK_GETTIME   113
+#define SYS_GETTIMEOFDAY    169
+#define SYS_BRK             214
+#define SYS_MUNMAP          215
+#define SYS_MMAP            222
+
+#define AT_FDCWD            (-100)
+#define SEEK_END            2
+#define PROT_READ_WRITE     3
+#define MAP_PRIVATE_ANON    0x22
+#define CLOCK_MONOTONIC     1
+
+#define ENOENT              2
+#define EBADF               9
+#define ENOSYS              38
+
+struct Iovec {
+    const void* base;
+    uint32_t    len;
+};
+
+struct Output {
+    uint8_t  magic[4];
+    uint32_t passed;
+};
+
+static uint32_t stat_buf[32];
+static uint32_t time_buf[4];
+
+static long sys(long number, long a0, long a1, long a2)
+{
+    return syscall(a0, a1, a2, 0, 0, 0, number);
+}
+
+static uint32_t check_heap(void)
+{
+    long start = sys(SYS_BRK, 0, 0, 0);
+    long end = sys(SYS_BRK, start + 65536, 0, 0);
+    if (start == 0 || end != start + 65536) {
+        return 0;
+    }
+
+    volatile uint8_t* heap = (volatile uint8_t*)start;
+    for (int i = 0; i < 65536; i += 4096) {
+        heap[i] = (uint8_t)i;
+    }
+    return heap[65536 - 4096] == (uint8_t)(65536 - 4096);
+}
+
+static uint32_t check_mmap(void)
+{
+    long addr = syscall(0, 3 * 4096, PROT_READ_WRITE, MAP_PRIVATE_ANON, -1, 0, SYS_MMAP);
+    if ((unsigned long)addr >= (unsigned long)-4096) {
+        return 0;
+    }
+
+    volatile uint32_t* words = (volatile uint32_t*)addr;
+    if (words[1024] != 0) {
+        return 0;
+    }
+    words[1024] = 0x12345678u;
+    if (words[1024] != 0x12345678u) {
+        return 0;
+    }
+    return sys(SYS_MUNMAP, addr, 3 * 4096, 0) == 0;
+}
+
+int main(void)
+{
+    struct Output out = { { 0, 0, 0, 0 }, 0 };
+    uint32_t bit = 0;
+
+    out.passed |= check_heap() << bit++;
+    out.passed |= check_mmap() << bit++;
+
+    // The test reads its own binary.
+    long fd = sys(SYS_OPENAT, AT_FDCWD, (long)"linux_syscalls", 0);
+    out.passed |= (uint32_t)(fd == 3) << bit++;
+
+    struct Iovec in_iov = { out.magic, sizeof(out.magic) };
+    out.passed |= (uint32_t)(sys(SYS_READV, fd, (long)&in_iov, 1) == 4) << bit++;
+
+    long size = sys(SYS_LSEEK, fd, 0, SEEK_END);
+    long stat_result = sys(SYS_FSTAT, fd, (long)stat_buf, 0);
+    // st_size is at byte 48.
+    out.passed |= (uint32_t)(size > 0 && stat_result == 0 && (long)stat_buf[12] == size) << bit++;
+
+    out.passed |= (uint32_t)(sys(SYS_CLOSE, fd, 0, 0) == 0) << bit++;
+    out.passed |= (uint32_t)(sys(SYS_CLOSE, fd, 0, 0) == -EBADF) << bit++;
+    out.passed |= (uint32_t)(sys(SYS_OPENAT, AT_FDCWD, (long)"no_such_file", 0) == -ENOENT) << bit++;
+
+    long clock_result = sys(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, (long)time_buf, 0);
+    out.passed |= (uint32_t)(clock_result == 0 && time_buf[2] < 1000000000u) << bit++;
+
+    long tod_result = sys(SYS_GETTIMEOFDAY, (long)time_buf, 0, 0);
+    out.passed |= (uint32_t)(tod_result == 0 && time_buf[0] > 1600000000u && time_buf[2] < 1000000u) << bit++;
+
+    out.passed |= (uint32_t)(sys(4000, 0, 0, 0) == -ENOSYS) << bit++;
+
+    struct Iovec out_iov[2] = {
+        { out.magic, sizeof(out.magic) },
+        { &out.passed, sizeof(out.passed) },
+    };
+    sys(SYS_WRITEV, 1, (long)out_iov, 2);
+
+    syscall(0, 0, 0, 0, 0, 0, SYS_EXIT_GROUP);
+    return 1;
+}
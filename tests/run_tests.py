@@ -5,11 +5,12 @@ import subprocess
 import sys
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Iterable, List, Tuple
+from typing import Iterable, List, Optional, Tuple
 
 BASE_DIR = Path(__file__).resolve().parent
 CASE_DIR = BASE_DIR / "cases"
 LOG_DIR = BASE_DIR / "logs"
+ENGINES = ("block", "threaded", "jit")
 
 GREEN = "\033[32m"
 RED = "\033[31m"
@@ -19,9 +20,12 @@ RESET = "\033[0m"
 @dataclass
 class Case:
     name: str
+    args: List[str]
     stdin: bytes
     stdout: bytes
     exit_code: int
+    harts: int
+    safe: bool
 
 
 @dataclass
@@ -72,9 +76,18 @@ def load_specs() -> List[Spec]:
             name = case.get("name")
             if not isinstance(name, str) or not name:
                 raise SystemExit(f"{json_path}: case #{idx} is missing a name")
+            args = case.get("args", [])
+            if not isinstance(args, list) or not all(isinstance(a, str) for a in args):
+                raise SystemExit(f"{json_path}::{name} 'args' must be a list of strings")
             stdin_hex = case.get("stdin_hex", "")
             stdout_hex = case.get("stdout_hex", "")
             exit_code = int(case.get("exit_code", 0))
+            harts = case.get("harts", 1)
+            if not isinstance(harts, int) or harts < 1:
+                raise SystemExit(f"{json_path}::{name} 'harts' must be a positive integer")
+            safe = case.get("safe", False)
+            if not isinstance(safe, bool):
+                raise SystemExit(f"{json_path}::{name} 'safe' must be true or false")
             stdin_bytes = decode_hex(
                 str(stdin_hex), context=f"{json_path}::{name} stdin_hex"
             )
@@ -84,9 +97,12 @@ def load_specs() -> List[Spec]:
             cases.append(
                 Case(
                     name=name,
+                    args=args,
                     stdin=stdin_bytes,
                     stdout=stdout_bytes,
                     exit_code=exit_code,
+                    harts=harts,
+                    safe=safe,
                 )
             )
 
@@ -113,10 +129,15 @@ def save_failure_logs(binary: str, case: str, stdout: bytes, stderr: bytes) -> N
 
 
 def run_case(
-    rvi: Path, binary_path: Path, case: Case
+    rvi: Path, binary_path: Path, case: Case, engine: Optional[str]
 ) -> Tuple[bool, List[str], bytes, bytes, int]:
+    rvi_options = ["--engine", engine] if engine else []
+    if case.harts > 1:
+        rvi_options += ["--harts", str(case.harts)]
+    if case.safe:
+        rvi_options.append("--safe")
     proc = subprocess.run(
-        [str(rvi), str(binary_path)],
+        [str(rvi), *rvi_options, str(binary_path), "--", *case.args],
         input=case.stdin,
         stdout=subprocess.PIPE,
         stderr=subprocess.PIPE,
@@ -135,6 +156,13 @@ def run_case(
 
 
 def main() -> int:
+    # Passed to rvi as --engine only if set, so other interpreters given by
+    # RVI still work.
+    engine = os.environ.get("RVI_ENGINE") or None
+    if engine is not None and engine not in ENGINES:
+        print(f"RVI_ENGINE must be one of {', '.join(ENGINES)}", file=sys.stderr)
+        return 1
+
     specs = load_specs()
     build_binaries(spec.binary for spec in specs)
 
@@ -145,6 +173,7 @@ def main() -> int:
 
     total_cases = 0
     failures = 0
+    skipped = 0
 
     for spec in specs:
         binary_path = BASE_DIR / spec.binary
@@ -156,8 +185,12 @@ def main() -> int:
         print(f"\n== {spec.binary} ({spec.path.name}) ==")
         for case in spec.cases:
             total_cases += 1
+            if engine == "jit" and case.harts > 1:
+                skipped += 1
+                print(f"[SKIP] {case.name} (the jit engine runs a single hart)")
+                continue
             ok, issues, stdout, stderr, exit_code = run_case(
-                rvi_path, binary_path, case
+                rvi_path, binary_path, case, engine
             )
             if ok:
                 print(f"[{GREEN}OK{RESET}]   {case.name}")
@@ -172,6 +205,8 @@ def main() -> int:
     print("\nSummary:")
     print(f"  Total cases: {total_cases}")
     print(f"  Failures:    {failures}")
+    if skipped:
+        print(f"  Skipped:     {skipped}")
     if failures:
         print(f"  Logs:        {LOG_DIR}")
 
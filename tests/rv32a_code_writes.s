@@ -0,0 +1,69 @@
+# Hart 1 rewrites an instruction of patched after hart 0 ran it, then tells
+# hart 0, which has to run the new instruction. Exits with 10 times what
+# patched returned before the write plus what it returned after: 12.
+.global hart_start
+.global main
+.section .text
+
+hart_start:
+    bnez a0, 1f
+    j _start
+1:
+    li t0, 1
+    bne a0, t0, 3f
+
+    la t0, ran
+2:
+    lw t1, 0(t0)
+    beqz t1, 2b
+    fence rw, rw
+
+    la t0, patched
+    li t1, 0x00200513 # li a0, 2
+    sw t1, 0(t0)
+    # Other harts see a code write once the writing hart's block ends, so
+    # the flag is stored after a jump.
+    j 4f
+4:
+    fence rw, rw
+    la t0, written
+    li t1, 1
+    sw t1, 0(t0)
+3:
+    li a0, 0
+    j exit
+
+main:
+    addi sp, sp, -16
+    sw ra, 12(sp)
+    sw s0, 8(sp)
+
+    call patched
+    li t0, 10
+    mul s0, a0, t0
+    fence rw, rw
+    la t0, ran
+    li t1, 1
+    sw t1, 0(t0)
+
+    la t0, written
+1:
+    lw t1, 0(t0)
+    beqz t1, 1b
+    fence rw, rw
+
+    call patched
+    add a0, a0, s0
+    lw ra, 12(sp)
+    lw s0, 8(sp)
+    addi sp, sp, 16
+    ret
+
+patched:
+    li a0, 1
+    ret
+
+.section .bss
+.align 2
+ran:     .space 4
+written: .space 4
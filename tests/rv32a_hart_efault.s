@@ -0,0 +1,37 @@
+# Under rvi --safe --harts 2, hart 1 hands write(2) a buffer the guest has
+# not mapped while hart 0 waits for it. The write has to fail with EFAULT
+# like on Linux, not fault on the host with the harts' syscall lock held.
+# Exits with the errno hart 1 got, 255 if the write succeeded.
+.global hart_start
+.global main
+.section .text
+
+hart_start:
+    bnez a0, 1f
+    j _start
+1:
+    li a0, 1
+    li a1, 0x20000000
+    li a2, 16
+    call write
+    neg a0, a0
+    bgtz a0, 2f
+    li a0, 255
+2:
+    fence rw, rw
+    la t0, result
+    sw a0, 0(t0)
+    li a0, 0
+    j exit
+
+main:
+    la t0, result
+1:
+    lw a0, 0(t0)
+    beqz a0, 1b
+    fence rw, rw
+    ret
+
+.section .bss
+.align 2
+result: .space 4
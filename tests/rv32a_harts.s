@@ -0,0 +1,271 @@
+# Harts synchronizing with the A extension (rvi --harts). stdin holds
+#   harts, iterations, amo_init, amo_operand
+# as 32-bit words: the --harts the case runs with, the iterations of every
+# loop below per hart, and the operands of the amo<op>.w checks. stdout gets
+#   amo[9]      amo_init after amo<op>.w amo_operand, in the order of main
+#   sc_success  sc.w right after lr.w
+#   sc_failure  sc.w without a reservation
+#   added       amoadd.w by every hart
+#   exchanged   lr.w/sc.w increments by every hart
+#   locked      plain increments under an amoswap.w lock by every hart
+#   received    sum of the values hart 1 sent hart 0 one at a time
+.global hart_start
+.global main
+.section .text
+
+# Every hart enters here with its id in a0 and a stack of its own. Hart 0
+# runs the usual start-up code and main, the others hart_main.
+hart_start:
+    bnez a0, 1f
+    j _start
+1:
+    call hart_main
+    j exit
+
+# hart_main(id)
+hart_main:
+    addi sp, sp, -16
+    sw ra, 12(sp)
+    sw s0, 8(sp)
+    sw s1, 4(sp)
+    sw s2, 0(sp)
+    mv s0, a0
+
+    la t0, started
+1:
+    lw t1, 0(t0)
+    beqz t1, 1b
+    fence rw, rw
+
+    call count
+    li t0, 1
+    bne s0, t0, 3f
+
+    # Hart 1 sends 1 to iterations to hart 0.
+    li s1, 1
+    la t0, input
+    lw s2, 4(t0)
+2:
+    bgtu s1, s2, 3f
+    mv a0, s1
+    call send
+    addi s1, s1, 1
+    j 2b
+
+3:
+    la t0, finished
+    li t1, 1
+    amoadd.w zero, t1, (t0)
+
+    li a0, 0
+    lw ra, 12(sp)
+    lw s0, 8(sp)
+    lw s1, 4(sp)
+    lw s2, 0(sp)
+    addi sp, sp, 16
+    ret
+
+# Adds iterations to added, exchanged and locked, each its own way.
+count:
+    la t0, input
+    lw t1, 4(t0)
+    la t2, added
+    la t3, exchanged
+    la t4, lock
+    la t5, locked
+    li t6, 1
+    beqz t1, 4f
+1:
+    amoadd.w zero, t6, (t2)
+
+2:
+    lr.w a0, (t3)
+    addi a0, a0, 1
+    sc.w a1, a0, (t3)
+    bnez a1, 2b
+
+3:
+    amoswap.w.aqrl a0, t6, (t4)
+    bnez a0, 3b
+    lw a0, 0(t5)
+    addi a0, a0, 1
+    sw a0, 0(t5)
+    fence rw, rw
+    sw zero, 0(t4)
+
+    addi t1, t1, -1
+    bnez t1, 1b
+4:
+    ret
+
+# send(value): waits for the mailbox to be empty and fills it.
+send:
+    la t0, mailbox_full
+1:
+    lw t1, 0(t0)
+    bnez t1, 1b
+    la t2, mailbox
+    sw a0, 0(t2)
+    fence rw, rw
+    li t1, 1
+    sw t1, 0(t0)
+    ret
+
+# receive(): waits for the mailbox to be full and empties it.
+receive:
+    la t0, mailbox_full
+1:
+    lw t1, 0(t0)
+    beqz t1, 1b
+    fence rw, rw
+    la t2, mailbox
+    lw a0, 0(t2)
+    fence rw, rw
+    sw zero, 0(t0)
+    ret
+
+# Stores amo_init after \op amo_operand at output + \offset; exits with 2 if
+# \op does not return amo_init.
+.macro APPLY op, offset
+    la t0, input
+    lw t1, 8(t0)
+    lw t2, 12(t0)
+    sw t1, 0(sp)
+    \op t3, t2, (sp)
+    bne t3, t1, bad_amo
+    lw t3, 0(sp)
+    la t0, output
+    sw t3, \offset(t0)
+.endm
+
+# The amo<op>.w and sc.w checks work on the word at 0(sp).
+main:
+    addi sp, sp, -32
+    sw ra, 28(sp)
+    sw s0, 24(sp)
+    sw s1, 20(sp)
+    sw s2, 16(sp)
+
+    # Read the whole input, or return 1.
+    li s0, 0
+1:
+    li a0, 0
+    la a1, input
+    add a1, a1, s0
+    li a2, 16
+    sub a2, a2, s0
+    call read
+    blez a0, fail
+    add s0, s0, a0
+    li t0, 16
+    bltu s0, t0, 1b
+
+    la t0, input
+    lw t1, 0(t0)
+    li t2, 2
+    bltu t1, t2, fail
+
+    fence rw, rw
+    la t0, started
+    li t1, 1
+    sw t1, 0(t0)
+
+    APPLY amoswap.w, 0
+    APPLY amoadd.w, 4
+    APPLY amoxor.w, 8
+    APPLY amoand.w, 12
+    APPLY amoor.w, 16
+    APPLY amomin.w, 20
+    APPLY amomax.w, 24
+    APPLY amominu.w, 28
+    APPLY amomaxu.w, 32
+
+    la t0, output
+    sw zero, 0(sp)
+    lr.w t1, (sp)
+    li t1, 1
+    sc.w t2, t1, (sp)
+    sw t2, 36(t0)
+    li t1, 2
+    sc.w t2, t1, (sp)
+    sw t2, 40(t0)
+
+    call count
+
+    li s0, 0
+    li s1, 1
+    la t0, input
+    lw s2, 4(t0)
+2:
+    bgtu s1, s2, 3f
+    call receive
+    add s0, s0, a0
+    addi s1, s1, 1
+    j 2b
+3:
+    la t0, output
+    sw s0, 56(t0)
+
+    # Wait for the other harts to finish counting.
+    la t0, input
+    lw t1, 0(t0)
+    addi t1, t1, -1
+    la t2, finished
+4:
+    lw t3, 0(t2)
+    bne t3, t1, 4b
+    fence rw, rw
+
+    la t0, output
+    la t1, added
+    lw t1, 0(t1)
+    sw t1, 44(t0)
+    la t1, exchanged
+    lw t1, 0(t1)
+    sw t1, 48(t0)
+    la t1, locked
+    lw t1, 0(t1)
+    sw t1, 52(t0)
+
+    # Write the whole output, or exit with 1.
+    li s0, 0
+5:
+    li a0, 1
+    la a1, output
+    add a1, a1, s0
+    li a2, 60
+    sub a2, a2, s0
+    call write
+    blez a0, fail
+    add s0, s0, a0
+    li t0, 60
+    bltu s0, t0, 5b
+
+    li a0, 0
+    j 6f
+fail:
+    li a0, 1
+6:
+    lw ra, 28(sp)
+    lw s0, 24(sp)
+    lw s1, 20(sp)
+    lw s2, 16(sp)
+    addi sp, sp, 32
+    ret
+
+bad_amo:
+    li a0, 2
+    j exit
+
+.section .bss
+.align 2
+input:        .space 16
+output:       .space 60
+started:      .space 4
+finished:     .space 4
+added:        .space 4
+exchanged:    .space 4
+locked:       .space 4
+lock:         .space 4
+mailbox:      .space 4
+mailbox_full: .space 4
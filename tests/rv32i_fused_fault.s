@@ -0,0 +1,49 @@
+# Loads a word with a fused auipc+lw until the block is hot, then maps its
+# page without permissions and loads it again. Run with --safe, the last load
+# faults at the lw: exit code 139. Exits with 1 if the mmap fails and with 2
+# if the last load does not fault.
+.global main
+.section .text
+
+main:
+    addi sp, sp, -16
+    sw ra, 12(sp)
+    sw s0, 8(sp)
+
+    li s0, 100
+1:
+    call load
+    addi s0, s0, -1
+    bnez s0, 1b
+
+    # mmap(target, 4096, PROT_NONE, MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0)
+    la a0, target
+    li a1, 4096
+    li a2, 0
+    li a3, 0x32
+    li a4, -1
+    li a5, 0
+    li a6, 222
+    call syscall
+    la t0, target
+    li s0, 1
+    bne a0, t0, 2f
+
+    call load
+    li s0, 2
+2:
+    mv a0, s0
+    lw ra, 12(sp)
+    lw s0, 8(sp)
+    addi sp, sp, 16
+    ret
+
+load:
+1:
+    auipc t0, %pcrel_hi(target)
+    lw a0, %pcrel_lo(1b)(t0)
+    ret
+
+.section .bss
+.align 12
+target: .space 4096
@@ -0,0 +1,83 @@
+# Runs a loop 80 times that goes through hop, a block of a single jump to
+# first, which adds 1 to a0. After 8 iterations first is rewritten to add 2,
+# so the jit translates hop well before first again. After 36 iterations,
+# with hop translated and its link to first still waiting, hop is rewritten
+# to jump to second, which adds 1 and goes on to first. Exits with
+# 8 + 28 * 2 + 44 * 3 = 196, or with 1 if the mmap fails.
+#
+# Loaded code is not writable with permissions, so the loop runs from a copy
+# in an anonymous page mapped RWX.
+.global main
+.section .text
+
+main:
+    addi sp, sp, -16
+    sw ra, 12(sp)
+
+    # mmap(NULL, 4096, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
+    li a0, 0
+    li a1, 4096
+    li a2, 7
+    li a3, 0x22
+    li a4, -1
+    li a5, 0
+    li a6, 222
+    call syscall
+    li t0, -4096
+    bgeu a0, t0, 2f
+
+    la t0, begin
+    la t1, end
+    mv t2, a0
+1:
+    lw t3, 0(t0)
+    sw t3, 0(t2)
+    addi t0, t0, 4
+    addi t2, t2, 4
+    bltu t0, t1, 1b
+    jalr a0
+    j 3f
+2:
+    li a0, 1
+3:
+    lw ra, 12(sp)
+    addi sp, sp, 16
+    ret
+
+# Position-independent, runs from the copy.
+begin:
+    li a0, 0
+    li s0, 0
+    la s1, first
+    li s2, 0x00250513 # addi a0, a0, 2
+
+loop:
+    addi s0, s0, 1
+    j hop
+hop:
+    j first
+second:
+    addi a0, a0, 1
+    j first
+first:
+    addi a0, a0, 1
+    li t0, 8
+    bne s0, t0, 1f
+    sw s2, 0(s1)
+1:
+    li t0, 36
+    bne s0, t0, 2f
+
+    # j second at hop: the offset is positive and below 2 KiB, so only its
+    # bits 10:1 go to bits 30:21 of the jal.
+    la t0, hop
+    la t1, second
+    sub t1, t1, t0
+    slli t1, t1, 20
+    ori t1, t1, 0x6f
+    sw t1, 0(t0)
+2:
+    li t0, 80
+    bltu s0, t0, loop
+    ret
+end:
@@ -0,0 +1,62 @@
+# Runs a loop 100 times that adds 1 to a0, and after 64 iterations, when
+# every engine has translated it, rewrites that add to add 2 from within
+# the loop. Exits with 64 + 36 * 2 = 136, or with 1 if the mmap fails.
+#
+# Loaded code is not writable with permissions, so the loop runs from a copy
+# in an anonymous page mapped RWX.
+.global main
+.section .text
+
+main:
+    addi sp, sp, -16
+    sw ra, 12(sp)
+
+    # mmap(NULL, 4096, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
+    li a0, 0
+    li a1, 4096
+    li a2, 7
+    li a3, 0x22
+    li a4, -1
+    li a5, 0
+    li a6, 222
+    call syscall
+    li t0, -4096
+    bgeu a0, t0, 2f
+
+    la t0, begin
+    la t1, end
+    mv t2, a0
+1:
+    lw t3, 0(t0)
+    sw t3, 0(t2)
+    addi t0, t0, 4
+    addi t2, t2, 4
+    bltu t0, t1, 1b
+    jalr a0
+    j 3f
+2:
+    li a0, 1
+3:
+    lw ra, 12(sp)
+    addi sp, sp, 16
+    ret
+
+# Position-independent, runs from the copy.
+begin:
+    li a0, 0
+    li s0, 0
+    la s1, patched
+    li s2, 0x00250513 # addi a0, a0, 2
+
+1:
+patched:
+    addi a0, a0, 1
+    addi s0, s0, 1
+    li t0, 64
+    bne s0, t0, 2f
+    sw s2, 0(s1)
+2:
+    li t0, 100
+    bltu s0, t0, 1b
+    ret
+end:
@@ -0,0 +1,48 @@
+#include "test_io.h"
+
+#define AT_NULL     0
+#define AT_PAGESZ   6
+#define AT_ENTRY    9
+#define AT_RANDOM   25
+
+extern void _start(void);
+
+static long length(const char* str)
+{
+    long len = 0;
+    while (str[len] != '\0') {
+        len++;
+    }
+    return len;
+}
+
+// Prints argv[1..] one per line, then a bitmask of the auxv entries found
+// with the expected values.
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        write_all(argv[i], length(argv[i]));
+        write_all("\n", 1);
+    }
+
+    char** envp = argv + argc + 1;
+    while (*envp != 0) {
+        envp++;
+    }
+
+    uint8_t found = 0;
+    for (const uint32_t* auxv = (const uint32_t*)(envp + 1); auxv[0] != AT_NULL; auxv += 2) {
+        if (auxv[0] == AT_PAGESZ && auxv[1] == 4096) {
+            found |= 1;
+        }
+        if (auxv[0] == AT_ENTRY && auxv[1] == (uint32_t)&_start) {
+            found |= 2;
+        }
+        if (auxv[0] == AT_RANDOM && auxv[1] != 0) {
+            found |= 4;
+        }
+    }
+    write_all(&found, 1);
+
+    return argc;
+}